@@ -0,0 +1,197 @@
+#pragma once
+
+// BenchmarkCommon.h: what the GL benchmarks share, so each one only keeps its own measurement. BenchmarkContext opens
+// the window and GL 3.3 core context they run in, OffscreenTarget is the framebuffer the image comparing and
+// GPU timing ones render into, and the Write* functions write the OBJ fixtures they load.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cmath>
+
+//GLEW
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+
+//Fixed size window, invisible unless asked, with a current GL 3.3 core context and no vsync. Declare it first in main:
+//it terminates GLFW when it goes out of scope, after every GL object declared later has been destroyed.
+class BenchmarkContext
+{
+public:
+	BenchmarkContext(GLint width, GLint height, const char *title, bool visible = false) : window(nullptr)
+	{
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+		glfwWindowHint(GLFW_VISIBLE, visible ? GL_TRUE : GL_FALSE);
+
+		this->window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+		if (nullptr == this->window)
+		{
+			std::cout << "Failed to create GLFW window" << std::endl;
+			return;
+		}
+
+		glfwMakeContextCurrent(this->window);
+		glfwSwapInterval(0);
+
+		glewExperimental = GL_TRUE;
+		if (GLEW_OK != glewInit())
+		{
+			std::cout << "Failed to initialize GLEW" << std::endl;
+			glfwDestroyWindow(this->window);
+			this->window = nullptr;
+		}
+	}
+
+	~BenchmarkContext()
+	{
+		glfwTerminate();
+	}
+
+	//False when the window or GLEW failed, the benchmark can't run then
+	bool IsValid() const
+	{
+		return nullptr != this->window;
+	}
+
+	GLFWwindow *GetWindow() const
+	{
+		return this->window;
+	}
+
+private:
+	GLFWwindow *window;
+
+	BenchmarkContext(const BenchmarkContext &);
+	BenchmarkContext &operator=(const BenchmarkContext &);
+};
+
+//Framebuffer with RGBA8 color and depth stencil renderbuffers, bound from construction until it is destroyed, so
+//timings and read backs don't depend on the window being visible
+class OffscreenTarget
+{
+public:
+	OffscreenTarget(GLint width, GLint height)
+	{
+		glGenFramebuffers(1, &this->framebuffer);
+		glGenRenderbuffers(1, &this->colorBuffer);
+		glGenRenderbuffers(1, &this->depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, this->colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, this->depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->colorBuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthBuffer);
+	}
+
+	~OffscreenTarget()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &this->framebuffer);
+		glDeleteRenderbuffers(1, &this->colorBuffer);
+		glDeleteRenderbuffers(1, &this->depthBuffer);
+	}
+
+private:
+	GLuint framebuffer, colorBuffer, depthBuffer;
+
+	OffscreenTarget(const OffscreenTarget &);
+	OffscreenTarget &operator=(const OffscreenTarget &);
+};
+
+//Appends an axis aligned box with flat normals to an OBJ, vertex numbering continues from vertex
+inline void WriteBox(std::ofstream &file, int &vertex, const glm::vec3 &center, const glm::vec3 &size)
+{
+	const glm::vec3 normals[6] = {
+		glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+	};
+	for (int face = 0; face < 6; face++)
+	{
+		glm::vec3 n = normals[face];
+		glm::vec3 u = (0.0f != n.y) ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+		glm::vec3 v = glm::cross(n, u);
+		glm::vec3 corners[4] = { n - u - v, n + u - v, n + u + v, n - u + v };
+		for (int i = 0; i < 4; i++)
+		{
+			glm::vec3 position = center + corners[i] * size * 0.5f;
+			file << "v " << position.x << " " << position.y << " " << position.z << "\n";
+			file << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+		}
+		//Counter clockwise seen from outside
+		file << "f";
+		for (int i = 0; i < 4; i++)
+		{
+			file << " " << vertex + i << "//" << vertex + i;
+		}
+		file << "\n";
+		vertex += 4;
+	}
+}
+
+//Appends a UV sphere with smooth normals to an OBJ, vertex numbering continues from vertex
+inline void WriteSphere(std::ofstream &file, int &vertex, const glm::vec3 &center, GLfloat radius)
+{
+	const int rings = 24, segments = 48;
+	for (int ring = 0; ring <= rings; ring++)
+	{
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			GLfloat phi = 3.14159265f * ring / rings, theta = 6.2831853f * segment / segments;
+			glm::vec3 normal(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+			glm::vec3 position = center + normal * radius;
+			file << "v " << position.x << " " << position.y << " " << position.z << "\n";
+			file << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+		}
+	}
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			int a = vertex + ring * (segments + 1) + segment, b = a + segments + 1;
+			file << "f " << a << "//" << a << " " << a + 1 << "//" << a + 1 << " " << b + 1 << "//" << b + 1 << " " << b << "//" << b << "\n";
+		}
+	}
+	vertex += (rings + 1) * (segments + 1);
+}
+
+//Writes an OBJ of one side x side vertex grid, a wavy surface with normals and texture coordinates
+inline void WriteGrid(const std::string &path, int side)
+{
+	std::ofstream file(path.c_str());
+	for (int y = 0; y < side; y++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			GLfloat u = (GLfloat)x / (side - 1), v = (GLfloat)y / (side - 1);
+			GLfloat height = 0.05f * std::sin(u * 20.0f) * std::cos(v * 20.0f);
+			file << "v " << u - 0.5f << " " << height << " " << v - 0.5f << "\n";
+			file << "vn " << -std::cos(u * 20.0f) * std::cos(v * 20.0f) << " 1 " << std::sin(u * 20.0f) * std::sin(v * 20.0f) << "\n";
+			file << "vt " << u * 4.0f << " " << v * 4.0f << "\n";
+		}
+	}
+	for (int y = 0; y + 1 < side; y++)
+	{
+		for (int x = 0; x + 1 < side; x++)
+		{
+			int corner = y * side + x + 1;
+			int quad[4] = { corner, corner + side, corner + side + 1, corner + 1 };
+			file << "f";
+			for (int i = 0; i < 4; i++)
+			{
+				file << " " << quad[i] << "/" << quad[i] << "/" << quad[i];
+			}
+			file << "\n";
+		}
+	}
+}
@@ -0,0 +1,169 @@
+// cameraBenchmark.cpp: moves and turns a Camera along a random walk and checks, every step, that its cached view,
+// projection, view projection, inverse matrices and frustum planes match the ones computed from scratch (glm::lookAt,
+// glm::perspective, glm::inverse). The run fails when any of them is off by more than MAX_ERROR.
+// Then times a frame's worth of reads (culling, the frame uniform upload and picking each asking for the matrices)
+// with the cache against computing them on every read. No GL context is needed.
+//
+// Usage: cameraBenchmark [steps] [reads per frame]
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Camera.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const GLfloat ASPECT_RATIO = 16.0f / 9.0f;
+const GLfloat MAX_ERROR = 1e-4f;
+
+//Largest difference between two matrices, relative to the size of their elements
+GLfloat MatrixError(const glm::mat4 &a, const glm::mat4 &b)
+{
+	GLfloat error = 0.0f;
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			error = std::max(error, std::fabs(a[c][r] - b[c][r]) / std::max(1.0f, std::fabs(b[c][r])));
+		}
+	}
+	return error;
+}
+
+//The matrices of a camera computed from scratch, the way the demos did before the cache
+struct FreshMatrices
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::mat4 inverseViewProjection;
+	Frustum frustum;
+};
+
+FreshMatrices ComputeFresh(Camera &camera)
+{
+	FreshMatrices fresh;
+	glm::vec3 position = camera.GetPosition(), front = camera.GetFront();
+	glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+	glm::vec3 up = glm::normalize(glm::cross(right, front));
+	fresh.view = glm::lookAt(position, position + front, up);
+	fresh.projection = glm::perspective(glm::radians(camera.GetZoom()), ASPECT_RATIO, camera.GetNear(), camera.GetFar());
+	fresh.viewProjection = fresh.projection * fresh.view;
+	fresh.inverseView = glm::inverse(fresh.view);
+	fresh.inverseProjection = glm::inverse(fresh.projection);
+	fresh.inverseViewProjection = glm::inverse(fresh.viewProjection);
+	fresh.frustum = Frustum(fresh.viewProjection);
+	return fresh;
+}
+
+int main(int argc, char **argv)
+{
+	int steps = (argc > 1) ? std::max(1, atoi(argv[1])) : 100000;
+	int reads = (argc > 2) ? std::max(1, atoi(argv[2])) : 4;
+
+	Camera camera(glm::vec3(0.0f, 2.0f, 10.0f));
+	camera.SetProjection(ASPECT_RATIO, 0.1f, 500.0f);
+
+	std::mt19937 random(42);
+	std::uniform_int_distribution<int> action(0, 5);
+	std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+
+	// ===================
+	// Cached against fresh, after every move
+	// ===================
+	GLfloat errors[7] = { 0.0f };
+	for (int step = 0; step < steps; step++)
+	{
+		int move = action(random);
+		if (move < 4)
+		{
+			camera.ProcessKeyboard((Camera_Movement)move, 0.016f);
+		}
+		else if (4 == move)
+		{
+			camera.ProcessMouseMovement(offset(random), offset(random));
+		}
+		//else the camera stays put, the cache must keep the same values
+
+		FreshMatrices fresh = ComputeFresh(camera);
+		errors[0] = std::max(errors[0], MatrixError(camera.GetviewMatrix(), fresh.view));
+		errors[1] = std::max(errors[1], MatrixError(camera.GetProjectionMatrix(), fresh.projection));
+		errors[2] = std::max(errors[2], MatrixError(camera.GetViewProjectionMatrix(), fresh.viewProjection));
+		errors[3] = std::max(errors[3], MatrixError(camera.GetInverseViewMatrix(), fresh.inverseView));
+		errors[4] = std::max(errors[4], MatrixError(camera.GetInverseProjectionMatrix(), fresh.inverseProjection));
+		errors[5] = std::max(errors[5], MatrixError(camera.GetInverseViewProjectionMatrix(), fresh.inverseViewProjection));
+		const Frustum &frustum = camera.GetFrustum();
+		for (int i = 0; i < 6; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				errors[6] = std::max(errors[6], std::fabs(frustum.Planes[i][j] - fresh.frustum.Planes[i][j]) / std::max(1.0f, std::fabs(fresh.frustum.Planes[i][j])));
+			}
+		}
+	}
+
+	const char *names[7] = { "view", "projection", "view projection", "inverse view", "inverse projection", "inverse view projection", "frustum planes" };
+	bool failed = false;
+	std::cout << steps << " random camera steps, largest relative error of the cached values:" << std::endl;
+	for (int i = 0; i < 7; i++)
+	{
+		std::cout << "  " << names[i] << ": " << errors[i] << std::endl;
+		failed = failed || !(errors[i] <= MAX_ERROR);
+	}
+
+	// ===================
+	// Cost of the reads of a frame
+	// ===================
+	//A moving camera changes every other frame, the reads in between hit the cache
+	float checksum = 0.0f;
+	Clock::time_point start = Clock::now();
+	for (int frame = 0; frame < steps; frame++)
+	{
+		if (0 == frame % 2)
+		{
+			camera.ProcessMouseMovement(1.0f, 0.0f);
+		}
+		for (int read = 0; read < reads; read++)
+		{
+			checksum += camera.GetViewProjectionMatrix()[0][0] + camera.GetInverseViewProjectionMatrix()[3][0] + camera.GetFrustum().Planes[0].w;
+		}
+	}
+	double cachedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int frame = 0; frame < steps; frame++)
+	{
+		if (0 == frame % 2)
+		{
+			camera.ProcessMouseMovement(1.0f, 0.0f);
+		}
+		for (int read = 0; read < reads; read++)
+		{
+			FreshMatrices fresh = ComputeFresh(camera);
+			checksum += fresh.viewProjection[0][0] + fresh.inverseViewProjection[3][0] + fresh.frustum.Planes[0].w;
+		}
+	}
+	double freshMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	std::cout << steps << " frames of " << reads << " reads: cached " << cachedMs * 1000.0 / steps << " us per frame, computed on every read "
+		<< freshMs * 1000.0 / steps << " us per frame, " << freshMs / cachedMs << "x (checksum " << checksum << ")" << std::endl;
+
+	if (failed)
+	{
+		std::cout << "FAILED: the cached camera matrices differ from the ones computed from scratch" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
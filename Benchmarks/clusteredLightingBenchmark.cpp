@@ -0,0 +1,222 @@
+// clusteredLightingBenchmark.cpp: a field of instanced cubes lit by 1k and 4k moving point lights. For each light
+// count it times the CPU light assignment of LightClusters on one thread and on every hardware thread, and the GPU
+// time of a frame shaded with clustered.frag (each fragment walks its cluster's lights) and with unclustered.frag
+// (each fragment walks every light). GPU times come from GL_TIME_ELAPSED queries.
+//
+// Usage: clusteredLightingBenchmark [shader directory] [frames]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Instancing.h"
+#include "../ClusteredLights.h"
+#include "BenchmarkCommon.h"
+
+const GLint WIDTH = 1280, HEIGHT = 720;
+const int FIELD_SIDE = 100;
+const GLfloat FIELD_SPACING = 2.0f;
+
+//Lights scattered over the field, a little above the cubes
+void MakeLights(std::vector<PointLight> &lights, size_t count)
+{
+	srand(7);
+	lights.resize(count);
+	GLfloat extent = FIELD_SIDE * FIELD_SPACING * 0.5f;
+	for (size_t i = 0; i < count; i++)
+	{
+		lights[i].Position = glm::vec3(((rand() % 1000) / 500.0f - 1.0f) * extent, 0.5f + (rand() % 1000) / 400.0f, ((rand() % 1000) / 500.0f - 1.0f) * extent);
+		lights[i].Radius = 3.0f + (rand() % 1000) / 333.0f;
+		lights[i].Color = glm::vec3((rand() % 1000) / 1000.0f, (rand() % 1000) / 1000.0f, (rand() % 1000) / 1000.0f);
+		lights[i].Intensity = 1.0f;
+	}
+}
+
+//Moves the lights in small circles, so they have to be binned again every frame
+void MoveLights(const std::vector<PointLight> &rest, std::vector<PointLight> &lights, int frame)
+{
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		GLfloat angle = frame * 0.05f + i;
+		lights[i].Position = rest[i].Position + glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "res/shaders/";
+	int frames = (argc > 2) ? std::max(1, atoi(argv[2])) : 100;
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Clustered lighting benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	int screenWidth, screenHeight;
+	glfwGetFramebufferSize(context.GetWindow(), &screenWidth, &screenHeight);
+	glViewport(0, 0, screenWidth, screenHeight);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader clusteredShader((shaderDir + "instanced.vs").c_str(), (shaderDir + "clustered.frag").c_str());
+	Shader unclusteredShader((shaderDir + "instanced.vs").c_str(), (shaderDir + "unclustered.frag").c_str());
+
+	//Same cube as the lighting demo
+	GLfloat vertices[] = {
+		//Position			//Normals
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
+	};
+
+	GLuint VBO, boxVAO;
+	glGenVertexArrays(1, &boxVAO);
+	glGenBuffers(1, &VBO);
+	glBindVertexArray(boxVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+
+	//A flat field of cubes
+	InstanceBuffer cubes(boxVAO);
+	std::vector<glm::mat4> transforms(FIELD_SIDE * FIELD_SIDE);
+	std::vector<glm::vec4> colors(FIELD_SIDE * FIELD_SIDE, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+	for (int i = 0; i < FIELD_SIDE * FIELD_SIDE; i++)
+	{
+		glm::vec3 position(((i % FIELD_SIDE) - FIELD_SIDE * 0.5f) * FIELD_SPACING, 0.0f, ((i / FIELD_SIDE) - FIELD_SIDE * 0.5f) * FIELD_SPACING);
+		transforms[i] = glm::scale(glm::translate(glm::mat4(), position), glm::vec3(1.5f, 1.0f + (i % 7) * 0.2f, 1.5f));
+	}
+	cubes.Update(transforms, colors);
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 25.0f, FIELD_SIDE * FIELD_SPACING * 0.5f + 20.0f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)screenWidth / (GLfloat)screenHeight, 0.1f, 500.0f);
+	frameUniforms.Update(view, projection, cameraPos);
+
+	LightClusters serialClusters(1);
+	LightClusters clusters;
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	const size_t lightCounts[2] = { 1024, 4096 };
+	for (int test = 0; test < 2; test++)
+	{
+		std::vector<PointLight> rest, lights;
+		MakeLights(rest, lightCounts[test]);
+		lights = rest;
+
+		//CPU assignment, both binners get the same lights every frame
+		double serialMs = 0.0, parallelMs = 0.0;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			MoveLights(rest, lights, frame);
+			serialClusters.Update(lights, view, projection, screenWidth, screenHeight);
+			clusters.Update(lights, view, projection, screenWidth, screenHeight);
+			serialMs += serialClusters.GetStats().assignMs;
+			parallelMs += clusters.GetStats().assignMs;
+		}
+		ClusterStats stats = clusters.GetStats();
+
+		//Shaded frames, the clustered pass bins the lights every frame as a game would
+		double gpuMs[2] = { 0.0, 0.0 };
+		for (int pass = 0; pass < 2; pass++)
+		{
+			Shader &shader = (0 == pass) ? clusteredShader : unclusteredShader;
+			for (int frame = 0; frame < frames; frame++)
+			{
+				MoveLights(rest, lights, frame);
+				clusters.Update(lights, view, projection, screenWidth, screenHeight);
+
+				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				glBeginQuery(GL_TIME_ELAPSED, query);
+				shader.use();
+				clusters.Bind(shader);
+				cubes.DrawArrays(GL_TRIANGLES, 0, 36);
+				glEndQuery(GL_TIME_ELAPSED);
+
+				GLuint64 nanoseconds = 0;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+				gpuMs[pass] += nanoseconds / 1000000.0;
+
+				glfwSwapBuffers(context.GetWindow());
+			}
+		}
+
+		std::cout << lightCounts[test] << " lights: " << stats.visibleLights << " in view, " << stats.activeClusters << "/" << CLUSTER_COUNT << " clusters lit, "
+			<< (GLfloat)stats.lightReferences / std::max(1u, stats.activeClusters) << " lights per lit cluster (" << stats.maxClusterLights << " at most)" << std::endl;
+		std::cout << "  assignment: " << serialMs / frames << " ms on 1 thread, " << parallelMs / frames << " ms on " << std::max(1u, std::thread::hardware_concurrency())
+			<< " threads" << std::endl;
+		std::cout << "  GPU frame: " << gpuMs[0] / frames << " ms clustered, " << gpuMs[1] / frames << " ms every light per fragment ("
+			<< gpuMs[1] / gpuMs[0] << "x)" << std::endl;
+	}
+
+	glDeleteQueries(1, &query);
+	glDeleteVertexArrays(1, &boxVAO);
+	glDeleteBuffers(1, &VBO);
+
+	return EXIT_SUCCESS;
+}
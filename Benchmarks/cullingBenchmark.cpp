@@ -0,0 +1,96 @@
+// cullingBenchmark.cpp: frustum culling throughput over a large set of random boxes, one box at a time
+// (Frustum::IsBoxVisible) versus the SIMD batch pass (Frustum::CullBoxes). No GL context is needed.
+//
+// Usage: cullingBenchmark [box count] [runs]
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Frustum.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+int main(int argc, char **argv)
+{
+	int boxCount = (argc > 1) ? std::max(1, atoi(argv[1])) : 1000000;
+	int runs = (argc > 2) ? std::max(1, atoi(argv[2])) : 20;
+
+	//Boxes scattered around the camera, so roughly a fifth of them ends up inside the view volume
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size(0.1f, 10.0f);
+
+	std::vector<AABB> boxes(boxCount);
+	BoundsArray bounds;
+	bounds.Reserve(boxCount);
+	for (int i = 0; i < boxCount; i++)
+	{
+		glm::vec3 center(position(random), position(random), position(random));
+		glm::vec3 extents(size(random), size(random), size(random));
+		boxes[i].Min = center - extents;
+		boxes[i].Max = center + extents;
+		bounds.Add(boxes[i]);
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(projection * view);
+
+	// ===================
+	// One box at a time
+	// ===================
+	GLuint scalarVisible = 0;
+	Clock::time_point start = Clock::now();
+	for (int run = 0; run < runs; run++)
+	{
+		scalarVisible = 0;
+		for (int i = 0; i < boxCount; i++)
+		{
+			scalarVisible += frustum.IsBoxVisible(boxes[i]) ? 1 : 0;
+		}
+	}
+	double scalarMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / runs;
+
+	// ===================
+	// Batch pass over the structure of arrays
+	// ===================
+	std::vector<GLuint> visible;
+	visible.reserve(boxCount);
+	CullStats stats;
+	start = Clock::now();
+	for (int run = 0; run < runs; run++)
+	{
+		visible.clear();
+		stats = frustum.CullBoxes(bounds, visible);
+	}
+	double batchMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / runs;
+
+	//Both passes must agree on every box
+	bool match = (stats.visible == scalarVisible);
+	for (size_t i = 0; match && i < visible.size(); i++)
+	{
+		match = frustum.IsBoxVisible(boxes[visible[i]]);
+	}
+
+	std::cout << boxCount << " boxes, " << stats.visible << " visible, " << stats.culled << " culled" << std::endl;
+	std::cout << "scalar:        " << scalarMs << " ms (" << boxCount / (scalarMs * 1000.0) << " M boxes/s)" << std::endl;
+	std::cout << "batch (" << FRUSTUM_SIMD_WIDTH << " wide): " << batchMs << " ms (" << boxCount / (batchMs * 1000.0) << " M boxes/s)" << std::endl;
+	std::cout << "speedup: " << scalarMs / batchMs << "x" << std::endl;
+
+	if (!match)
+	{
+		std::cout << "ERROR::CULLING:: Batch and scalar results differ" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+// deferredBenchmark.cpp: renders one scene (a plane, a box, a row of spheres behind each other for overdraw, and
+// optionally a model from disk) offscreen with the forward path (modelLoading.frag) and with the deferred path
+// (gbuffer.frag, then the frame light as a full screen pass). Both images are read back and compared; the run fails
+// when their PSNR is under MIN_PSNR. Then reports the GPU time per frame of forward, deferred and deferred with extra
+// point lights drawn as light volumes, measured with GL_TIME_ELAPSED queries.
+//
+// Usage: deferredBenchmark [shader directory] [frames] [point lights] [model path]
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "../DeferredRenderer.h"
+#include "BenchmarkCommon.h"
+
+const GLint WIDTH = 1280, HEIGHT = 720;
+const double MIN_PSNR = 40.0;
+const int SPHERES = 8;
+
+//Writes the scene OBJ and its materials, one object per material
+void WriteScene(const std::string &path, const std::string &materialPath)
+{
+	std::ofstream materials(materialPath.c_str());
+	materials << "newmtl floor\nKa 0.1 0.1 0.1\nKd 0.6 0.6 0.55\nKs 0.2 0.2 0.2\nNs 8\n";
+	materials << "newmtl box\nKa 0.1 0.05 0.03\nKd 1.0 0.5 0.31\nKs 0.5 0.5 0.5\nNs 32\n";
+	materials << "newmtl sphere\nKa 0.02 0.05 0.1\nKd 0.2 0.5 0.9\nKs 0.8 0.8 0.8\nNs 64\n";
+
+	std::ofstream file(path.c_str());
+	file << "mtllib " << materialPath << "\n";
+	int vertex = 1;
+
+	file << "o plane\nusemtl floor\n";
+	WriteBox(file, vertex, glm::vec3(0.0f, -0.05f, 0.0f), glm::vec3(20.0f, 0.1f, 20.0f));
+
+	file << "o box\nusemtl box\n";
+	WriteBox(file, vertex, glm::vec3(-2.0f, 0.75f, 1.0f), glm::vec3(1.5f));
+
+	file << "o spheres\nusemtl sphere\n";
+	for (int i = 0; i < SPHERES; i++)
+	{
+		WriteSphere(file, vertex, glm::vec3(1.5f, 1.0f, 2.0f - i * 1.5f), 0.9f);
+	}
+}
+
+//Peak signal to noise ratio of two RGBA8 images, in dB (color channels only)
+double Psnr(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int &maxDifference)
+{
+	double squared = 0.0;
+	maxDifference = 0;
+	size_t samples = 0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (3 == i % 4)
+		{
+			continue;
+		}
+		int difference = std::abs((int)a[i] - (int)b[i]);
+		maxDifference = std::max(maxDifference, difference);
+		squared += difference * difference;
+		samples++;
+	}
+	double mse = squared / samples;
+	return (0.0 == mse) ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "Model3D/";
+	int frames = (argc > 2) ? std::max(1, atoi(argv[2])) : 100;
+	int pointLightCount = (argc > 3) ? std::max(0, atoi(argv[3])) : 256;
+	std::string modelPath = (argc > 4) ? argv[4] : "";
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Deferred benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	//Offscreen target, so the read back doesn't depend on the window being visible
+	OffscreenTarget target(WIDTH, HEIGHT);
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	Shader forwardShader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+	Shader gBufferShader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "gbuffer.frag").c_str());
+	Shader frameLightShader((shaderDir + "deferred.vs").c_str(), (shaderDir + "deferredFrameLight.frag").c_str());
+	Shader pointLightShader((shaderDir + "deferredPointLight.vs").c_str(), (shaderDir + "deferredPointLight.frag").c_str());
+	DeferredRenderer deferredRenderer(WIDTH, HEIGHT);
+
+	ModelLoadOptions options;
+	options.useMeshCache = false;
+	std::string path = "deferredBenchmark.obj", materialPath = "deferredBenchmark.mtl";
+	WriteScene(path, materialPath);
+	std::vector<Model *> models;
+	std::vector<glm::mat4> transforms;
+	models.push_back(new Model(path.c_str(), options));
+	transforms.push_back(glm::mat4());
+	std::remove(path.c_str());
+	std::remove(materialPath.c_str());
+	if (!modelPath.empty())
+	{
+		models.push_back(new Model(modelPath.c_str(), options));
+		transforms.push_back(glm::translate(glm::mat4(), glm::vec3(-2.0f, 1.5f, -2.0f)));
+	}
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 4.0f, 9.0f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f);
+	frameUniforms.Update(view, projection, cameraPos, glm::vec3(3.0f, 5.0f, 4.0f));
+
+	//Point lights scattered over the floor, only the last deferred pass draws them
+	std::vector<PointLight> pointLights(pointLightCount);
+	srand(3);
+	for (int i = 0; i < pointLightCount; i++)
+	{
+		pointLights[i].Position = glm::vec3((rand() % 1000) / 50.0f - 10.0f, 0.3f + (rand() % 1000) / 500.0f, (rand() % 1000) / 50.0f - 10.0f);
+		pointLights[i].Radius = 1.0f + (rand() % 1000) / 500.0f;
+		pointLights[i].Color = glm::vec3((rand() % 1000) / 1000.0f, (rand() % 1000) / 1000.0f, (rand() % 1000) / 1000.0f);
+		pointLights[i].Intensity = 0.5f;
+	}
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	const char *names[3] = { "forward                  ", "deferred                 ", "deferred with point lights" };
+	std::vector<unsigned char> forwardImage(WIDTH * HEIGHT * 4), deferredImage(WIDTH * HEIGHT * 4);
+	double gpuMs[3] = { 0.0, 0.0, 0.0 };
+	for (int pass = 0; pass < 3; pass++)
+	{
+		for (int frame = 0; frame <= frames; frame++)
+		{
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			if (0 == pass)
+			{
+				glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				forwardShader.use();
+				for (size_t i = 0; i < models.size(); i++)
+				{
+					forwardShader.setMat4("model", transforms[i]);
+					forwardShader.setMat3("normalMatrix", NormalMatrix(transforms[i]));
+					models[i]->Draw(forwardShader);
+				}
+			}
+			else
+			{
+				deferredRenderer.BeginGeometryPass(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+				gBufferShader.use();
+				for (size_t i = 0; i < models.size(); i++)
+				{
+					gBufferShader.setMat4("model", transforms[i]);
+					gBufferShader.setMat3("normalMatrix", NormalMatrix(transforms[i]));
+					models[i]->Draw(gBufferShader);
+				}
+				deferredRenderer.ApplyFrameLight(frameLightShader);
+				if (2 == pass)
+				{
+					deferredRenderer.ApplyPointLights(pointLightShader, pointLights);
+				}
+				deferredRenderer.Resolve();
+			}
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			//The first frame is a warm up, and the one the images are read from
+			if (0 == frame)
+			{
+				if (pass < 2)
+				{
+					glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, (0 == pass) ? &forwardImage[0] : &deferredImage[0]);
+				}
+				continue;
+			}
+			gpuMs[pass] += nanoseconds / 1000000.0;
+		}
+	}
+
+	int maxDifference = 0;
+	double psnr = Psnr(forwardImage, deferredImage, maxDifference);
+	bool failed = psnr < MIN_PSNR;
+
+	std::cout << WIDTH << "x" << HEIGHT << ", " << frames << " frames, G-buffer " << deferredRenderer.GetMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+	for (int pass = 0; pass < 3; pass++)
+	{
+		std::cout << names[pass] << ": " << gpuMs[pass] / frames << " ms GPU per frame";
+		if (2 == pass)
+		{
+			std::cout << " (" << pointLightCount << " lights)";
+		}
+		std::cout << std::endl;
+	}
+	std::cout << "Forward vs deferred image: PSNR " << psnr << " dB, largest channel difference " << maxDifference << std::endl;
+	std::cout << (failed ? "FAILED: the deferred path renders a different image" : "both paths render the same image") << std::endl;
+
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		delete models[i];
+	}
+	glDeleteQueries(1, &query);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// drawAllocationBenchmark.cpp: counts the heap allocations (global operator new) made while a loaded model is drawn
+// frame after frame, through every draw path: per mesh, multi-draw, frustum culled and the render queue.
+// The first frames of each path may allocate (uniform lookups, scratch lists growing), after them the draw path must
+// not allocate at all; any allocation in the measured frames is reported and makes the run fail.
+//
+// Usage: drawAllocationBenchmark [model path] [shader directory] [frames]
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+//Every allocation of the process goes through these
+static std::atomic<size_t> allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+	allocationCount++;
+	void *memory = std::malloc(std::max(size, (std::size_t)1));
+	if (NULL == memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+	std::free(memory);
+}
+
+const int WARMUP_FRAMES = 3;
+
+int main(int argc, char **argv)
+{
+	std::string path = (argc > 1) ? argv[1] : "res/models/obj_Grass/untitled.obj";
+	std::string shaderDir = (argc > 2) ? argv[2] : "Model3D/";
+	int frames = (argc > 3) ? std::max(1, atoi(argv[3])) : 100;
+
+	BenchmarkContext context(800, 600, "Draw allocation benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	glEnable(GL_DEPTH_TEST);
+
+	Shader shader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+	Model model(path.c_str());
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 0.0f, 3.0f);
+	glm::mat4 view = glm::translate(glm::mat4(), -cameraPos);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+	glm::mat4 transform = glm::scale(glm::mat4(), glm::vec3(0.008f));
+	frameUniforms.Update(view, projection, cameraPos);
+
+	UniformHandle modelLoc = shader.GetUniform("model");
+	UniformHandle normalMatrixLoc = shader.GetUniform("normalMatrix");
+	Frustum frustum(projection * view * transform);
+	RenderQueue renderQueue;
+
+	const char *names[4] = { "per mesh    ", "multi draw  ", "culled      ", "render queue" };
+	bool failed = false;
+	for (int pass = 0; pass < 4; pass++)
+	{
+		model.SetDrawSubmission((0 == pass) ? DRAW_PER_MESH : DRAW_MULTI);
+
+		size_t allocations = 0;
+		for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++)
+		{
+			if (WARMUP_FRAMES == frame)
+			{
+				glFinish();
+				allocations = allocationCount;
+			}
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			if (3 == pass)
+			{
+				renderQueue.Begin(cameraPos);
+				model.Submit(renderQueue, shader, transform, frustum, TRANSFORM_UNIFORM_SCALE);
+				renderQueue.Flush();
+			}
+			else
+			{
+				shader.use();
+				shader.setMat4(modelLoc, transform);
+				shader.setMat3(normalMatrixLoc, NormalMatrix(transform, TRANSFORM_UNIFORM_SCALE));
+				if (2 == pass)
+				{
+					model.Draw(shader, frustum);
+				}
+				else
+				{
+					model.Draw(shader);
+				}
+			}
+		}
+		glFinish();
+		allocations = allocationCount - allocations;
+
+		std::cout << names[pass] << ": " << allocations << " allocations in " << frames << " frames" << std::endl;
+		failed = failed || (0 != allocations);
+	}
+
+	std::cout << model.GetMeshCount() << " meshes, " << (failed ? "FAILED: the draw path allocates" : "no allocations in steady state") << std::endl;
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
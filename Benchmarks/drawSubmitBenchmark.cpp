@@ -0,0 +1,158 @@
+// drawSubmitBenchmark.cpp: loads a generated model of many small meshes and draws it with one
+// glDrawElementsBaseVertex per mesh (DRAW_PER_MESH) and with one multi-draw per material batch (DRAW_MULTI),
+// reporting the CPU time Model::Draw takes to submit a frame, the whole frame time and the draw calls of both.
+// The multi-draw path uses glMultiDrawElementsIndirect when the context has GL 4.3 or ARB_multi_draw_indirect and
+// glMultiDrawElementsBaseVertex otherwise; the report says which one ran.
+//
+// Usage: drawSubmitBenchmark [shader directory] [mesh count] [frames]
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const GLint WIDTH = 1280, HEIGHT = 720;
+
+//Writes an OBJ with one object (so one mesh once imported) per cube, laid out on a grid
+void WriteCubeGrid(const std::string &path, int cubeCount, int side)
+{
+	std::ofstream file(path.c_str());
+	const GLfloat corners[8][3] = {
+		{ -0.4f, -0.4f, -0.4f }, { 0.4f, -0.4f, -0.4f }, { 0.4f, 0.4f, -0.4f }, { -0.4f, 0.4f, -0.4f },
+		{ -0.4f, -0.4f, 0.4f }, { 0.4f, -0.4f, 0.4f }, { 0.4f, 0.4f, 0.4f }, { -0.4f, 0.4f, 0.4f }
+	};
+	const int faces[6][4] = {
+		{ 1, 4, 3, 2 }, { 5, 6, 7, 8 }, { 1, 5, 8, 4 }, { 2, 3, 7, 6 }, { 1, 2, 6, 5 }, { 4, 8, 7, 3 }
+	};
+
+	for (int i = 0; i < cubeCount; i++)
+	{
+		glm::vec3 cell((GLfloat)(i % side), (GLfloat)((i / side) % side), (GLfloat)(i / (side * side)));
+		cell -= glm::vec3(side * 0.5f);
+
+		file << "o cube_" << i << "\n";
+		for (int v = 0; v < 8; v++)
+		{
+			file << "v " << cell.x + corners[v][0] << " " << cell.y + corners[v][1] << " " << cell.z + corners[v][2] << "\n";
+		}
+		for (int f = 0; f < 6; f++)
+		{
+			file << "f";
+			for (int v = 0; v < 4; v++)
+			{
+				file << " " << (i * 8 + faces[f][v]);
+			}
+			file << "\n";
+		}
+	}
+}
+
+struct PassResult
+{
+	double submitMs;
+	double frameMs;
+	GLuint drawCalls;
+};
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "Model3D/";
+	int meshCount = (argc > 2) ? std::max(1, atoi(argv[2])) : 10000;
+	int frames = (argc > 3) ? std::max(1, atoi(argv[3])) : 200;
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Draw submit benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader shader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+
+	int side = (int)std::ceil(std::pow((double)meshCount, 1.0 / 3.0));
+	std::string path = "drawSubmitBenchmark.obj";
+	WriteCubeGrid(path, meshCount, side);
+
+	ModelLoadOptions options;
+	options.useMeshCache = false;
+	Model cubes(path.c_str(), options);
+	std::remove(path.c_str());
+
+	//Whole grid in view, nothing is culled
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 0.0f, side * 2.5f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, side * 10.0f);
+	frameUniforms.Update(view, projection, cameraPos);
+
+	shader.use();
+	shader.setMat4("model", glm::mat4());
+	shader.setMat3("normalMatrix", glm::mat3());
+
+	PassResult results[2];
+	DrawSubmission modes[2] = { DRAW_PER_MESH, DRAW_MULTI };
+	for (int pass = 0; pass < 2; pass++)
+	{
+		cubes.SetDrawSubmission(modes[pass]);
+		GetDrawStats() = DrawStats();
+
+		//Warm up the driver's state caches before timing
+		cubes.Draw(shader);
+		glFinish();
+		GetDrawStats() = DrawStats();
+
+		double submitMs = 0.0;
+		Clock::time_point start = Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			Clock::time_point submitStart = Clock::now();
+			cubes.Draw(shader);
+			submitMs += std::chrono::duration<double, std::milli>(Clock::now() - submitStart).count();
+
+			glFinish();
+		}
+
+		results[pass].submitMs = submitMs / frames;
+		results[pass].frameMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+		results[pass].drawCalls = GetDrawStats().drawCalls / frames;
+	}
+
+	const char *names[2] = { "per mesh  ", "multi draw" };
+	std::cout << cubes.GetMeshCount() << " meshes in " << cubes.GetBatchCount() << " material batches, " << frames << " frames, multi draw through "
+		<< (MultiDrawList::IsIndirectSupported() ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex (no indirect support)") << std::endl;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::cout << names[pass] << ": " << results[pass].submitMs << " ms CPU submit, " << results[pass].frameMs << " ms per frame, "
+			<< results[pass].drawCalls << " draw calls per frame" << std::endl;
+	}
+	std::cout << "submit speedup: " << results[0].submitMs / results[1].submitMs << "x" << std::endl;
+
+	return EXIT_SUCCESS;
+}
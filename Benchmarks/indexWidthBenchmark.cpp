@@ -0,0 +1,182 @@
+// indexWidthBenchmark.cpp: loads a generated scene of small cubes and one large grid (more vertices than 16 bit
+// indices reach) three ways: forced 32 bit indices, automatic (the grid keeps the model on 32 bit) and automatic with
+// splitLargeMeshes (16 bit). Each is rendered into an offscreen framebuffer and read back; the images must match the
+// 32 bit one pixel for pixel, any difference makes the run fail. Reports the index memory and GPU draw time of each.
+//
+// Usage: indexWidthBenchmark [shader directory] [grid side in vertices] [frames]
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+const GLint WIDTH = 512, HEIGHT = 512;
+const int CUBES_PER_SIDE = 16;
+
+//Writes an OBJ with a side x side vertex grid on the floor and a layer of cubes above it, one object each
+void WriteScene(const std::string &path, int side)
+{
+	std::ofstream file(path.c_str());
+	int vertex = 1;
+
+	file << "o grid\n";
+	for (int y = 0; y < side; y++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			GLfloat u = (GLfloat)x / (side - 1), v = (GLfloat)y / (side - 1);
+			file << "v " << u * 2.0f - 1.0f << " " << 0.05f * std::sin(u * 30.0f) * std::cos(v * 30.0f) << " " << v * 2.0f - 1.0f << "\n";
+		}
+	}
+	for (int y = 0; y + 1 < side; y++)
+	{
+		for (int x = 0; x + 1 < side; x++)
+		{
+			int corner = vertex + y * side + x;
+			file << "f " << corner << " " << corner + side << " " << corner + side + 1 << " " << corner + 1 << "\n";
+		}
+	}
+	vertex += side * side;
+
+	const GLfloat corners[8][3] = {
+		{ -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 }, { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 }
+	};
+	const int faces[6][4] = {
+		{ 1, 4, 3, 2 }, { 5, 6, 7, 8 }, { 1, 5, 8, 4 }, { 2, 3, 7, 6 }, { 1, 2, 6, 5 }, { 4, 8, 7, 3 }
+	};
+	for (int i = 0; i < CUBES_PER_SIDE * CUBES_PER_SIDE; i++)
+	{
+		glm::vec3 center(((i % CUBES_PER_SIDE) + 0.5f) / CUBES_PER_SIDE * 2.0f - 1.0f, 0.3f, ((i / CUBES_PER_SIDE) + 0.5f) / CUBES_PER_SIDE * 2.0f - 1.0f);
+		file << "o cube_" << i << "\n";
+		for (int v = 0; v < 8; v++)
+		{
+			file << "v " << center.x + corners[v][0] * 0.03f << " " << center.y + corners[v][1] * 0.03f << " " << center.z + corners[v][2] * 0.03f << "\n";
+		}
+		for (int f = 0; f < 6; f++)
+		{
+			file << "f";
+			for (int v = 0; v < 4; v++)
+			{
+				file << " " << vertex + faces[f][v] - 1;
+			}
+			file << "\n";
+		}
+		vertex += 8;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "Model3D/";
+	int side = (argc > 2) ? std::max(2, atoi(argv[2])) : 400;
+	int frames = (argc > 3) ? std::max(1, atoi(argv[3])) : 100;
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Index width benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	//Offscreen target, so the read back doesn't depend on the window being visible
+	OffscreenTarget target(WIDTH, HEIGHT);
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader shader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+
+	std::string path = "indexWidthBenchmark.obj";
+	WriteScene(path, side);
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 1.5f, 1.8f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 10.0f);
+	frameUniforms.Update(view, projection, cameraPos, cameraPos);
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	const char *names[3] = { "32 bit          ", "automatic       ", "automatic, split" };
+	std::vector<unsigned char> reference(WIDTH * HEIGHT * 4), pixels(WIDTH * HEIGHT * 4);
+	bool failed = false;
+	for (int pass = 0; pass < 3; pass++)
+	{
+		ModelLoadOptions options;
+		options.useMeshCache = false;
+		options.shortIndices = (pass > 0);
+		options.splitLargeMeshes = (2 == pass);
+		Model scene(path.c_str(), options);
+
+		shader.use();
+		shader.setMat4("model", glm::mat4());
+		shader.setMat3("normalMatrix", glm::mat3());
+
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		scene.Draw(shader);
+		glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, (0 == pass) ? &reference[0] : &pixels[0]);
+
+		size_t differences = 0;
+		if (pass > 0)
+		{
+			for (size_t i = 0; i < pixels.size(); i += 4)
+			{
+				differences += (0 != memcmp(&pixels[i], &reference[i], 4)) ? 1 : 0;
+			}
+			failed = failed || (0 != differences);
+		}
+
+		double gpuMs = 0.0;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			scene.Draw(shader);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			gpuMs += nanoseconds / 1000000.0;
+		}
+
+		std::cout << names[pass] << ": " << scene.GetMeshCount() << " meshes, " << (GL_UNSIGNED_SHORT == scene.GetIndexType() ? 16 : 32) << " bit indices, "
+			<< scene.GetIndexBytes() / 1024 << " KB of indices, " << gpuMs / frames << " ms GPU per draw";
+		if (pass > 0)
+		{
+			std::cout << ", " << differences << " pixels differ from 32 bit";
+		}
+		std::cout << std::endl;
+		std::cout << "    " << scene.GetMemoryReport() << std::endl;
+	}
+	std::remove(path.c_str());
+
+	glDeleteQueries(1, &query);
+
+	std::cout << (failed ? "FAILED: 16 bit indices render differently" : "all index widths render the same image") << std::endl;
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
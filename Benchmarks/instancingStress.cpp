@@ -0,0 +1,212 @@
+// instancingStress.cpp: draws a grid of lit cubes once per object (model and color uniforms plus a glDrawArrays per
+// cube, like the demos do) and once through an InstanceBuffer (all cubes in one glDrawArraysInstanced), and reports
+// draw calls and frame time of both. Both paths upload their per cube data every frame.
+//
+// Usage: instancingStress [shader directory] [cube count] [frames]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Instancing.h"
+#include "../Transforms.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const GLint WIDTH = 1280, HEIGHT = 720;
+
+struct PassResult
+{
+	double frameMs;
+	GLuint drawCalls;
+	GLuint uniformCalls;
+};
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "res/shaders/";
+	int cubeCount = (argc > 2) ? std::max(1, atoi(argv[2])) : 100000;
+	int frames = (argc > 3) ? std::max(1, atoi(argv[3])) : 100;
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Instancing stress", true);
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	int screenWidth, screenHeight;
+	glfwGetFramebufferSize(context.GetWindow(), &screenWidth, &screenHeight);
+	glViewport(0, 0, screenWidth, screenHeight);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader lightingShader((shaderDir + "lighting.vs").c_str(), (shaderDir + "lighting.frag").c_str());
+	Shader instancedShader((shaderDir + "instanced.vs").c_str(), (shaderDir + "instanced.frag").c_str());
+
+	//Same cube as the lighting demo
+	GLfloat vertices[] = {
+		//Position			//Normals
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
+	};
+
+	GLuint VBO, boxVAO;
+	glGenVertexArrays(1, &boxVAO);
+	glGenBuffers(1, &VBO);
+	glBindVertexArray(boxVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+
+	InstanceBuffer cubes(boxVAO);
+
+	//Cubes on a grid, each one with its own rotation and color
+	int side = (int)std::ceil(std::pow((double)cubeCount, 1.0 / 3.0));
+	std::vector<glm::mat4> transforms(cubeCount);
+	std::vector<glm::vec4> colors(cubeCount);
+	for (int i = 0; i < cubeCount; i++)
+	{
+		glm::vec3 cell((GLfloat)(i % side), (GLfloat)((i / side) % side), (GLfloat)(i / (side * side)));
+		glm::mat4 model;
+		model = glm::translate(model, (cell - glm::vec3(side * 0.5f)) * 2.0f);
+		model = glm::rotate(model, (GLfloat)i, glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+		transforms[i] = model;
+		colors[i] = glm::vec4(cell / (GLfloat)side, 1.0f);
+	}
+	//The cubes are only rotated and translated, so their normal matrices are copies
+	std::vector<glm::mat3> normalMatrices(cubeCount);
+	std::vector<GLubyte> kinds(cubeCount, TRANSFORM_UNIFORM_SCALE);
+	ComputeNormalMatrices(&transforms[0], &kinds[0], cubeCount, &normalMatrices[0]);
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, side * 0.5f, side * 2.5f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)screenWidth / (GLfloat)screenHeight, 0.1f, side * 10.0f);
+	frameUniforms.Update(view, projection, cameraPos, cameraPos, glm::vec3(1.0f, 1.0f, 1.0f));
+
+	UniformHandle modelLoc = lightingShader.GetUniform("model");
+	UniformHandle normalMatrixLoc = lightingShader.GetUniform("normalMatrix");
+	UniformHandle objectColorLoc = lightingShader.GetUniform("objectColor");
+
+	PassResult results[2];
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool instanced = (1 == pass);
+		GLuint drawCalls = 0;
+		GetUniformUploadStats() = UniformUploadStats();
+
+		glFinish();
+		Clock::time_point start = Clock::now();
+		for (int frame = 0; frame < frames && !glfwWindowShouldClose(context.GetWindow()); frame++)
+		{
+			glfwPollEvents();
+			glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			if (instanced)
+			{
+				instancedShader.use();
+				cubes.Update(transforms, colors);
+				cubes.DrawArrays(GL_TRIANGLES, 0, 36);
+				drawCalls++;
+			}
+			else
+			{
+				lightingShader.use();
+				glBindVertexArray(boxVAO);
+				for (int i = 0; i < cubeCount; i++)
+				{
+					lightingShader.setMat4(modelLoc, transforms[i]);
+					lightingShader.setMat3(normalMatrixLoc, normalMatrices[i]);
+					lightingShader.setVec3(objectColorLoc, glm::vec3(colors[i]));
+					glDrawArrays(GL_TRIANGLES, 0, 36);
+				}
+				glBindVertexArray(0);
+				drawCalls += cubeCount;
+			}
+
+			glfwSwapBuffers(context.GetWindow());
+		}
+		glFinish();
+
+		results[pass].frameMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+		results[pass].drawCalls = drawCalls / frames;
+		results[pass].uniformCalls = GetUniformUploadStats().uniformCalls / frames;
+	}
+
+	const char *names[2] = { "per object", "instanced " };
+	std::cout << cubeCount << " cubes, " << frames << " frames" << std::endl;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::cout << names[pass] << ": " << results[pass].frameMs << " ms per frame, "
+			<< results[pass].drawCalls << " draw calls, " << results[pass].uniformCalls << " glUniform per frame" << std::endl;
+	}
+	std::cout << "speedup: " << results[0].frameMs / results[1].frameMs << "x" << std::endl;
+
+	glDeleteVertexArrays(1, &boxVAO);
+	glDeleteBuffers(1, &VBO);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+// lodBenchmark.cpp: draws a field of grass clumps, one model instanced many times at distances from right in front of
+// the camera to far away, through the render queue. The camera slowly moves forward so instances cross level
+// switch distances. Runs once at full detail and once with generated levels of detail picked by screen space error,
+// and reports the triangles submitted per frame, the level switches per frame and the GPU and CPU time per frame.
+//
+// Usage: lodBenchmark [model path] [shader directory] [instances] [frames]
+// Without a model path a clump of grass blades is generated.
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const GLint WIDTH = 800, HEIGHT = 600;
+const int BLADES = 300, BLADE_SEGMENTS = 8;
+
+//Writes an OBJ of a clump of thin, bent grass blades standing on a unit square
+void WriteGrass(const std::string &path)
+{
+	std::ofstream file(path.c_str());
+	srand(1);
+	for (int blade = 0; blade < BLADES; blade++)
+	{
+		GLfloat x = (rand() % 1000) / 1000.0f - 0.5f, z = (rand() % 1000) / 1000.0f - 0.5f;
+		GLfloat angle = (rand() % 628) / 100.0f, lean = (rand() % 100) / 300.0f, height = 0.3f + (rand() % 100) / 300.0f;
+		for (int s = 0; s <= BLADE_SEGMENTS; s++)
+		{
+			GLfloat t = (GLfloat)s / BLADE_SEGMENTS, width = 0.02f * (1.0f - t) + 0.001f, bend = lean * t * t;
+			for (int side = -1; side <= 1; side += 2)
+			{
+				file << "v " << x + std::cos(angle) * width * side + std::sin(angle) * bend << " " << height * t << " "
+					<< z + std::sin(angle) * width * side + std::cos(angle) * bend << "\n";
+			}
+		}
+		for (int s = 0; s < BLADE_SEGMENTS; s++)
+		{
+			int corner = blade * (BLADE_SEGMENTS + 1) * 2 + s * 2 + 1;
+			file << "f " << corner << " " << corner + 1 << " " << corner + 3 << " " << corner + 2 << "\n";
+		}
+	}
+}
+
+struct PassResult
+{
+	double triangles;
+	double fullDetailTriangles;
+	double levelChanges;
+	double gpuMs;
+	double frameMs;
+};
+
+int main(int argc, char **argv)
+{
+	std::string path = (argc > 1) ? argv[1] : "";
+	std::string shaderDir = (argc > 2) ? argv[2] : "Model3D/";
+	int instances = (argc > 3) ? std::max(1, atoi(argv[3])) : 2000;
+	int frames = (argc > 4) ? std::max(1, atoi(argv[4])) : 200;
+
+	bool generated = path.empty();
+	if (generated)
+	{
+		path = "lodBenchmark.obj";
+		WriteGrass(path);
+	}
+
+	BenchmarkContext context(WIDTH, HEIGHT, "LOD benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader shader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+
+	//Clumps on a square field in front of the camera, the nearest ones a few units away, the farthest a few hundred
+	int side = (int)std::ceil(std::sqrt((GLfloat)instances));
+	std::vector<glm::mat4> transforms(instances);
+	for (int i = 0; i < instances; i++)
+	{
+		GLfloat x = ((i % side) - side * 0.5f) * 3.0f, z = -(GLfloat)(i / side) * 3.0f;
+		transforms[i] = glm::rotate(glm::translate(glm::mat4(), glm::vec3(x, 0.0f, z)), (GLfloat)i, glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 1000.0f);
+	FrameUniforms frameUniforms;
+	RenderQueue renderQueue;
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	PassResult results[2];
+	for (int pass = 0; pass < 2; pass++)
+	{
+		ModelLoadOptions options;
+		options.useMeshCache = false;
+		options.generateLods = (1 == pass);
+		options.loaderThreads = 0;
+		Model grass(path.c_str(), options);
+
+		//Each instance remembers its own levels
+		std::vector<LodState> states(instances);
+
+		PassResult &result = results[pass];
+		result = PassResult();
+		Clock::time_point start = Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			glm::vec3 cameraPos(0.0f, 1.5f, 5.0f - 0.05f * frame);
+			glm::mat4 view = glm::lookAt(cameraPos, cameraPos + glm::vec3(0.0f, -0.1f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			frameUniforms.Update(view, projection, cameraPos, cameraPos);
+			LodView lodView(cameraPos, projection, (GLfloat)HEIGHT);
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glBeginQuery(GL_TIME_ELAPSED, query);
+
+			GetLodStats() = LodStats();
+			renderQueue.Begin(cameraPos);
+			for (int i = 0; i < instances; i++)
+			{
+				Frustum frustum(projection * view * transforms[i]);
+				grass.Submit(renderQueue, shader, transforms[i], frustum, lodView, states[i], TRANSFORM_UNIFORM_SCALE);
+			}
+			renderQueue.Flush();
+
+			glEndQuery(GL_TIME_ELAPSED);
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+
+			result.gpuMs += nanoseconds / 1000000.0;
+			result.triangles += GetLodStats().trianglesSubmitted;
+			result.fullDetailTriangles += GetLodStats().trianglesFullDetail;
+			//The first frame picks every level from scratch, only count the switches after it
+			result.levelChanges += (frame > 0) ? GetLodStats().levelChanges : 0;
+		}
+		result.frameMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+		result.gpuMs /= frames;
+		result.triangles /= frames;
+		result.fullDetailTriangles /= frames;
+		result.levelChanges /= frames;
+
+		if (1 == pass)
+		{
+			std::cout << grass.GetMeshCount() << " meshes, " << grass.GetLodCount(0) << " levels of detail for the first one" << std::endl;
+		}
+	}
+	glDeleteQueries(1, &query);
+	if (generated)
+	{
+		std::remove(path.c_str());
+	}
+
+	const char *names[2] = { "full detail", "LOD        " };
+	std::cout << instances << " instances, " << frames << " frames at " << WIDTH << "x" << HEIGHT << std::endl;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::cout << names[pass] << ": " << (GLuint)results[pass].triangles << " triangles per frame (" << (GLuint)results[pass].fullDetailTriangles
+			<< " at full detail), " << results[pass].levelChanges << " level switches per frame, " << results[pass].gpuMs << " ms GPU, "
+			<< results[pass].frameMs << " ms per frame" << std::endl;
+	}
+	std::cout << "Triangles saved: " << 100.0 * (1.0 - results[1].triangles / results[0].triangles) << "%, GPU time "
+		<< results[0].gpuMs / results[1].gpuMs << "x faster" << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+// meshOptimizerBenchmark.cpp: runs the MeshOptimizer passes on large generated meshes and reports the vertex cache
+// figures (ACMR: vertex shader runs per triangle, ATVR: per vertex, both on a 16 entry FIFO) before and after, and the
+// time each pass takes. The grid comes in scanline order (how exporters usually write it) and with its triangles
+// shuffled (the worst case); the sphere is a UV sphere in ring order. Needs no GL context.
+//
+// Usage: meshOptimizerBenchmark [grid side in vertices]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+
+//Other includes
+#include <assimp/scene.h>
+#include "../Shader.h"
+#include "../Mesh.h"
+#include "../MeshOptimizer.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double ElapsedMs(const Clock::time_point &start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+//Flat grid of side x side vertices, two triangles per cell, row by row
+void MakeGrid(int side, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+	vertices.resize(side * side);
+	for (int y = 0; y < side; y++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			Vertex &vertex = vertices[y * side + x];
+			vertex.Position = glm::vec3((GLfloat)x, 0.0f, (GLfloat)y);
+			vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+			vertex.TexCoords = glm::vec2((GLfloat)x / side, (GLfloat)y / side);
+		}
+	}
+
+	indices.clear();
+	for (int y = 0; y + 1 < side; y++)
+	{
+		for (int x = 0; x + 1 < side; x++)
+		{
+			GLuint corner = y * side + x;
+			GLuint quad[6] = { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+//UV sphere with the given rings and segments, ring by ring
+void MakeSphere(int rings, int segments, std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+	vertices.clear();
+	for (int r = 0; r <= rings; r++)
+	{
+		GLfloat theta = 3.14159265f * r / rings;
+		for (int s = 0; s <= segments; s++)
+		{
+			GLfloat phi = 2.0f * 3.14159265f * s / segments;
+			Vertex vertex;
+			vertex.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			vertex.Position = vertex.Normal;
+			vertex.TexCoords = glm::vec2((GLfloat)s / segments, (GLfloat)r / rings);
+			vertices.push_back(vertex);
+		}
+	}
+
+	indices.clear();
+	for (int r = 0; r < rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			GLuint corner = r * (segments + 1) + s;
+			GLuint quad[6] = { corner, corner + segments + 1, corner + 1, corner + 1, corner + segments + 1, corner + segments + 2 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+//Same triangles in a random order
+void ShuffleTriangles(std::vector<GLuint> &indices)
+{
+	size_t triangleCount = indices.size() / 3;
+	std::vector<GLuint> order(triangleCount);
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		order[i] = (GLuint)i;
+	}
+	std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+	std::vector<GLuint> shuffled(indices.size());
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		std::copy(indices.begin() + order[i] * 3, indices.begin() + order[i] * 3 + 3, shuffled.begin() + i * 3);
+	}
+	indices.swap(shuffled);
+}
+
+//Returns false when the optimized mesh lost triangles or points past its vertices
+bool Run(const std::string &name, std::vector<Vertex> vertices, std::vector<GLuint> indices)
+{
+	size_t indexCount = indices.size();
+	VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+	Clock::time_point start = Clock::now();
+	MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+	double cacheMs = ElapsedMs(start);
+	VertexCacheStats cached = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+	start = Clock::now();
+	MeshOptimizer::OptimizeOverdraw(indices, vertices);
+	double overdrawMs = ElapsedMs(start);
+
+	start = Clock::now();
+	MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+	double fetchMs = ElapsedMs(start);
+	VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+	std::cout << name << ": " << indices.size() / 3 << " triangles, " << vertices.size() << " vertices" << std::endl
+		<< "  ACMR " << before.acmr << " -> " << cached.acmr << " (cache pass) -> " << after.acmr << " (all passes)" << std::endl
+		<< "  ATVR " << before.atvr << " -> " << after.atvr << std::endl
+		<< "  vertex cache " << cacheMs << " ms, overdraw " << overdrawMs << " ms, vertex fetch " << fetchMs << " ms" << std::endl;
+
+	bool valid = (indexCount == indices.size());
+	for (size_t i = 0; valid && i < indices.size(); i++)
+	{
+		valid = (indices[i] < vertices.size());
+	}
+	if (!valid)
+	{
+		std::cout << "  FAILED: the optimized index buffer is not valid" << std::endl;
+	}
+	return valid;
+}
+
+int main(int argc, char **argv)
+{
+	int side = (argc > 1) ? std::max(2, atoi(argv[1])) : 1000;
+
+	std::vector<Vertex> vertices;
+	std::vector<GLuint> indices;
+
+	bool valid = true;
+	MakeGrid(side, vertices, indices);
+	valid = Run("grid, scanline order", vertices, indices) && valid;
+	ShuffleTriangles(indices);
+	valid = Run("grid, shuffled", vertices, indices) && valid;
+
+	MakeSphere(side / 2, side, vertices, indices);
+	valid = Run("sphere, ring order", vertices, indices) && valid;
+
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,113 @@
+// modelLoadBenchmark.cpp: compares a cold Assimp import against a warm load from the binary mesh cache,
+// and measures how the Assimp import scales with the number of mesh conversion threads.
+//
+// Usage: modelLoadBenchmark [model path] [runs]
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double LoadModel(const std::string &path, bool &fromCache, const ModelLoadOptions &options = ModelLoadOptions())
+{
+	Clock::time_point start = Clock::now();
+	Model model(path.c_str(), options);
+	glFinish();
+	Clock::time_point end = Clock::now();
+
+	fromCache = model.IsLoadedFromCache();
+
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	std::string path = (argc > 1) ? argv[1] : "res/models/obj_Grass/untitled.obj";
+	int runs = (argc > 2) ? std::max(1, atoi(argv[2])) : 5;
+	std::string cachePath = path + ".meshcache";
+
+	//Invisible window, we only need the context
+	BenchmarkContext context(64, 64, "Model load benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	double coldTotal = 0.0, warmTotal = 0.0;
+	bool fromCache;
+
+	for (int i = 0; i < runs; i++)
+	{
+		// Cold: no cache on disk, full Assimp import (this run also writes the cache)
+		remove(cachePath.c_str());
+		double cold = LoadModel(path, fromCache);
+		if (fromCache)
+		{
+			std::cout << "ERROR: cold run was served from the cache" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		// Warm: the cache written by the cold run is mapped and uploaded directly
+		double warm = LoadModel(path, fromCache);
+		if (!fromCache)
+		{
+			std::cout << "ERROR: warm run did not hit the cache (is " << cachePath << " writable?)" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "run " << i << ": cold " << cold << " ms, warm " << warm << " ms" << std::endl;
+		coldTotal += cold;
+		warmTotal += warm;
+	}
+
+	std::cout << "average cold (Assimp): " << coldTotal / runs << " ms" << std::endl;
+	std::cout << "average warm (cache):  " << warmTotal / runs << " ms" << std::endl;
+	std::cout << "speedup: " << coldTotal / warmTotal << "x" << std::endl;
+
+	// Thread scaling of the Assimp path, the cache is bypassed so every run imports
+	ModelLoadOptions options;
+	options.useMeshCache = false;
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	double serial = 0.0;
+
+	for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		options.loaderThreads = threads;
+		double total = 0.0;
+
+		for (int i = 0; i < runs; i++)
+		{
+			total += LoadModel(path, fromCache, options);
+		}
+
+		double average = total / runs;
+		if (1 == threads)
+		{
+			serial = average;
+		}
+
+		std::cout << threads << " thread(s): " << average << " ms (" << serial / average << "x)" << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+// modelMemoryBenchmark.cpp: process memory of loading a model through Assimp (mesh cache bypassed), keeping the
+// CPU copy of every mesh's geometry (the default) versus releasing it after upload (ModelLoadOptions::releaseCpuData).
+// Peak RSS only ever grows, so each mode runs in its own process: without a mode the benchmark starts itself once
+// per mode and prints both reports.
+//
+// Usage: modelMemoryBenchmark [model path] [keep|release]
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+// Resident set size right now, in KB
+size_t CurrentRss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.WorkingSetSize / 1024;
+#else
+	size_t pages = 0, resident = 0;
+	FILE *file = fopen("/proc/self/statm", "r");
+	if (NULL != file)
+	{
+		if (2 != fscanf(file, "%zu %zu", &pages, &resident))
+		{
+			resident = 0;
+		}
+		fclose(file);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+}
+
+// Highest resident set size of the process so far, in KB
+size_t PeakRss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (size_t)usage.ru_maxrss; // Already KB on Linux
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	std::string path = (argc > 1) ? argv[1] : "res/models/obj_Grass/untitled.obj";
+
+	if (argc < 3)
+	{
+		//Run each mode in a fresh process
+		const char *modes[2] = { "keep", "release" };
+		for (int i = 0; i < 2; i++)
+		{
+			std::string command = std::string("\"") + argv[0] + "\" \"" + path + "\" " + modes[i];
+			if (0 != std::system(command.c_str()))
+			{
+				return EXIT_FAILURE;
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+
+	std::string mode = argv[2];
+
+	//Invisible window, we only need the context
+	BenchmarkContext context(64, 64, "Model memory benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	size_t baseline = CurrentRss();
+
+	ModelLoadOptions options;
+	options.useMeshCache = false;
+	options.releaseCpuData = ("release" == mode);
+
+	{
+		Model model(path.c_str(), options);
+		glFinish();
+
+		std::cout << mode << ": resident after load " << ((double)CurrentRss() - (double)baseline) / 1024.0 << " MB above baseline, peak RSS "
+			<< PeakRss() / 1024.0 << " MB (baseline " << baseline / 1024.0 << " MB)" << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
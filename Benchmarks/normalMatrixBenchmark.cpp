@@ -0,0 +1,215 @@
+// normalMatrixBenchmark.cpp: draws a dense generated mesh with a non uniformly scaled model matrix, once with the
+// normal matrix computed per vertex in the shader (mat3( transpose( inverse( model ) ) ), what modelLoading.vs used to
+// do) and once with the normalMatrix uniform computed on the CPU, and reports the GPU time of each. Frames go to a tiny
+// viewport in an invisible window so the vertex stage, not the rasterizer, is what takes the time.
+// It also times the CPU side for many transforms: glm's inverse, NormalMatrix( ) one by one and ComputeNormalMatrices( ),
+// and checks that all of them give the same normal directions.
+//
+// Usage: normalMatrixBenchmark [shader directory] [grid side in vertices] [frames] [transform count]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "../Transforms.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const GLint WIDTH = 64, HEIGHT = 64;
+
+//Writes a copy of the vertex shader at sourcePath that computes the normal matrix per vertex again
+bool WritePerVertexShader(const std::string &sourcePath, const std::string &path)
+{
+	std::ifstream source(sourcePath.c_str());
+	std::stringstream stream;
+	stream << source.rdbuf();
+	std::string code = stream.str();
+
+	std::string uniform = "normalMatrix * normal";
+	size_t at = code.find(uniform);
+	if (std::string::npos == at)
+	{
+		return false;
+	}
+	code.replace(at, uniform.size(), "mat3( transpose( inverse( model ) ) ) * normal");
+
+	std::ofstream file(path.c_str());
+	file << code;
+	return true;
+}
+
+//Largest angle, in degrees, between the columns of two normal matrices once normalized
+GLfloat MaxAngle(const glm::mat3 &a, const glm::mat3 &b)
+{
+	GLfloat angle = 0.0f;
+	for (int c = 0; c < 3; c++)
+	{
+		GLfloat cosine = glm::dot(glm::normalize(a[c]), glm::normalize(b[c]));
+		angle = std::max(angle, glm::degrees(std::acos(std::min(1.0f, cosine))));
+	}
+	return angle;
+}
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "Model3D/";
+	int side = (argc > 2) ? std::max(2, atoi(argv[2])) : 1024;
+	int frames = (argc > 3) ? std::max(1, atoi(argv[3])) : 100;
+	int transformCount = (argc > 4) ? std::max(4, atoi(argv[4])) : 100000;
+
+	// ===================
+	// CPU: normal matrices of many transforms
+	// ===================
+	//Random rotations, translations and non uniform scales, some of them mirrored
+	std::vector<glm::mat4> transforms(transformCount);
+	srand(1);
+	for (int i = 0; i < transformCount; i++)
+	{
+		glm::vec3 axis(rand() / (GLfloat)RAND_MAX - 0.5f, rand() / (GLfloat)RAND_MAX - 0.5f, rand() / (GLfloat)RAND_MAX + 0.1f);
+		glm::vec3 scale(0.5f + rand() / (GLfloat)RAND_MAX, 0.5f + rand() / (GLfloat)RAND_MAX, 0.5f + rand() / (GLfloat)RAND_MAX);
+		if (0 == i % 7)
+		{
+			scale.x = -scale.x;
+		}
+		glm::mat4 model = glm::translate(glm::mat4(), glm::vec3((GLfloat)(i % 100), 0.0f, (GLfloat)(i / 100)));
+		model = glm::rotate(model, (GLfloat)i, glm::normalize(axis));
+		transforms[i] = glm::scale(model, scale);
+	}
+
+	std::vector<glm::mat3> inverses(transformCount), scalar(transformCount), batched(transformCount);
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < transformCount; i++)
+	{
+		inverses[i] = glm::transpose(glm::inverse(glm::mat3(transforms[i])));
+	}
+	double inverseMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int i = 0; i < transformCount; i++)
+	{
+		scalar[i] = NormalMatrix(transforms[i]);
+	}
+	double scalarMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	ComputeNormalMatrices(&transforms[0], NULL, transformCount, &batched[0]);
+	double batchedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	GLfloat maxAngle = 0.0f;
+	for (int i = 0; i < transformCount; i++)
+	{
+		maxAngle = std::max(maxAngle, std::max(MaxAngle(inverses[i], scalar[i]), MaxAngle(inverses[i], batched[i])));
+	}
+
+	std::cout << transformCount << " transforms: inverse " << inverseMs << " ms, NormalMatrix " << scalarMs << " ms, ComputeNormalMatrices ("
+		<< FRUSTUM_SIMD_WIDTH << " wide) " << batchedMs << " ms, " << inverseMs / batchedMs << "x; largest normal deviation " << maxAngle << " degrees" << std::endl;
+	bool failed = maxAngle > 0.01f;
+
+	// ===================
+	// GPU: vertex stage with and without the per vertex inverse
+	// ===================
+	BenchmarkContext context(WIDTH, HEIGHT, "Normal matrix benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	std::string perVertexPath = "normalMatrixBenchmark.vs";
+	if (!WritePerVertexShader(shaderDir + "modelLoading.vs", perVertexPath))
+	{
+		std::cout << "ERROR::NORMAL_MATRIX_BENCHMARK::" << shaderDir << "modelLoading.vs has no normalMatrix uniform" << std::endl;
+		return EXIT_FAILURE;
+	}
+	Shader perVertexShader(perVertexPath.c_str(), (shaderDir + "modelLoading.frag").c_str());
+	Shader uniformShader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+	std::remove(perVertexPath.c_str());
+
+	std::string path = "normalMatrixBenchmark.obj";
+	WriteGrid(path, side);
+	ModelLoadOptions options;
+	options.useMeshCache = false;
+	options.releaseCpuData = true;
+	Model grid(path.c_str(), options);
+	std::remove(path.c_str());
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 1.0f, 1.0f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 10.0f);
+	frameUniforms.Update(view, projection, cameraPos);
+
+	//Non uniform scale, so the normal matrix really is needed
+	glm::mat4 model = glm::scale(glm::rotate(glm::mat4(), 0.3f, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f, 2.0f, 0.5f));
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	Shader *shaders[2] = { &perVertexShader, &uniformShader };
+	double gpuMs[2];
+	for (int pass = 0; pass < 2; pass++)
+	{
+		Shader &shader = *shaders[pass];
+		shader.use();
+		shader.setMat4("model", model);
+		shader.setMat3("normalMatrix", NormalMatrix(model));
+
+		//Warm up before timing
+		grid.Draw(shader);
+		glFinish();
+
+		gpuMs[pass] = 0.0;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			grid.Draw(shader);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			gpuMs[pass] += nanoseconds / 1000000.0;
+		}
+		gpuMs[pass] /= frames;
+	}
+	glDeleteQueries(1, &query);
+
+	GLuint vertexCount = side * side;
+	std::cout << vertexCount << " vertices, " << frames << " frames at " << WIDTH << "x" << HEIGHT << std::endl;
+	std::cout << "per vertex inverse: " << gpuMs[0] << " ms GPU per draw, " << vertexCount / (gpuMs[0] * 1000.0) << " M vertices/s" << std::endl;
+	std::cout << "normalMatrix      : " << gpuMs[1] << " ms GPU per draw, " << vertexCount / (gpuMs[1] * 1000.0) << " M vertices/s, "
+		<< gpuMs[0] / gpuMs[1] << "x" << std::endl;
+
+	if (failed)
+	{
+		std::cout << "FAILED: the normal matrices differ from transpose( inverse( model ) )" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
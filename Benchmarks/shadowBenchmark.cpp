@@ -0,0 +1,199 @@
+// shadowBenchmark.cpp: renders a field of boxes on a floor offscreen, lit by a directional light, without shadows and
+// with CascadedShadowMap at several cascade counts and resolutions. The depth passes draw the scene Model culled by
+// each cascade's light volume (the same batching and culling as the camera pass). Reports the GPU time of every
+// cascade's depth pass, how many of the box meshes each one drew and culled, and the GPU time of the whole frame,
+// measured with GL_TIMESTAMP queries so they don't nest with the cascades' own GL_TIME_ELAPSED ones.
+//
+// Usage: shadowBenchmark [shader directory] [frames] [boxes per side]
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "../Transforms.h"
+#include "../ShadowCascades.h"
+#include "BenchmarkCommon.h"
+
+const GLint WIDTH = 1280, HEIGHT = 720;
+const GLfloat SPACING = 2.5f;
+
+//Writes the floor and side x side boxes of random heights, every box its own object so each one is culled alone
+void WriteScene(const std::string &path, const std::string &materialPath, int side)
+{
+	std::ofstream materials(materialPath.c_str());
+	materials << "newmtl floor\nKa 0.1 0.1 0.1\nKd 0.6 0.6 0.55\nKs 0.2 0.2 0.2\nNs 8\n";
+	materials << "newmtl box\nKa 0.1 0.05 0.03\nKd 1.0 0.5 0.31\nKs 0.5 0.5 0.5\nNs 32\n";
+
+	std::ofstream file(path.c_str());
+	file << "mtllib " << materialPath << "\n";
+	int vertex = 1;
+
+	GLfloat extent = side * SPACING;
+	file << "o floor\nusemtl floor\n";
+	WriteBox(file, vertex, glm::vec3(0.0f, -0.05f, 0.0f), glm::vec3(extent + 10.0f, 0.1f, extent + 10.0f));
+
+	srand(5);
+	for (int z = 0; z < side; z++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			GLfloat height = 0.5f + (rand() % 1000) / 250.0f;
+			glm::vec3 center((x + 0.5f) * SPACING - extent * 0.5f, height * 0.5f, (z + 0.5f) * SPACING - extent * 0.5f);
+			file << "o box" << z * side + x << "\nusemtl box\n";
+			WriteBox(file, vertex, center, glm::vec3(1.0f, height, 1.0f));
+		}
+	}
+}
+
+struct ShadowConfig
+{
+	GLuint cascadeCount;	//0 is the run without shadows
+	GLuint resolution;
+};
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "Model3D/";
+	int frames = (argc > 2) ? std::max(1, atoi(argv[2])) : 100;
+	int side = (argc > 3) ? std::max(1, atoi(argv[3])) : 40;
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Shadow benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	//Offscreen target, so the timings don't depend on the window being visible
+	OffscreenTarget target(WIDTH, HEIGHT);
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader lightingShader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+	Shader depthShader((shaderDir + "shadowDepth.vs").c_str(), (shaderDir + "shadowDepth.frag").c_str());
+
+	ModelLoadOptions options;
+	options.useMeshCache = false;
+	options.releaseCpuData = true;
+	std::string path = "shadowBenchmark.obj", materialPath = "shadowBenchmark.mtl";
+	WriteScene(path, materialPath, side);
+	Model scene(path.c_str(), options);
+	std::remove(path.c_str());
+	std::remove(materialPath.c_str());
+	glm::mat4 model;
+
+	//Low over the field, looking across it, so the near cascades are dense and the far ones cover a lot of boxes
+	const GLfloat nearPlane = 0.1f, farPlane = 200.0f;
+	GLfloat extent = side * SPACING;
+	glm::vec3 cameraPos(0.0f, 4.0f, extent * 0.5f + 2.0f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, nearPlane, farPlane);
+	glm::vec3 lightDirection = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
+	FrameUniforms frameUniforms;
+	frameUniforms.Update(view, projection, cameraPos, -lightDirection, glm::vec3(1.0f), true);
+
+	const ShadowConfig configs[] = { { 0, 0 }, { 1, 2048 }, { 2, 2048 }, { 4, 1024 }, { 4, 2048 }, { 4, 4096 } };
+	const int configCount = sizeof(configs) / sizeof(configs[0]);
+
+	GLuint frameQueries[2];
+	glGenQueries(2, frameQueries);
+
+	std::cout << WIDTH << "x" << HEIGHT << ", " << frames << " frames, " << side * side << " boxes" << std::endl;
+	double baselineMs = 0.0;
+	for (int c = 0; c < configCount; c++)
+	{
+		//The baseline has 0 cascades: no passes, and Bind only turns the shadows of the shader off
+		ShadowOptions shadowOptions;
+		shadowOptions.cascadeCount = configs[c].cascadeCount;
+		shadowOptions.resolution = configs[c].resolution;
+		shadowOptions.maxDistance = 60.0f;
+		CascadedShadowMap *shadows = new CascadedShadowMap(shadowOptions);
+
+		double frameMs = 0.0;
+		double cascadeMs[SHADOW_MAX_CASCADES] = { 0.0 };
+		GLuint casters[SHADOW_MAX_CASCADES] = { 0 }, culled[SHADOW_MAX_CASCADES] = { 0 };
+		//Two warm up frames, the cascade timings of a frame are read two frames later
+		for (int frame = -2; frame < frames; frame++)
+		{
+			glQueryCounter(frameQueries[0], GL_TIMESTAMP);
+			shadows->Update(view, projection, nearPlane, farPlane, lightDirection);
+			for (GLuint i = 0; i < shadows->GetCascadeCount(); i++)
+			{
+				shadows->BeginCascade(i, depthShader);
+				depthShader.setMat4("model", model);
+				scene.Draw(depthShader, shadows->GetFrustum(i, model));
+				shadows->EndCascade();
+				if (0 <= frame)
+				{
+					casters[i] += scene.GetCullStats().visible;
+					culled[i] += scene.GetCullStats().culled;
+				}
+			}
+			shadows->End();
+
+			glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			lightingShader.use();
+			lightingShader.setMat4("model", model);
+			lightingShader.setMat3("normalMatrix", NormalMatrix(model));
+			shadows->Bind(lightingShader);
+			scene.Draw(lightingShader, Frustum(projection * view * model));
+			glQueryCounter(frameQueries[1], GL_TIMESTAMP);
+
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(frameQueries[0], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frameQueries[1], GL_QUERY_RESULT, &end);
+			if (0 <= frame)
+			{
+				frameMs += (end - begin) / 1000000.0;
+				for (GLuint i = 0; i < shadows->GetCascadeCount(); i++)
+				{
+					cascadeMs[i] += shadows->GetStats().gpuMs[i];
+				}
+			}
+		}
+		frameMs /= frames;
+
+		const ShadowStats &stats = shadows->GetStats();
+		if (0 == stats.cascadeCount)
+		{
+			baselineMs = frameMs;
+			std::cout << "no shadows: " << frameMs << " ms GPU per frame" << std::endl;
+			delete shadows;
+			continue;
+		}
+
+		std::cout << stats.cascadeCount << " cascades at " << configs[c].resolution << " (" << shadows->GetMemoryUsage() / (1024 * 1024) << " MB): "
+			<< frameMs << " ms GPU per frame, shadows cost " << frameMs - baselineMs << " ms" << std::endl;
+		for (GLuint i = 0; i < stats.cascadeCount; i++)
+		{
+			std::cout << "  cascade " << i << " to " << stats.splits[i] << " m, texel " << stats.texelSizes[i] << " m: " << cascadeMs[i] / frames
+				<< " ms GPU, " << casters[i] / frames << " meshes drawn, " << culled[i] / frames << " culled" << std::endl;
+		}
+		delete shadows;
+	}
+
+	glDeleteQueries(2, frameQueries);
+
+	return EXIT_SUCCESS;
+}
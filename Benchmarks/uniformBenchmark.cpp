@@ -0,0 +1,220 @@
+// uniformBenchmark.cpp: CPU cost of the per-draw uniform updates of the Iluminacion Basica loop,
+// looking locations up by string every draw, through resolved UniformHandles with view, projection, camera and
+// light set on every program, and with that shared data in the frame uniform buffer (current loop).
+// The first two loops draw with the shaders of before the frame uniform buffer, embedded below, since the current ones
+// no longer declare the shared uniforms and setting them would only hit inactive locations.
+//
+// Usage: uniformBenchmark [shader directory] [iterations]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//Iluminacion Basica's lighting and lamp vertex shaders as they were when every program got view, projection, camera
+//and light as uniforms of its own
+const char *BASELINE_LIGHTING_VS =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 position;\n"
+	"layout (location = 1) in vec3 normal;\n"
+	"out vec3 Normal;\n"
+	"out vec3 FragPos;\n"
+	"uniform mat4 model;\n"
+	"uniform mat4 view;\n"
+	"uniform mat4 projection;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = projection * view * model * vec4(position, 1.0f);\n"
+	"	FragPos = vec3(model * vec4(position, 1.0f));\n"
+	"	Normal = mat3(transpose(inverse(model))) * normal;\n"
+	"}\n";
+
+const char *BASELINE_LIGHTING_FRAG =
+	"#version 330 core\n"
+	"out vec4 color;\n"
+	"in vec3 FragPos;\n"
+	"in vec3 Normal;\n"
+	"uniform vec3 lightPos;\n"
+	"uniform vec3 viewPos;\n"
+	"uniform vec3 objectColor;\n"
+	"uniform vec3 lightColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vec3 ambient = 0.1f * lightColor;\n"
+	"	vec3 norm = normalize(Normal);\n"
+	"	vec3 lightDir = normalize(lightPos - FragPos);\n"
+	"	vec3 diffuse = max(dot(norm, lightDir), 0.0) * lightColor;\n"
+	"	vec3 reflectDir = reflect(-lightDir, norm);\n"
+	"	float spec = pow(max(dot(normalize(viewPos - FragPos), reflectDir), 0.0), 32);\n"
+	"	vec3 specular = 5.0f * spec * lightColor;\n"
+	"	color = vec4((ambient + diffuse + specular) * objectColor, 1.0f);\n"
+	"}\n";
+
+const char *BASELINE_LAMP_VS =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 position;\n"
+	"uniform mat4 model;\n"
+	"uniform mat4 view;\n"
+	"uniform mat4 projection;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = projection * view * model * vec4(position, 1.0f);\n"
+	"}\n";
+
+//Shader only loads from files, so the embedded sources go through one
+void WriteShader(const std::string &path, const char *code)
+{
+	std::ofstream file(path.c_str());
+	file << code;
+}
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "res/shaders/";
+	int iterations = (argc > 2) ? std::max(1, atoi(argv[2])) : 100000;
+
+	//Invisible window, we only need the context
+	BenchmarkContext context(64, 64, "Uniform benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	Shader lightingShader((shaderDir + "lighting.vs").c_str(), (shaderDir + "lighting.frag").c_str());
+	Shader lampShader((shaderDir + "lamp.vs").c_str(), (shaderDir + "lamp.frag").c_str());
+
+	WriteShader("uniformBenchmarkLighting.vs", BASELINE_LIGHTING_VS);
+	WriteShader("uniformBenchmarkLighting.frag", BASELINE_LIGHTING_FRAG);
+	WriteShader("uniformBenchmarkLamp.vs", BASELINE_LAMP_VS);
+	Shader baselineLightingShader("uniformBenchmarkLighting.vs", "uniformBenchmarkLighting.frag");
+	Shader baselineLampShader("uniformBenchmarkLamp.vs", (shaderDir + "lamp.frag").c_str());
+	std::remove("uniformBenchmarkLighting.vs");
+	std::remove("uniformBenchmarkLighting.frag");
+	std::remove("uniformBenchmarkLamp.vs");
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 model;
+	glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
+	glm::vec3 viewPos(0.0f, 0.0f, 3.0f);
+
+	// ===================
+	// By string, as the loop used to do every frame
+	// ===================
+	glFinish();
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		baselineLightingShader.use();
+		glUniform3f(glGetUniformLocation(baselineLightingShader.ID, "objectColor"), 1.0f, 0.5f, 0.31f);
+		glUniform3f(glGetUniformLocation(baselineLightingShader.ID, "lightColor"), 1.0f, 1.0f, 1.0f);
+		glUniform3f(glGetUniformLocation(baselineLightingShader.ID, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		glUniform3f(glGetUniformLocation(baselineLightingShader.ID, "viewPos"), viewPos.x, viewPos.y, viewPos.z);
+		glUniformMatrix4fv(glGetUniformLocation(baselineLightingShader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+		glUniformMatrix4fv(glGetUniformLocation(baselineLightingShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+		glUniformMatrix4fv(glGetUniformLocation(baselineLightingShader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
+
+		baselineLampShader.use();
+		glUniformMatrix4fv(glGetUniformLocation(baselineLampShader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+		glUniformMatrix4fv(glGetUniformLocation(baselineLampShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+		glUniformMatrix4fv(glGetUniformLocation(baselineLampShader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
+	}
+	glFinish();
+	double byString = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+	// ===================
+	// Through handles resolved once
+	// ===================
+	UniformHandle objectColorLoc = baselineLightingShader.GetUniform("objectColor");
+	UniformHandle lightColorLoc = baselineLightingShader.GetUniform("lightColor");
+	UniformHandle lightPosLoc = baselineLightingShader.GetUniform("lightPos");
+	UniformHandle viewPosLoc = baselineLightingShader.GetUniform("viewPos");
+	UniformHandle modelLoc = baselineLightingShader.GetUniform("model");
+	UniformHandle viewLoc = baselineLightingShader.GetUniform("view");
+	UniformHandle projLoc = baselineLightingShader.GetUniform("projection");
+	UniformHandle lampModelLoc = baselineLampShader.GetUniform("model");
+	UniformHandle lampViewLoc = baselineLampShader.GetUniform("view");
+	UniformHandle lampProjLoc = baselineLampShader.GetUniform("projection");
+
+	GetUniformUploadStats() = UniformUploadStats();
+	glFinish();
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		baselineLightingShader.use();
+		baselineLightingShader.setVec3(objectColorLoc, 1.0f, 0.5f, 0.31f);
+		baselineLightingShader.setVec3(lightColorLoc, 1.0f, 1.0f, 1.0f);
+		baselineLightingShader.setVec3(lightPosLoc, lightPos);
+		baselineLightingShader.setVec3(viewPosLoc, viewPos);
+		baselineLightingShader.setMat4(viewLoc, view);
+		baselineLightingShader.setMat4(projLoc, projection);
+		baselineLightingShader.setMat4(modelLoc, model);
+
+		baselineLampShader.use();
+		baselineLampShader.setMat4(lampViewLoc, view);
+		baselineLampShader.setMat4(lampProjLoc, projection);
+		baselineLampShader.setMat4(lampModelLoc, model);
+	}
+	glFinish();
+	double byHandle = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	UniformUploadStats handleUploads = GetUniformUploadStats();
+
+	// ===================
+	// Shared data in the frame uniform buffer, only per object uniforms left
+	// ===================
+	FrameUniforms frameUniforms;
+	UniformHandle bufferObjectColorLoc = lightingShader.GetUniform("objectColor");
+	UniformHandle bufferModelLoc = lightingShader.GetUniform("model");
+	UniformHandle bufferLampModelLoc = lampShader.GetUniform("model");
+	GetUniformUploadStats() = UniformUploadStats();
+
+	glFinish();
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		frameUniforms.Update(view, projection, viewPos, lightPos, glm::vec3(1.0f, 1.0f, 1.0f));
+
+		lightingShader.use();
+		lightingShader.setVec3(bufferObjectColorLoc, 1.0f, 0.5f, 0.31f);
+		lightingShader.setMat4(bufferModelLoc, model);
+
+		lampShader.use();
+		lampShader.setMat4(bufferLampModelLoc, model);
+	}
+	glFinish();
+	double byBuffer = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	UniformUploadStats bufferUploads = GetUniformUploadStats();
+
+	// Each iteration covers the two draws of one frame (box and lamp)
+	std::cout << "by string: " << byString / (iterations * 2.0) << " ns per draw, 10 glUniform per frame" << std::endl;
+	std::cout << "by handle: " << byHandle / (iterations * 2.0) << " ns per draw, "
+		<< handleUploads.uniformCalls / (double)iterations << " glUniform per frame" << std::endl;
+	std::cout << "frame UBO: " << byBuffer / (iterations * 2.0) << " ns per draw, "
+		<< bufferUploads.uniformCalls / (double)iterations << " glUniform + "
+		<< bufferUploads.bufferUpdates / (double)iterations << " buffer update per frame" << std::endl;
+	std::cout << "speedup (string -> handle): " << byString / byHandle << "x" << std::endl;
+	std::cout << "speedup (handle -> UBO): " << byHandle / byBuffer << "x" << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// vertexFormatBenchmark.cpp: loads a dense generated mesh with float vertices (VERTEX_FORMAT_FLOAT, 32 bytes) and with
+// quantized ones (VERTEX_FORMAT_COMPACT, 16 bytes) and reports the GPU memory of each and their vertex throughput.
+// Frames go to a tiny viewport in an invisible window so the vertex fetch, not the rasterizer, is what takes the time;
+// the GPU time of each draw is measured with GL_TIME_ELAPSED queries.
+//
+// Usage: vertexFormatBenchmark [shader directory] [grid side in vertices] [frames]
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+//GLEW
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+//GLFW
+#include <GLFW/glfw3.h>
+
+//GLM Mathematics
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Other includes
+#include "../Shader.h"
+#include "../FrameUniforms.h"
+#include "../Model.h"
+#include "BenchmarkCommon.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const GLint WIDTH = 64, HEIGHT = 64;
+
+struct PassResult
+{
+	GLsizeiptr geometryBytes;
+	GLsizeiptr indexBytes;
+	double gpuMs;
+	double frameMs;
+};
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = (argc > 1) ? argv[1] : "Model3D/";
+	int side = (argc > 2) ? std::max(2, atoi(argv[2])) : 1024;
+	int frames = (argc > 3) ? std::max(1, atoi(argv[3])) : 100;
+
+	BenchmarkContext context(WIDTH, HEIGHT, "Vertex format benchmark");
+	if (!context.IsValid())
+	{
+		return EXIT_FAILURE;
+	}
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+
+	Shader shader((shaderDir + "modelLoading.vs").c_str(), (shaderDir + "modelLoading.frag").c_str());
+
+	std::string path = "vertexFormatBenchmark.obj";
+	WriteGrid(path, side);
+
+	FrameUniforms frameUniforms;
+	glm::vec3 cameraPos(0.0f, 1.0f, 1.0f);
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 10.0f);
+	frameUniforms.Update(view, projection, cameraPos);
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	PassResult results[2];
+	VertexFormat formats[2] = { VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_COMPACT };
+	for (int pass = 0; pass < 2; pass++)
+	{
+		ModelLoadOptions options;
+		options.useMeshCache = false;
+		options.releaseCpuData = true;
+		options.vertexFormat = formats[pass];
+		Model grid(path.c_str(), options);
+
+		shader.use();
+		shader.setMat4("model", glm::mat4());
+		shader.setMat3("normalMatrix", glm::mat3());
+
+		//Warm up before timing
+		grid.Draw(shader);
+		glFinish();
+
+		double gpuMs = 0.0;
+		Clock::time_point start = Clock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			grid.Draw(shader);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			gpuMs += nanoseconds / 1000000.0;
+		}
+
+		results[pass].geometryBytes = grid.GetGeometryBytes();
+		results[pass].indexBytes = grid.GetIndexBytes();
+		results[pass].gpuMs = gpuMs / frames;
+		results[pass].frameMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+	}
+	std::remove(path.c_str());
+	glDeleteQueries(1, &query);
+
+	//Every grid vertex is used, and two triangles per cell
+	GLuint vertexCount = side * side;
+	GLuint indexCount = (side - 1) * (side - 1) * 6;
+
+	const char *names[2] = { "float  ", "compact" };
+	std::cout << vertexCount << " vertices, " << indexCount / 3 << " triangles, " << frames << " frames at " << WIDTH << "x" << HEIGHT << std::endl;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		GLsizeiptr vertexBytes = results[pass].geometryBytes - results[pass].indexBytes;
+		std::cout << names[pass] << ": " << vertexBytes / 1024 << " KB vertices (" << results[pass].geometryBytes / 1024 << " KB with indices), "
+			<< results[pass].gpuMs << " ms GPU per draw, " << indexCount / (results[pass].gpuMs * 1000.0) << " M indices/s, "
+			<< results[pass].frameMs << " ms per frame" << std::endl;
+	}
+	std::cout << "GPU memory saved: " << (results[0].geometryBytes - results[1].geometryBytes) / 1024 << " KB ("
+		<< 100.0 * (results[0].geometryBytes - results[1].geometryBytes) / results[0].geometryBytes << "% of the geometry), vertex throughput "
+		<< results[0].gpuMs / results[1].gpuMs << "x" << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -10,6 +10,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Frustum.h"
+
 enum Camera_Movement
 {
 	FORWARD,
@@ -23,11 +25,14 @@ const GLfloat PITCH = 0.0f;
 const GLfloat SPEED = 6.0f;
 const GLfloat SENSITIVITY = 0.25f;
 const GLfloat ZOOM = 45.0f;
+const GLfloat NEAR_PLANE = 0.1f;
+const GLfloat FAR_PLANE = 1000.0f;
+const GLfloat ASPECT = 4.0f / 3.0f;
 
 class Camera
 {
 public:
-	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH) : front( glm::vec3(0.0f, 0.0f, -1.0f)), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY), zoom(ZOOM)
+	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH) : front( glm::vec3(0.0f, 0.0f, -1.0f)), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY), zoom(ZOOM), nearPlane(NEAR_PLANE), farPlane(FAR_PLANE), aspect(ASPECT), viewDirty(true), projectionDirty(true)
 	{
 		this->position = position;
 		this->worldUp = up;
@@ -36,7 +41,7 @@ public:
 		this->updateCameraVectors();
 	}
 
-	Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch) : front(glm::vec3(0.0f, 0.0f, -1.0f)), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY), zoom(ZOOM)
+	Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch) : front(glm::vec3(0.0f, 0.0f, -1.0f)), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY), zoom(ZOOM), nearPlane(NEAR_PLANE), farPlane(FAR_PLANE), aspect(ASPECT), viewDirty(true), projectionDirty(true)
 	{
 		this->position = glm::vec3( posX, posY, posZ);
 		this->worldUp = glm::vec3(upX, upY, upZ);;
@@ -45,10 +50,48 @@ public:
 		this->updateCameraVectors();
 
 	}
-	glm::mat4 GetviewMatrix()
+
+	//Perspective the camera projects with. Its matrices are rebuilt on the next read
+	void SetProjection(GLfloat aspect, GLfloat nearPlane = NEAR_PLANE, GLfloat farPlane = FAR_PLANE)
+	{
+		this->aspect = aspect;
+		this->nearPlane = nearPlane;
+		this->farPlane = farPlane;
+		this->projectionDirty = true;
+	}
+
+	//The matrices below are cached: they are only computed again after the camera moved, turned or changed projection
+	const glm::mat4 &GetviewMatrix()
 	{
-		return glm::lookAt(this->position, this->position + this->front, this->up); 
+		this->updateMatrices();
+		return this->view;
 	};
+	const glm::mat4 &GetProjectionMatrix()
+	{
+		this->updateMatrices();
+		return this->projection;
+	}
+	const glm::mat4 &GetViewProjectionMatrix()
+	{
+		this->updateMatrices();
+		return this->viewProjection;
+	}
+	const glm::mat4 &GetInverseViewMatrix()
+	{
+		this->updateMatrices();
+		return this->inverseView;
+	}
+	const glm::mat4 &GetInverseProjectionMatrix()
+	{
+		this->updateMatrices();
+		return this->inverseProjection;
+	}
+	//Clip space back to world space, for picking
+	const glm::mat4 &GetInverseViewProjectionMatrix()
+	{
+		this->updateMatrices();
+		return this->inverseViewProjection;
+	}
 
 	void ProcessKeyboard(Camera_Movement direction, GLfloat deltaTime)
 	{
@@ -70,10 +113,16 @@ public:
 		{
 			this->position += this->right * velocity;
 		}
+		this->viewDirty = true;
 	};
 
 	void ProcessMouseMovement(GLfloat xOffset, GLfloat yOffset, GLboolean constrainPitch = true)
 	{
+		if (0.0f == xOffset && 0.0f == yOffset)
+		{
+			return;
+		}
+
 		xOffset *= this->mouseSensitivity;
 		yOffset *= this->mouseSensitivity;
 
@@ -90,8 +139,8 @@ public:
 			{
 				this->pitch = -89.0f;
 			}
-			this->updateCameraVectors();
 		}
+		this->updateCameraVectors();
 
 	};
 
@@ -111,6 +160,35 @@ public:
 	{
 		return this->front;
 	}
+	//Distances of the clipping planes the demos build their projection with
+	GLfloat GetNear()
+	{
+		return this->nearPlane;
+	}
+	GLfloat GetFar()
+	{
+		return this->farPlane;
+	}
+
+	//World space view volume of the camera's own projection, cached with the matrices
+	const Frustum &GetFrustum()
+	{
+		this->updateMatrices();
+		return this->frustum;
+	}
+
+	//View volume of the camera's projection in the local space of model, ready to test its mesh bounds
+	Frustum GetLocalFrustum(const glm::mat4 &model)
+	{
+		return Frustum(this->GetViewProjectionMatrix() * model);
+	}
+
+	// View volume of the camera for the given projection. Pass the model matrix of an object to get the planes in
+	// that object's local space, ready to test its mesh bounds.
+	Frustum GetFrustum(const glm::mat4 &projection, const glm::mat4 &model = glm::mat4())
+	{
+		return Frustum(projection * this->GetviewMatrix() * model);
+	}
 
 
 private:
@@ -126,6 +204,46 @@ private:
 	GLfloat movementSpeed;
 	GLfloat mouseSensitivity;
 	GLfloat zoom;
+	GLfloat nearPlane;
+	GLfloat farPlane;
+	GLfloat aspect;
+
+	//Cached matrices and the flags telling which ones are stale
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::mat4 inverseViewProjection;
+	Frustum frustum;
+	bool viewDirty;
+	bool projectionDirty;
+
+	void updateMatrices()
+	{
+		if (!this->viewDirty && !this->projectionDirty)
+		{
+			return;
+		}
+
+		if (this->viewDirty)
+		{
+			this->view = glm::lookAt(this->position, this->position + this->front, this->up);
+			//The view is a rotation and a translation, its inverse is the camera's own axes and position
+			this->inverseView = glm::mat4(glm::vec4(this->right, 0.0f), glm::vec4(this->up, 0.0f), glm::vec4(-this->front, 0.0f), glm::vec4(this->position, 1.0f));
+		}
+		if (this->projectionDirty)
+		{
+			this->projection = glm::perspective(glm::radians(this->zoom), this->aspect, this->nearPlane, this->farPlane);
+			this->inverseProjection = glm::inverse(this->projection);
+		}
+		this->viewProjection = this->projection * this->view;
+		this->inverseViewProjection = this->inverseView * this->inverseProjection;
+		this->frustum = Frustum(this->viewProjection);
+
+		this->viewDirty = false;
+		this->projectionDirty = false;
+	}
 
 	void updateCameraVectors() 
 	{
@@ -138,6 +256,7 @@ private:
 		this->front = glm::normalize(front);
 		this->right = glm::normalize(glm::cross (this->front, this->worldUp));
 		this->up = glm::normalize(glm::cross(this->right, this->front));
+		this->viewDirty = true;
 
 	
 	}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+#include "ThreadPool.h"
+#include "Shader.h"
+#include "Camera.h"
+
+// Cluster grid: screen tiles in x and y, and depth slices in z. Slices get exponentially deeper with distance, so
+// every cluster is about as deep as it is wide. Must match the defines in clustered.frag
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT ( CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z )
+// Light indices are stored as 16 bit, lights past this many are ignored
+#define CLUSTER_MAX_LIGHTS 65536
+
+// A point light. The shader reads it as two texels: position and radius, then color times intensity.
+struct PointLight
+{
+    glm::vec3 Position;
+    GLfloat Radius;     // Its light fades to nothing at this distance
+    glm::vec3 Color;
+    GLfloat Intensity;
+};
+
+// Result of the last LightClusters::Update( )
+struct ClusterStats
+{
+    GLuint visibleLights;       // Lights touching the view volume
+    GLuint lightReferences;     // Light indices written, one per light and cluster it reaches
+    GLuint activeClusters;      // Clusters with at least one light
+    GLuint maxClusterLights;    // Lights of the busiest cluster
+    double assignMs;            // CPU time of the binning, upload excluded
+};
+
+// Clustered forward lighting: the view volume is split into CLUSTER_COUNT clusters and every frame each point light
+// is binned into the clusters its sphere touches. The lighting shader finds its fragment's cluster and only walks
+// that cluster's lights, instead of every light in the scene.
+//
+// Binning runs on the CPU: the view space bounds of the lights are computed 4 at a time with SSE, then the depth
+// slices are filled in parallel on a thread pool, each slice by one thread. The result reaches the shader through
+// buffer textures (GL 3.3 has no storage buffers): the lights, each cluster's offset and count, and the packed
+// 16 bit light index lists.
+class LightClusters
+{
+public:
+    /*  Functions   */
+    // threadCount threads bin the lights, 0 means one per hardware thread
+    explicit LightClusters( unsigned int threadCount = 0 ) : pool( threadCount ), projection( 0.0f ), tileScale( 0.0f ), depthScale( 0.0f ), depthBias( 0.0f ),
+        nearPlane( 0.0f ), farPlane( 0.0f ), lightCount( 0 ), warned( false )
+    {
+        memset( &this->stats, 0, sizeof( this->stats ) );
+
+        glGenBuffers( 3, this->buffers );
+        glGenTextures( 3, this->textures );
+        const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+        for ( GLuint i = 0; i < 3; i++ )
+        {
+            glBindBuffer( GL_TEXTURE_BUFFER, this->buffers[i] );
+            glBufferData( GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW );
+            glBindTexture( GL_TEXTURE_BUFFER, this->textures[i] );
+            glTexBuffer( GL_TEXTURE_BUFFER, formats[i], this->buffers[i] );
+        }
+        glBindTexture( GL_TEXTURE_BUFFER, 0 );
+        glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+
+        this->clusterLights.resize( CLUSTER_COUNT );
+        this->grid.resize( CLUSTER_COUNT * 2 );
+    }
+
+    ~LightClusters( )
+    {
+        glDeleteTextures( 3, this->textures );
+        glDeleteBuffers( 3, this->buffers );
+    }
+
+    // Bins lights into the clusters of this view and uploads them. Call it once a frame before drawing with a
+    // clustered shader. projection has to be a perspective one (glm::perspective), its near and far planes bound
+    // the slices; the viewport size maps fragments to tiles.
+    void Update( const vector<PointLight> &lights, const glm::mat4 &view, const glm::mat4 &projection, GLint viewportWidth, GLint viewportHeight )
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now( );
+
+        if( 0 != memcmp( &projection, &this->projection, sizeof( projection ) ) )
+        {
+            this->buildClusterBounds( projection );
+        }
+        this->tileScale = glm::vec2( ( GLfloat )CLUSTER_GRID_X / viewportWidth, ( GLfloat )CLUSTER_GRID_Y / viewportHeight );
+
+        this->lightCount = ( GLuint )std::min( lights.size( ), ( size_t )CLUSTER_MAX_LIGHTS );
+        if( this->lightCount < lights.size( ) && !this->warned )
+        {
+            std::cout << "ERROR::LIGHT_CLUSTERS::TOO_MANY_LIGHTS " << lights.size( ) << ", only the first " << CLUSTER_MAX_LIGHTS << " are used" << std::endl;
+            this->warned = true;
+        }
+
+        this->computeLightBounds( lights, view );
+        this->pool.ParallelFor( CLUSTER_GRID_Z, [this]( size_t slice )
+        {
+            this->assignSlice( ( GLuint )slice );
+        } );
+
+        // Pack the per cluster lists one after another
+        this->indices.clear( );
+        this->stats.lightReferences = this->stats.activeClusters = this->stats.maxClusterLights = 0;
+        for ( GLuint i = 0; i < CLUSTER_COUNT; i++ )
+        {
+            const vector<GLushort> &list = this->clusterLights[i];
+            this->grid[i * 2] = ( GLuint )this->indices.size( );
+            this->grid[i * 2 + 1] = ( GLuint )list.size( );
+            this->indices.insert( this->indices.end( ), list.begin( ), list.end( ) );
+
+            this->stats.activeClusters += list.empty( ) ? 0 : 1;
+            this->stats.maxClusterLights = std::max( this->stats.maxClusterLights, ( GLuint )list.size( ) );
+        }
+        this->stats.lightReferences = ( GLuint )this->indices.size( );
+        this->stats.assignMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now( ) - start ).count( );
+
+        this->texels.resize( std::max( 1u, this->lightCount ) * 2 );
+        for ( GLuint i = 0; i < this->lightCount; i++ )
+        {
+            this->texels[i * 2] = glm::vec4( lights[i].Position, lights[i].Radius );
+            this->texels[i * 2 + 1] = glm::vec4( lights[i].Color * lights[i].Intensity, 0.0f );
+        }
+        // An empty buffer texture isn't complete, keep one unused index around
+        if( this->indices.empty( ) )
+        {
+            this->indices.push_back( 0 );
+        }
+
+        this->upload( 0, &this->texels[0], this->texels.size( ) * sizeof( glm::vec4 ) );
+        this->upload( 1, &this->grid[0], this->grid.size( ) * sizeof( GLuint ) );
+        this->upload( 2, &this->indices[0], this->indices.size( ) * sizeof( GLushort ) );
+    }
+
+    // Update( ) for the view and projection a Camera has cached
+    void Update( const vector<PointLight> &lights, Camera &camera, GLint viewportWidth, GLint viewportHeight )
+    {
+        this->Update( lights, camera.GetviewMatrix( ), camera.GetProjectionMatrix( ), viewportWidth, viewportHeight );
+    }
+
+    // Binds the buffer textures to the CLUSTER_*_UNITs (where Shader points the cluster samplers) and sets the cluster
+    // uniforms of shader, which has to be in use
+    void Bind( const Shader &shader ) const
+    {
+        glActiveTexture( GL_TEXTURE0 + CLUSTER_LIGHTS_UNIT );
+        glBindTexture( GL_TEXTURE_BUFFER, this->textures[0] );
+        glActiveTexture( GL_TEXTURE0 + CLUSTER_GRID_UNIT );
+        glBindTexture( GL_TEXTURE_BUFFER, this->textures[1] );
+        glActiveTexture( GL_TEXTURE0 + CLUSTER_INDICES_UNIT );
+        glBindTexture( GL_TEXTURE_BUFFER, this->textures[2] );
+        glActiveTexture( GL_TEXTURE0 );
+
+        const ClusterUniforms &uniforms = this->getUniforms( shader );
+        shader.setVec2( uniforms.tileScale, this->tileScale );
+        shader.setVec2( uniforms.depthParams, glm::vec2( this->depthScale, this->depthBias ) );
+        shader.setInt( uniforms.lightCount, ( int )this->lightCount );
+    }
+
+    const ClusterStats &GetStats( ) const
+    {
+        return this->stats;
+    }
+
+    // Lights binned into a cluster by the last Update( )
+    const vector<GLushort> &GetClusterLights( GLuint x, GLuint y, GLuint z ) const
+    {
+        return this->clusterLights[x + CLUSTER_GRID_X * ( y + CLUSTER_GRID_Y * z )];
+    }
+
+private:
+    /*  Cluster Data  */
+    ThreadPool pool;
+    glm::mat4 projection;               // The one clusterMin/clusterMax were built for
+    vector<glm::vec3> clusterMin;       // View space bounds of each cluster as ( x, y, depth )
+    vector<glm::vec3> clusterMax;
+    glm::vec2 tileScale;                // Fragment coordinates to tiles
+    GLfloat depthScale, depthBias;      // slice = log( depth ) * depthScale + depthBias
+    GLfloat nearPlane, farPlane;
+
+    // Per light bounds, structure of arrays for the SIMD pass
+    vector<GLfloat> lightX, lightY, lightZ, lightRadius;     // World space
+    vector<GLfloat> centerX, centerY, depth;                // View space
+    vector<GLfloat> ndcMinX, ndcMaxX, ndcMinY, ndcMaxY;
+    struct LightRange
+    {
+        GLubyte minX, maxX, minY, maxY, minZ, maxZ;
+        bool visible;
+    };
+    vector<LightRange> ranges;
+
+    vector<vector<GLushort> > clusterLights;    // Each slice's clusters are only written by the thread of that slice
+    vector<GLuint> grid;                        // Offset and count of each cluster in indices
+    vector<GLushort> indices;
+    vector<glm::vec4> texels;
+    GLuint lightCount;
+    ClusterStats stats;
+    bool warned;
+
+    GLuint buffers[3];      // Lights, grid and indices
+    GLuint textures[3];
+
+    struct ClusterUniforms
+    {
+        GLuint program;
+        UniformHandle tileScale;
+        UniformHandle depthParams;
+        UniformHandle lightCount;
+    };
+    mutable vector<ClusterUniforms> uniforms;   // One per shader the clusters were bound to
+
+    LightClusters( const LightClusters & );
+    LightClusters &operator=( const LightClusters & );
+
+    /*  Functions   */
+    // View space boxes of every cluster, they only change with the projection
+    void buildClusterBounds( const glm::mat4 &projection )
+    {
+        this->projection = projection;
+        this->nearPlane = projection[3][2] / ( projection[2][2] - 1.0f );
+        this->farPlane = projection[3][2] / ( projection[2][2] + 1.0f );
+        this->depthScale = CLUSTER_GRID_Z / std::log( this->farPlane / this->nearPlane );
+        this->depthBias = -std::log( this->nearPlane ) * this->depthScale;
+
+        this->clusterMin.resize( CLUSTER_COUNT );
+        this->clusterMax.resize( CLUSTER_COUNT );
+        for ( GLuint z = 0; z < CLUSTER_GRID_Z; z++ )
+        {
+            GLfloat nearDepth = this->nearPlane * std::pow( this->farPlane / this->nearPlane, ( GLfloat )z / CLUSTER_GRID_Z );
+            GLfloat farDepth = this->nearPlane * std::pow( this->farPlane / this->nearPlane, ( GLfloat )( z + 1 ) / CLUSTER_GRID_Z );
+            for ( GLuint y = 0; y < CLUSTER_GRID_Y; y++ )
+            {
+                GLfloat bottom = ( GLfloat )y / CLUSTER_GRID_Y * 2.0f - 1.0f, top = ( GLfloat )( y + 1 ) / CLUSTER_GRID_Y * 2.0f - 1.0f;
+                for ( GLuint x = 0; x < CLUSTER_GRID_X; x++ )
+                {
+                    GLfloat left = ( GLfloat )x / CLUSTER_GRID_X * 2.0f - 1.0f, right = ( GLfloat )( x + 1 ) / CLUSTER_GRID_X * 2.0f - 1.0f;
+
+                    // The tile's sides are planes through the eye, the box spans them from the near to the far depth
+                    GLuint index = x + CLUSTER_GRID_X * ( y + CLUSTER_GRID_Y * z );
+                    this->clusterMin[index] = glm::vec3( std::min( left * nearDepth, left * farDepth ) / projection[0][0],
+                                                         std::min( bottom * nearDepth, bottom * farDepth ) / projection[1][1], nearDepth );
+                    this->clusterMax[index] = glm::vec3( std::max( right * nearDepth, right * farDepth ) / projection[0][0],
+                                                         std::max( top * nearDepth, top * farDepth ) / projection[1][1], farDepth );
+                }
+            }
+        }
+    }
+
+    // View space center and depth of each light, and the screen rectangle of the box around its sphere (clipped to the
+    // near plane). x / depth only grows or shrinks along each side of the box, so its corners give the rectangle.
+    void computeLightBounds( const vector<PointLight> &lights, const glm::mat4 &view )
+    {
+        GLuint count = this->lightCount;
+        // Padded to a whole number of SIMD groups
+        size_t padded = ( count + 3 ) & ~3u;
+        vector<GLfloat> *arrays[11] = { &this->lightX, &this->lightY, &this->lightZ, &this->lightRadius, &this->centerX, &this->centerY, &this->depth,
+                                        &this->ndcMinX, &this->ndcMaxX, &this->ndcMinY, &this->ndcMaxY };
+        for ( GLuint i = 0; i < 11; i++ )
+        {
+            arrays[i]->resize( padded );
+        }
+        for ( GLuint i = 0; i < count; i++ )
+        {
+            this->lightX[i] = lights[i].Position.x;
+            this->lightY[i] = lights[i].Position.y;
+            this->lightZ[i] = lights[i].Position.z;
+            this->lightRadius[i] = lights[i].Radius;
+        }
+        for ( size_t i = count; i < padded; i++ )
+        {
+            this->lightX[i] = this->lightY[i] = this->lightZ[i] = this->lightRadius[i] = 0.0f;
+        }
+
+        GLfloat projX = this->projection[0][0], projY = this->projection[1][1];
+        size_t i = 0;
+#if FRUSTUM_SIMD_WIDTH > 1
+        __m128 m[12];
+        for ( GLuint column = 0; column < 4; column++ )
+        {
+            m[column * 3] = _mm_set1_ps( view[column][0] );
+            m[column * 3 + 1] = _mm_set1_ps( view[column][1] );
+            m[column * 3 + 2] = _mm_set1_ps( -view[column][2] );
+        }
+        __m128 nearPlane = _mm_set1_ps( this->nearPlane );
+        __m128 px = _mm_set1_ps( projX ), py = _mm_set1_ps( projY ), one = _mm_set1_ps( 1.0f );
+        for ( ; i < padded; i += 4 )
+        {
+            __m128 x = _mm_loadu_ps( &this->lightX[i] ), y = _mm_loadu_ps( &this->lightY[i] ), z = _mm_loadu_ps( &this->lightZ[i] );
+            __m128 r = _mm_loadu_ps( &this->lightRadius[i] );
+
+            __m128 vx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m[0], x ), _mm_mul_ps( m[3], y ) ), _mm_add_ps( _mm_mul_ps( m[6], z ), m[9] ) );
+            __m128 vy = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m[1], x ), _mm_mul_ps( m[4], y ) ), _mm_add_ps( _mm_mul_ps( m[7], z ), m[10] ) );
+            __m128 vd = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m[2], x ), _mm_mul_ps( m[5], y ) ), _mm_add_ps( _mm_mul_ps( m[8], z ), m[11] ) );
+
+            __m128 invNear = _mm_div_ps( one, _mm_max_ps( _mm_sub_ps( vd, r ), nearPlane ) );
+            __m128 invFar = _mm_div_ps( one, _mm_max_ps( _mm_add_ps( vd, r ), nearPlane ) );
+            __m128 x0 = _mm_mul_ps( _mm_sub_ps( vx, r ), px ), x1 = _mm_mul_ps( _mm_add_ps( vx, r ), px );
+            __m128 y0 = _mm_mul_ps( _mm_sub_ps( vy, r ), py ), y1 = _mm_mul_ps( _mm_add_ps( vy, r ), py );
+
+            _mm_storeu_ps( &this->centerX[i], vx );
+            _mm_storeu_ps( &this->centerY[i], vy );
+            _mm_storeu_ps( &this->depth[i], vd );
+            _mm_storeu_ps( &this->ndcMinX[i], _mm_min_ps( _mm_mul_ps( x0, invNear ), _mm_mul_ps( x0, invFar ) ) );
+            _mm_storeu_ps( &this->ndcMaxX[i], _mm_max_ps( _mm_mul_ps( x1, invNear ), _mm_mul_ps( x1, invFar ) ) );
+            _mm_storeu_ps( &this->ndcMinY[i], _mm_min_ps( _mm_mul_ps( y0, invNear ), _mm_mul_ps( y0, invFar ) ) );
+            _mm_storeu_ps( &this->ndcMaxY[i], _mm_max_ps( _mm_mul_ps( y1, invNear ), _mm_mul_ps( y1, invFar ) ) );
+        }
+#endif
+        for ( ; i < count; i++ )
+        {
+            glm::vec3 center( view * glm::vec4( this->lightX[i], this->lightY[i], this->lightZ[i], 1.0f ) );
+            GLfloat r = this->lightRadius[i];
+            GLfloat invNear = 1.0f / std::max( -center.z - r, this->nearPlane ), invFar = 1.0f / std::max( -center.z + r, this->nearPlane );
+
+            this->centerX[i] = center.x;
+            this->centerY[i] = center.y;
+            this->depth[i] = -center.z;
+            this->ndcMinX[i] = std::min( ( center.x - r ) * projX * invNear, ( center.x - r ) * projX * invFar );
+            this->ndcMaxX[i] = std::max( ( center.x + r ) * projX * invNear, ( center.x + r ) * projX * invFar );
+            this->ndcMinY[i] = std::min( ( center.y - r ) * projY * invNear, ( center.y - r ) * projY * invFar );
+            this->ndcMaxY[i] = std::max( ( center.y + r ) * projY * invNear, ( center.y + r ) * projY * invFar );
+        }
+
+        // Rectangles and depth ranges to cluster coordinates
+        this->ranges.resize( count );
+        this->stats.visibleLights = 0;
+        for ( i = 0; i < count; i++ )
+        {
+            LightRange &range = this->ranges[i];
+            GLfloat r = this->lightRadius[i];
+            range.visible = this->depth[i] + r > this->nearPlane && this->depth[i] - r < this->farPlane &&
+                            this->ndcMaxX[i] > -1.0f && this->ndcMinX[i] < 1.0f && this->ndcMaxY[i] > -1.0f && this->ndcMinY[i] < 1.0f;
+            if( !range.visible )
+            {
+                continue;
+            }
+
+            range.minX = toCell( ( this->ndcMinX[i] * 0.5f + 0.5f ) * CLUSTER_GRID_X, CLUSTER_GRID_X );
+            range.maxX = toCell( ( this->ndcMaxX[i] * 0.5f + 0.5f ) * CLUSTER_GRID_X, CLUSTER_GRID_X );
+            range.minY = toCell( ( this->ndcMinY[i] * 0.5f + 0.5f ) * CLUSTER_GRID_Y, CLUSTER_GRID_Y );
+            range.maxY = toCell( ( this->ndcMaxY[i] * 0.5f + 0.5f ) * CLUSTER_GRID_Y, CLUSTER_GRID_Y );
+            range.minZ = toCell( this->sliceOf( this->depth[i] - r ), CLUSTER_GRID_Z );
+            range.maxZ = toCell( this->sliceOf( this->depth[i] + r ), CLUSTER_GRID_Z );
+            this->stats.visibleLights++;
+        }
+    }
+
+    GLfloat sliceOf( GLfloat depth ) const
+    {
+        return std::log( std::max( depth, this->nearPlane ) ) * this->depthScale + this->depthBias;
+    }
+
+    static GLubyte toCell( GLfloat coordinate, GLuint cells )
+    {
+        return ( GLubyte )std::min( std::max( coordinate, 0.0f ), ( GLfloat )( cells - 1 ) );
+    }
+
+    // Fills the light lists of one depth slice: every light whose range covers the slice is tested against the boxes
+    // of the clusters under its rectangle, so the corners of the rectangle a sphere doesn't reach stay empty
+    void assignSlice( GLuint z )
+    {
+        GLuint first = CLUSTER_GRID_X * CLUSTER_GRID_Y * z;
+        for ( GLuint i = 0; i < CLUSTER_GRID_X * CLUSTER_GRID_Y; i++ )
+        {
+            this->clusterLights[first + i].clear( );
+        }
+
+        for ( GLuint i = 0; i < this->lightCount; i++ )
+        {
+            const LightRange &range = this->ranges[i];
+            if( !range.visible || z < range.minZ || z > range.maxZ )
+            {
+                continue;
+            }
+
+            glm::vec3 center( this->centerX[i], this->centerY[i], this->depth[i] );
+            GLfloat radius2 = this->lightRadius[i] * this->lightRadius[i];
+            for ( GLuint y = range.minY; y <= range.maxY; y++ )
+            {
+                for ( GLuint x = range.minX; x <= range.maxX; x++ )
+                {
+                    GLuint index = first + x + CLUSTER_GRID_X * y;
+                    glm::vec3 d = center - glm::clamp( center, this->clusterMin[index], this->clusterMax[index] );
+                    if( glm::dot( d, d ) <= radius2 )
+                    {
+                        this->clusterLights[index].push_back( ( GLushort )i );
+                    }
+                }
+            }
+        }
+    }
+
+    // Replaces the contents of one of the buffers, orphaning the old storage so the upload doesn't wait for the GPU
+    void upload( GLuint buffer, const void *data, size_t size )
+    {
+        glBindBuffer( GL_TEXTURE_BUFFER, this->buffers[buffer] );
+        glBufferData( GL_TEXTURE_BUFFER, size, NULL, GL_STREAM_DRAW );
+        glBufferSubData( GL_TEXTURE_BUFFER, 0, size, data );
+        glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+    }
+
+    const ClusterUniforms &getUniforms( const Shader &shader ) const
+    {
+        for ( GLuint i = 0; i < this->uniforms.size( ); i++ )
+        {
+            if( this->uniforms[i].program == shader.ID )
+            {
+                return this->uniforms[i];
+            }
+        }
+
+        ClusterUniforms uniforms;
+        uniforms.program = shader.ID;
+        uniforms.tileScale = shader.GetUniform( "clusterTileScale" );
+        uniforms.depthParams = shader.GetUniform( "clusterDepthParams" );
+        uniforms.lightCount = shader.GetUniform( "lightCount" );
+        this->uniforms.push_back( uniforms );
+        return this->uniforms.back( );
+    }
+};
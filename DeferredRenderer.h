@@ -0,0 +1,346 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <iostream>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "StateTracker.h"
+#include "ClusteredLights.h"
+
+using namespace std;
+
+// Render targets of the G-buffer, in the order the geometry shaders write them (layout locations)
+enum GBufferTarget
+{
+    GBUFFER_POSITION = 0,   // RGBA32F: world position, shininess. Half floats would band far from the origin
+    GBUFFER_NORMAL,         // RGBA16F: world normal, 1 where something was drawn
+    GBUFFER_ALBEDO,         // RGBA8: diffuse color
+    GBUFFER_SPECULAR,       // RGBA8: specular color
+    GBUFFER_LIGHTING,       // RGBA16F: light accumulation, starts with the ambient term
+    GBUFFER_TARGET_COUNT
+};
+
+// Segments around the sphere drawn for each point light
+#define DEFERRED_LIGHT_VOLUME_SEGMENTS 12
+
+// Deferred shading: the geometry pass writes the surface attributes of every visible pixel into the G-buffer, then
+// each light is applied once per pixel it reaches instead of once per drawn fragment, so overdraw no longer multiplies
+// the lighting cost.
+//
+// A frame goes
+//     BeginGeometryPass( )     draw the scene with a G-buffer shader (modelLoading.vs + gbuffer.frag for models)
+//     ApplyFrameLight( )       the FrameUniforms light, one full screen pass
+//     ApplyPointLights( )      point lights as light volumes: spheres whose back faces lie behind the scene
+//     Resolve( )               the lit image and the depth go to the framebuffer that was bound at BeginGeometryPass
+// After Resolve( ) forward passes (lamps, transparent objects) can draw on top with a correct depth buffer.
+class DeferredRenderer
+{
+public:
+    /*  Functions   */
+    DeferredRenderer( GLsizei width, GLsizei height ) : FBO( 0 ), depthBuffer( 0 ), width( 0 ), height( 0 ), targetFBO( 0 ), blendWasEnabled( GL_FALSE ),
+        blendSource( GL_ONE ), blendDestination( GL_ZERO ), lightCapacity( 0 )
+    {
+        for ( GLuint i = 0; i < GBUFFER_TARGET_COUNT; i++ )
+        {
+            this->textures[i] = 0;
+        }
+        this->Resize( width, height );
+        this->createLightVolume( );
+        glGenVertexArrays( 1, &this->fullScreenVAO );
+    }
+
+    ~DeferredRenderer( )
+    {
+        this->release( );
+        glDeleteVertexArrays( 1, &this->fullScreenVAO );
+        glDeleteVertexArrays( 1, &this->sphereVAO );
+        glDeleteBuffers( 1, &this->sphereVBO );
+        glDeleteBuffers( 1, &this->sphereEBO );
+        glDeleteBuffers( 1, &this->lightVBO );
+    }
+
+    // Recreates the G-buffer, call it when the viewport changes size
+    bool Resize( GLsizei width, GLsizei height )
+    {
+        this->release( );
+        this->width = width;
+        this->height = height;
+
+        const GLenum formats[GBUFFER_TARGET_COUNT] = { GL_RGBA32F, GL_RGBA16F, GL_RGBA8, GL_RGBA8, GL_RGBA16F };
+        glGenFramebuffers( 1, &this->FBO );
+        glGenTextures( GBUFFER_TARGET_COUNT, this->textures );
+        glBindFramebuffer( GL_FRAMEBUFFER, this->FBO );
+        for ( GLuint i = 0; i < GBUFFER_TARGET_COUNT; i++ )
+        {
+            glBindTexture( GL_TEXTURE_2D, this->textures[i] );
+            glTexImage2D( GL_TEXTURE_2D, 0, formats[i], width, height, 0, GL_RGBA, GL_FLOAT, NULL );
+            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+            glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+            glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, this->textures[i], 0 );
+        }
+        glBindTexture( GL_TEXTURE_2D, 0 );
+        // The texture binding changed behind the tracker's back
+        GetStateTracker( ).Invalidate( );
+
+        // Same format as the default and headless framebuffers, so Resolve( ) can blit it
+        glGenRenderbuffers( 1, &this->depthBuffer );
+        glBindRenderbuffer( GL_RENDERBUFFER, this->depthBuffer );
+        glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height );
+        glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+        glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthBuffer );
+
+        bool complete = GL_FRAMEBUFFER_COMPLETE == glCheckFramebufferStatus( GL_FRAMEBUFFER );
+        if( !complete )
+        {
+            cout << "ERROR::DEFERRED_RENDERER:: G-buffer is not complete" << endl;
+        }
+        glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+        return complete;
+    }
+
+    // Binds and clears the G-buffer, background pixels get clearColor
+    void BeginGeometryPass( const glm::vec4 &clearColor )
+    {
+        GLint target = 0;
+        glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &target );
+        this->targetFBO = target;
+        this->blendWasEnabled = glIsEnabled( GL_BLEND );
+        glGetIntegerv( GL_BLEND_SRC_RGB, &this->blendSource );
+        glGetIntegerv( GL_BLEND_DST_RGB, &this->blendDestination );
+
+        glBindFramebuffer( GL_FRAMEBUFFER, this->FBO );
+        const GLenum buffers[GBUFFER_TARGET_COUNT] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4 };
+        glDrawBuffers( GBUFFER_TARGET_COUNT, buffers );
+
+        const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for ( GLint i = 0; i < GBUFFER_LIGHTING; i++ )
+        {
+            glClearBufferfv( GL_COLOR, i, zero );
+        }
+        glClearBufferfv( GL_COLOR, GBUFFER_LIGHTING, &clearColor.x );
+        glClear( GL_DEPTH_BUFFER_BIT );
+
+        // Blending would mix the attributes (the alpha channels hold data, not coverage)
+        glDisable( GL_BLEND );
+    }
+
+    // Adds the FrameUniforms light to every drawn pixel. shader is deferred.vs + deferredFrameLight.frag.
+    void ApplyFrameLight( Shader &shader )
+    {
+        this->beginLighting( shader );
+
+        glDisable( GL_DEPTH_TEST );
+        GetStateTracker( ).BindVertexArray( this->fullScreenVAO );
+        glDrawArrays( GL_TRIANGLES, 0, 3 );
+        glEnable( GL_DEPTH_TEST );
+    }
+
+    // Adds point lights, each one drawn as a sphere of its radius. shader is deferredPointLight.vs + .frag.
+    // Front faces are culled and the depth test keeps the back faces behind the scene, so a light only shades the
+    // pixels whose surface is in front of its far side, and it still works with the camera inside the sphere.
+    void ApplyPointLights( Shader &shader, const vector<PointLight> &lights )
+    {
+        if( lights.empty( ) )
+        {
+            return;
+        }
+
+        glBindBuffer( GL_ARRAY_BUFFER, this->lightVBO );
+        if( lights.size( ) > this->lightCapacity )
+        {
+            this->lightCapacity = lights.size( );
+        }
+        glBufferData( GL_ARRAY_BUFFER, this->lightCapacity * sizeof( PointLight ), NULL, GL_STREAM_DRAW );
+        glBufferSubData( GL_ARRAY_BUFFER, 0, lights.size( ) * sizeof( PointLight ), &lights[0] );
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+        this->beginLighting( shader );
+
+        glDepthMask( GL_FALSE );
+        glDepthFunc( GL_GEQUAL );
+        glEnable( GL_CULL_FACE );
+        glCullFace( GL_FRONT );
+
+        GetStateTracker( ).BindVertexArray( this->sphereVAO );
+        glDrawElementsInstanced( GL_TRIANGLES, this->sphereIndexCount, GL_UNSIGNED_SHORT, 0, ( GLsizei )lights.size( ) );
+
+        glCullFace( GL_BACK );
+        glDisable( GL_CULL_FACE );
+        glDepthFunc( GL_LESS );
+        glDepthMask( GL_TRUE );
+    }
+
+    // Copies the lit image and the depth to the framebuffer bound at BeginGeometryPass( ) and makes it current again
+    void Resolve( )
+    {
+        glBindFramebuffer( GL_READ_FRAMEBUFFER, this->FBO );
+        glReadBuffer( GL_COLOR_ATTACHMENT0 + GBUFFER_LIGHTING );
+        glBindFramebuffer( GL_DRAW_FRAMEBUFFER, this->targetFBO );
+        glBlitFramebuffer( 0, 0, this->width, this->height, 0, 0, this->width, this->height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+        glBlitFramebuffer( 0, 0, this->width, this->height, 0, 0, this->width, this->height, GL_DEPTH_BUFFER_BIT, GL_NEAREST );
+        glBindFramebuffer( GL_FRAMEBUFFER, this->targetFBO );
+
+        if( this->blendWasEnabled )
+        {
+            glEnable( GL_BLEND );
+        }
+        else
+        {
+            glDisable( GL_BLEND );
+        }
+        glBlendFunc( this->blendSource, this->blendDestination );
+    }
+
+    GLuint GetTexture( GBufferTarget target ) const
+    {
+        return this->textures[target];
+    }
+
+    // GPU memory of the G-buffer
+    GLsizeiptr GetMemoryUsage( ) const
+    {
+        // A 16 byte target, two 8 byte ones, two 4 byte ones and the depth
+        return ( GLsizeiptr )this->width * this->height * ( 16 + 2 * 8 + 2 * 4 + 4 );
+    }
+
+private:
+    /*  Render Data  */
+    GLuint FBO;
+    GLuint textures[GBUFFER_TARGET_COUNT];
+    GLuint depthBuffer;
+    GLsizei width, height;
+    GLuint targetFBO;               // Bound when the frame began, the result goes there
+    GLboolean blendWasEnabled;      // Blending state of the forward passes, put back by Resolve( )
+    GLint blendSource, blendDestination;
+
+    GLuint fullScreenVAO;           // No attributes, deferred.vs makes the triangle from gl_VertexID
+    GLuint sphereVAO, sphereVBO, sphereEBO;
+    GLsizei sphereIndexCount;
+    GLuint lightVBO;                // Per instance PointLight data of the light volumes
+    size_t lightCapacity;
+
+    struct GBufferUniforms
+    {
+        GLuint program;
+        UniformHandle samplers[GBUFFER_LIGHTING];
+    };
+    mutable vector<GBufferUniforms> uniforms;   // One per lighting shader
+
+    DeferredRenderer( const DeferredRenderer & );
+    DeferredRenderer &operator=( const DeferredRenderer & );
+
+    /*  Functions   */
+    void release( )
+    {
+        if( 0 != this->FBO )
+        {
+            glDeleteFramebuffers( 1, &this->FBO );
+            glDeleteTextures( GBUFFER_TARGET_COUNT, this->textures );
+            glDeleteRenderbuffers( 1, &this->depthBuffer );
+            this->FBO = this->depthBuffer = 0;
+        }
+    }
+
+    // Draws into the light accumulation target only, adding to it, with the G-buffer bound for reading
+    void beginLighting( Shader &shader )
+    {
+        glDrawBuffer( GL_COLOR_ATTACHMENT0 + GBUFFER_LIGHTING );
+        glEnable( GL_BLEND );
+        glBlendFunc( GL_ONE, GL_ONE );
+
+        shader.use( );
+        const GBufferUniforms &uniforms = this->getUniforms( shader );
+        for ( GLuint i = 0; i < GBUFFER_LIGHTING; i++ )
+        {
+            GetStateTracker( ).BindTexture( i, this->textures[i] );
+            shader.setSampler( uniforms.samplers[i], i );
+        }
+    }
+
+    // Unit sphere, slightly larger than the radius so its flat faces never cut into the lit volume
+    void createLightVolume( )
+    {
+        const GLuint segments = DEFERRED_LIGHT_VOLUME_SEGMENTS, rings = DEFERRED_LIGHT_VOLUME_SEGMENTS / 2;
+        const GLfloat pi = 3.14159265f;
+        GLfloat scale = 1.0f / ( std::cos( pi / segments ) * std::cos( pi / ( 2 * rings ) ) );
+
+        vector<glm::vec3> positions;
+        for ( GLuint ring = 0; ring <= rings; ring++ )
+        {
+            GLfloat phi = pi * ring / rings;
+            for ( GLuint segment = 0; segment <= segments; segment++ )
+            {
+                GLfloat theta = 2.0f * pi * segment / segments;
+                positions.push_back( scale * glm::vec3( std::sin( phi ) * std::cos( theta ), std::cos( phi ), std::sin( phi ) * std::sin( theta ) ) );
+            }
+        }
+        vector<GLushort> indices;
+        for ( GLuint ring = 0; ring < rings; ring++ )
+        {
+            for ( GLuint segment = 0; segment < segments; segment++ )
+            {
+                GLushort a = ( GLushort )( ring * ( segments + 1 ) + segment ), b = ( GLushort )( a + segments + 1 );
+                // Counter clockwise seen from outside
+                indices.push_back( a );
+                indices.push_back( a + 1 );
+                indices.push_back( b );
+                indices.push_back( b );
+                indices.push_back( a + 1 );
+                indices.push_back( b + 1 );
+            }
+        }
+        this->sphereIndexCount = ( GLsizei )indices.size( );
+
+        glGenVertexArrays( 1, &this->sphereVAO );
+        glGenBuffers( 1, &this->sphereVBO );
+        glGenBuffers( 1, &this->sphereEBO );
+        glGenBuffers( 1, &this->lightVBO );
+
+        glBindVertexArray( this->sphereVAO );
+        glBindBuffer( GL_ARRAY_BUFFER, this->sphereVBO );
+        glBufferData( GL_ARRAY_BUFFER, positions.size( ) * sizeof( glm::vec3 ), &positions[0], GL_STATIC_DRAW );
+        glEnableVertexAttribArray( 0 );
+        glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof( glm::vec3 ), ( GLvoid * )0 );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, this->sphereEBO );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices.size( ) * sizeof( GLushort ), &indices[0], GL_STATIC_DRAW );
+
+        // Position and radius, then color and intensity of each light
+        glBindBuffer( GL_ARRAY_BUFFER, this->lightVBO );
+        glEnableVertexAttribArray( 4 );
+        glVertexAttribPointer( 4, 4, GL_FLOAT, GL_FALSE, sizeof( PointLight ), ( GLvoid * )0 );
+        glVertexAttribDivisor( 4, 1 );
+        glEnableVertexAttribArray( 5 );
+        glVertexAttribPointer( 5, 4, GL_FLOAT, GL_FALSE, sizeof( PointLight ), ( GLvoid * )( 4 * sizeof( GLfloat ) ) );
+        glVertexAttribDivisor( 5, 1 );
+
+        glBindVertexArray( 0 );
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        GetStateTracker( ).Invalidate( );
+    }
+
+    const GBufferUniforms &getUniforms( const Shader &shader ) const
+    {
+        for ( GLuint i = 0; i < this->uniforms.size( ); i++ )
+        {
+            if( this->uniforms[i].program == shader.ID )
+            {
+                return this->uniforms[i];
+            }
+        }
+
+        const char *names[GBUFFER_LIGHTING] = { "gPosition", "gNormal", "gAlbedo", "gSpecular" };
+        GBufferUniforms uniforms;
+        uniforms.program = shader.ID;
+        for ( GLuint i = 0; i < GBUFFER_LIGHTING; i++ )
+        {
+            uniforms.samplers[i] = shader.GetUniform( names[i] );
+        }
+        this->uniforms.push_back( uniforms );
+        return this->uniforms.back( );
+    }
+};
@@ -0,0 +1,114 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+// Uniform buffer binding point of the per frame block. Every Shader binds a block named "FrameUniforms" to it
+// after linking, so the data is uploaded once per frame no matter how many programs read it.
+#define FRAME_UNIFORMS_BINDING 0
+
+// Counts uniform uploads so the demos can report how many happen per frame. Reset it at the start of a frame.
+struct UniformUploadStats
+{
+    GLuint uniformCalls;   // glUniform* issued through the Shader setters
+    GLuint bufferUpdates;  // Uniform buffer updates (FrameUniforms::Update)
+};
+
+inline UniformUploadStats &GetUniformUploadStats( )
+{
+    static UniformUploadStats stats = { 0, 0 };
+    return stats;
+}
+
+// CPU mirror of the block, laid out as std140:
+//
+// layout (std140) uniform FrameUniforms
+// {
+//     mat4 view;
+//     mat4 projection;
+//     mat4 viewProjection;
+//     vec4 cameraPosition;   // xyz
+//     vec4 lightPosition;    // xyz, w is 0 for a directional light (xyz is then the direction toward it)
+//     vec4 lightColor;       // rgb
+// };
+struct FrameUniformData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPosition;
+    glm::vec4 lightPosition;
+    glm::vec4 lightColor;
+};
+
+class FrameUniforms
+{
+public:
+    /*  Functions   */
+    // Creates the buffer and attaches it to FRAME_UNIFORMS_BINDING
+    FrameUniforms( )
+    {
+        glGenBuffers( 1, &this->UBO );
+        glBindBuffer( GL_UNIFORM_BUFFER, this->UBO );
+        glBufferData( GL_UNIFORM_BUFFER, sizeof( FrameUniformData ), NULL, GL_DYNAMIC_DRAW );
+        glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+
+        glBindBufferBase( GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, this->UBO );
+    }
+
+    ~FrameUniforms( )
+    {
+        glDeleteBuffers( 1, &this->UBO );
+    }
+
+    // Uploads the camera and light data of this frame in a single buffer update. A directional light (the sun) passes
+    // the direction toward it as lightPosition; shaders get w = 0 and light every point from that direction.
+    void Update( const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &cameraPosition,
+                 const glm::vec3 &lightPosition = glm::vec3( 0.0f ), const glm::vec3 &lightColor = glm::vec3( 1.0f ), bool directionalLight = false )
+    {
+        FrameUniformData data;
+        data.view = view;
+        data.projection = projection;
+        data.viewProjection = projection * view;
+        data.cameraPosition = glm::vec4( cameraPosition, 1.0f );
+        data.lightPosition = glm::vec4( directionalLight ? glm::normalize( lightPosition ) : lightPosition, directionalLight ? 0.0f : 1.0f );
+        data.lightColor = glm::vec4( lightColor, 1.0f );
+
+        this->upload( data );
+    }
+
+    // Update( ) from the matrices camera has cached, so nothing is multiplied again when it didn't move
+    void Update( Camera &camera, const glm::vec3 &lightPosition = glm::vec3( 0.0f ), const glm::vec3 &lightColor = glm::vec3( 1.0f ), bool directionalLight = false )
+    {
+        FrameUniformData data;
+        data.view = camera.GetviewMatrix( );
+        data.projection = camera.GetProjectionMatrix( );
+        data.viewProjection = camera.GetViewProjectionMatrix( );
+        data.cameraPosition = glm::vec4( camera.GetPosition( ), 1.0f );
+        data.lightPosition = glm::vec4( directionalLight ? glm::normalize( lightPosition ) : lightPosition, directionalLight ? 0.0f : 1.0f );
+        data.lightColor = glm::vec4( lightColor, 1.0f );
+
+        this->upload( data );
+    }
+
+private:
+    GLuint UBO;
+
+    void upload( const FrameUniformData &data )
+    {
+        glBindBuffer( GL_UNIFORM_BUFFER, this->UBO );
+        glBufferSubData( GL_UNIFORM_BUFFER, 0, sizeof( data ), &data );
+        glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+
+        GetUniformUploadStats( ).bufferUpdates++;
+    }
+
+    FrameUniforms( const FrameUniforms & );
+    FrameUniforms &operator=( const FrameUniforms & );
+};
+
+#endif
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// 4 and 8 wide batch culling, picked at compile time (/arch:AVX or -mavx for the 8 wide one)
+#if defined( __AVX__ )
+#include <immintrin.h>
+#define FRUSTUM_SIMD_WIDTH 8
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define FRUSTUM_SIMD_WIDTH 4
+#else
+#define FRUSTUM_SIMD_WIDTH 1
+#endif
+
+using namespace std;
+
+struct AABB
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+
+    glm::vec3 GetCenter( ) const
+    {
+        return ( this->Min + this->Max ) * 0.5f;
+    }
+
+    glm::vec3 GetExtents( ) const
+    {
+        return ( this->Max - this->Min ) * 0.5f;
+    }
+};
+
+struct BoundingSphere
+{
+    glm::vec3 Center;
+    GLfloat Radius;
+};
+
+// Bounds of a vertex range: the box, and a sphere centered on the box that encloses every vertex
+template <typename VertexType>
+void ComputeBounds( const VertexType *vertices, GLuint vertexCount, AABB &box, BoundingSphere &sphere )
+{
+    if( 0 == vertexCount )
+    {
+        box.Min = box.Max = sphere.Center = glm::vec3( 0.0f );
+        sphere.Radius = 0.0f;
+        return;
+    }
+
+    box.Min = box.Max = vertices[0].Position;
+    for ( GLuint i = 1; i < vertexCount; i++ )
+    {
+        box.Min = glm::min( box.Min, vertices[i].Position );
+        box.Max = glm::max( box.Max, vertices[i].Position );
+    }
+
+    sphere.Center = box.GetCenter( );
+    GLfloat radius2 = 0.0f;
+    for ( GLuint i = 0; i < vertexCount; i++ )
+    {
+        glm::vec3 d = vertices[i].Position - sphere.Center;
+        radius2 = std::max( radius2, glm::dot( d, d ) );
+    }
+    sphere.Radius = std::sqrt( radius2 );
+}
+
+// Boxes in center/extents form stored as a structure of arrays, so the culler loads 4 or 8 of them per instruction
+class BoundsArray
+{
+public:
+    vector<GLfloat> CenterX, CenterY, CenterZ;
+    vector<GLfloat> ExtentX, ExtentY, ExtentZ;
+
+    void Add( const AABB &box )
+    {
+        glm::vec3 center = box.GetCenter( );
+        glm::vec3 extents = box.GetExtents( );
+
+        this->CenterX.push_back( center.x );
+        this->CenterY.push_back( center.y );
+        this->CenterZ.push_back( center.z );
+        this->ExtentX.push_back( extents.x );
+        this->ExtentY.push_back( extents.y );
+        this->ExtentZ.push_back( extents.z );
+    }
+
+    void Reserve( size_t count )
+    {
+        this->CenterX.reserve( count );
+        this->CenterY.reserve( count );
+        this->CenterZ.reserve( count );
+        this->ExtentX.reserve( count );
+        this->ExtentY.reserve( count );
+        this->ExtentZ.reserve( count );
+    }
+
+    void Clear( )
+    {
+        this->CenterX.clear( );
+        this->CenterY.clear( );
+        this->CenterZ.clear( );
+        this->ExtentX.clear( );
+        this->ExtentY.clear( );
+        this->ExtentZ.clear( );
+    }
+
+    size_t Size( ) const
+    {
+        return this->CenterX.size( );
+    }
+};
+
+// Visible and culled counts of the last culling pass
+struct CullStats
+{
+    GLuint visible;
+    GLuint culled;
+};
+
+// The six planes of a view volume, extracted from a combined matrix (Gribb & Hartmann).
+// From projection * view the planes are in world space; from projection * view * model they are in that model's
+// local space, which lets the bounds of a mesh be tested without transforming them.
+// Planes point inwards: a point p is inside when dot( plane.xyz, p ) + plane.w >= 0 for all six.
+class Frustum
+{
+public:
+    enum Plane
+    {
+        LEFT_PLANE = 0,
+        RIGHT_PLANE,
+        BOTTOM_PLANE,
+        TOP_PLANE,
+        NEAR_PLANE,
+        FAR_PLANE
+    };
+
+    glm::vec4 Planes[6];
+
+    /*  Functions   */
+    Frustum( )
+    {
+        for ( int i = 0; i < 6; i++ )
+        {
+            this->Planes[i] = glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f ); // Everything is inside
+        }
+    }
+
+    explicit Frustum( const glm::mat4 &viewProjection )
+    {
+        // GLM is column major: row i of the matrix is ( m[0][i], m[1][i], m[2][i], m[3][i] )
+        glm::vec4 row[4];
+        for ( int i = 0; i < 4; i++ )
+        {
+            row[i] = glm::vec4( viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] );
+        }
+
+        this->Planes[LEFT_PLANE] = row[3] + row[0];
+        this->Planes[RIGHT_PLANE] = row[3] - row[0];
+        this->Planes[BOTTOM_PLANE] = row[3] + row[1];
+        this->Planes[TOP_PLANE] = row[3] - row[1];
+        this->Planes[NEAR_PLANE] = row[3] + row[2];
+        this->Planes[FAR_PLANE] = row[3] - row[2];
+
+        for ( int i = 0; i < 6; i++ )
+        {
+            GLfloat length = glm::length( glm::vec3( this->Planes[i] ) );
+            if( length > 0.0f )
+            {
+                this->Planes[i] /= length;
+            }
+        }
+    }
+
+    bool IsBoxVisible( const AABB &box ) const
+    {
+        glm::vec3 center = box.GetCenter( );
+        glm::vec3 extents = box.GetExtents( );
+
+        for ( int i = 0; i < 6; i++ )
+        {
+            glm::vec3 normal( this->Planes[i] );
+            GLfloat distance = glm::dot( normal, center ) + this->Planes[i].w;
+            GLfloat radius = glm::dot( glm::abs( normal ), extents );
+
+            if( distance + radius < 0.0f )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool IsSphereVisible( const BoundingSphere &sphere ) const
+    {
+        for ( int i = 0; i < 6; i++ )
+        {
+            if( glm::dot( glm::vec3( this->Planes[i] ), sphere.Center ) + this->Planes[i].w < -sphere.Radius )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Tests every box and appends the indices of the ones touching the frustum to visible.
+    // Conservative: a box crossing a corner outside the frustum may be reported as visible.
+    CullStats CullBoxes( const BoundsArray &bounds, vector<GLuint> &visible ) const
+    {
+        size_t count = bounds.Size( );
+        size_t first = visible.size( );
+        size_t i = 0;
+
+#if FRUSTUM_SIMD_WIDTH == 8
+        __m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+        for ( int p = 0; p < 6; p++ )
+        {
+            px[p] = _mm256_set1_ps( this->Planes[p].x );
+            py[p] = _mm256_set1_ps( this->Planes[p].y );
+            pz[p] = _mm256_set1_ps( this->Planes[p].z );
+            pw[p] = _mm256_set1_ps( this->Planes[p].w );
+            ax[p] = _mm256_set1_ps( std::fabs( this->Planes[p].x ) );
+            ay[p] = _mm256_set1_ps( std::fabs( this->Planes[p].y ) );
+            az[p] = _mm256_set1_ps( std::fabs( this->Planes[p].z ) );
+        }
+
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            __m256 cx = _mm256_loadu_ps( &bounds.CenterX[i] );
+            __m256 cy = _mm256_loadu_ps( &bounds.CenterY[i] );
+            __m256 cz = _mm256_loadu_ps( &bounds.CenterZ[i] );
+            __m256 ex = _mm256_loadu_ps( &bounds.ExtentX[i] );
+            __m256 ey = _mm256_loadu_ps( &bounds.ExtentY[i] );
+            __m256 ez = _mm256_loadu_ps( &bounds.ExtentZ[i] );
+            __m256 outside = _mm256_setzero_ps( );
+
+            for ( int p = 0; p < 6; p++ )
+            {
+                // distance + projected radius, negative when the box is entirely behind the plane
+                __m256 d = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( px[p], cx ), _mm256_mul_ps( py[p], cy ) ), _mm256_mul_ps( pz[p], cz ) ), pw[p] );
+                __m256 r = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ax[p], ex ), _mm256_mul_ps( ay[p], ey ) ), _mm256_mul_ps( az[p], ez ) );
+                outside = _mm256_or_ps( outside, _mm256_cmp_ps( _mm256_add_ps( d, r ), _mm256_setzero_ps( ), _CMP_LT_OQ ) );
+            }
+
+            int mask = ~_mm256_movemask_ps( outside ) & 0xFF;
+            for ( ; mask; mask &= mask - 1 )
+            {
+                visible.push_back( ( GLuint )( i + lowestBit( mask ) ) );
+            }
+        }
+#elif FRUSTUM_SIMD_WIDTH == 4
+        __m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+        for ( int p = 0; p < 6; p++ )
+        {
+            px[p] = _mm_set1_ps( this->Planes[p].x );
+            py[p] = _mm_set1_ps( this->Planes[p].y );
+            pz[p] = _mm_set1_ps( this->Planes[p].z );
+            pw[p] = _mm_set1_ps( this->Planes[p].w );
+            ax[p] = _mm_set1_ps( std::fabs( this->Planes[p].x ) );
+            ay[p] = _mm_set1_ps( std::fabs( this->Planes[p].y ) );
+            az[p] = _mm_set1_ps( std::fabs( this->Planes[p].z ) );
+        }
+
+        for ( ; i + 4 <= count; i += 4 )
+        {
+            __m128 cx = _mm_loadu_ps( &bounds.CenterX[i] );
+            __m128 cy = _mm_loadu_ps( &bounds.CenterY[i] );
+            __m128 cz = _mm_loadu_ps( &bounds.CenterZ[i] );
+            __m128 ex = _mm_loadu_ps( &bounds.ExtentX[i] );
+            __m128 ey = _mm_loadu_ps( &bounds.ExtentY[i] );
+            __m128 ez = _mm_loadu_ps( &bounds.ExtentZ[i] );
+            __m128 outside = _mm_setzero_ps( );
+
+            for ( int p = 0; p < 6; p++ )
+            {
+                // distance + projected radius, negative when the box is entirely behind the plane
+                __m128 d = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( px[p], cx ), _mm_mul_ps( py[p], cy ) ), _mm_mul_ps( pz[p], cz ) ), pw[p] );
+                __m128 r = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax[p], ex ), _mm_mul_ps( ay[p], ey ) ), _mm_mul_ps( az[p], ez ) );
+                outside = _mm_or_ps( outside, _mm_cmplt_ps( _mm_add_ps( d, r ), _mm_setzero_ps( ) ) );
+            }
+
+            int mask = ~_mm_movemask_ps( outside ) & 0xF;
+            for ( ; mask; mask &= mask - 1 )
+            {
+                visible.push_back( ( GLuint )( i + lowestBit( mask ) ) );
+            }
+        }
+#endif
+
+        // Whatever doesn't fill a whole SIMD batch
+        for ( ; i < count; i++ )
+        {
+            AABB box;
+            glm::vec3 center( bounds.CenterX[i], bounds.CenterY[i], bounds.CenterZ[i] );
+            glm::vec3 extents( bounds.ExtentX[i], bounds.ExtentY[i], bounds.ExtentZ[i] );
+            box.Min = center - extents;
+            box.Max = center + extents;
+
+            if( this->IsBoxVisible( box ) )
+            {
+                visible.push_back( ( GLuint )i );
+            }
+        }
+
+        CullStats stats;
+        stats.visible = ( GLuint )( visible.size( ) - first );
+        stats.culled = ( GLuint )count - stats.visible;
+
+        return stats;
+    }
+
+private:
+    static int lowestBit( int mask )
+    {
+        int bit = 0;
+        while ( 0 == ( mask & ( 1 << bit ) ) )
+        {
+            bit++;
+        }
+        return bit;
+    }
+};
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Mesh.h"
+#include "VertexFormat.h"
+#include "StateTracker.h"
+
+// Draw submission counters, reset them at the start of a frame to get per frame numbers. Only VAO binds that reached
+// GL are counted.
+struct DrawStats
+{
+    GLuint vaoBinds;
+    GLuint drawCalls;
+};
+
+inline DrawStats &GetDrawStats( )
+{
+    static DrawStats stats = { 0, 0 };
+    return stats;
+}
+
+// Most vertices a mesh may have to be drawn with 16 bit indices
+#define MAX_SHORT_INDEX_VERTICES 65536
+
+// Bytes of one index of GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+inline GLsizei GetIndexSize( GLenum indexType )
+{
+    return ( GL_UNSIGNED_SHORT == indexType ) ? sizeof( GLushort ) : sizeof( GLuint );
+}
+
+// One VAO, one vertex buffer and one index buffer holding the geometry of many meshes.
+// Each mesh is a range of the buffers: its indices start at firstIndex and are relative to its own vertices, which
+// start at baseVertex, so they are drawn unchanged with glDrawElementsBaseVertex while the VAO stays bound.
+// Usage: Allocate( ) the totals once, Append( ) every mesh, then Bind( ) once per frame and Draw( ) each range.
+// The vertices are stored as Vertex or, allocated with VERTEX_FORMAT_COMPACT, quantized to a CompactVertex on Append( );
+// either way the shader gets its position decode from SetPositionUniforms( ). Indices are stored as 16 bit when
+// allocated with GL_UNSIGNED_SHORT, which needs every appended mesh to have at most MAX_SHORT_INDEX_VERTICES vertices.
+class GeometryArena
+{
+public:
+    struct Range
+    {
+        GLint baseVertex;
+        GLuint firstIndex;
+        GLuint indexCount;
+    };
+
+    /*  Functions   */
+    GeometryArena( ) : VAO( 0 ), VBO( 0 ), EBO( 0 ), vertexCapacity( 0 ), indexCapacity( 0 ), vertexCount( 0 ), indexCount( 0 ),
+        format( VERTEX_FORMAT_FLOAT ), indexType( GL_UNSIGNED_INT ), positionOffset( 0.0f ), positionScale( 1.0f )
+    {
+    }
+
+    ~GeometryArena( )
+    {
+        this->release( );
+    }
+
+    // Creates the buffers, sized for the given totals, and the VAO describing the Vertex layout
+    void Allocate( GLuint totalVertices, GLuint totalIndices )
+    {
+        AABB bounds;
+        bounds.Min = glm::vec3( 0.0f );
+        bounds.Max = glm::vec3( 1.0f );
+        this->Allocate( totalVertices, totalIndices, VERTEX_FORMAT_FLOAT, bounds );
+    }
+
+    // Same for a vertex format and index type. Compact positions are quantized within positionBounds, which must hold
+    // every vertex appended later (Model passes the union of its meshes' bounds).
+    void Allocate( GLuint totalVertices, GLuint totalIndices, VertexFormat format, const AABB &positionBounds, GLenum indexType = GL_UNSIGNED_INT )
+    {
+        this->release( );
+
+        this->vertexCapacity = totalVertices;
+        this->indexCapacity = totalIndices;
+        this->vertexCount = 0;
+        this->indexCount = 0;
+        this->format = format;
+        this->indexType = indexType;
+        this->positionBounds = positionBounds;
+        // Float positions are used as they are
+        this->positionOffset = ( VERTEX_FORMAT_COMPACT == format ) ? positionBounds.Min : glm::vec3( 0.0f );
+        this->positionScale = ( VERTEX_FORMAT_COMPACT == format ) ? positionBounds.Max - positionBounds.Min : glm::vec3( 1.0f );
+        GLsizei stride = GetVertexSize( format );
+
+        glGenVertexArrays( 1, &this->VAO );
+        glGenBuffers( 1, &this->VBO );
+        glGenBuffers( 1, &this->EBO );
+
+        // Through the tracker, so its idea of the current VAO stays right
+        GetStateTracker( ).BindVertexArray( this->VAO );
+        glBindBuffer( GL_ARRAY_BUFFER, this->VBO );
+        glBufferData( GL_ARRAY_BUFFER, totalVertices * stride, NULL, GL_STATIC_DRAW );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, this->EBO );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, totalIndices * GetIndexSize( indexType ), NULL, GL_STATIC_DRAW );
+
+        // Set the vertex attribute pointers
+        glEnableVertexAttribArray( 0 );
+        glEnableVertexAttribArray( 1 );
+        glEnableVertexAttribArray( 2 );
+        if( VERTEX_FORMAT_COMPACT == format )
+        {
+            // Vertex Positions, [0, 1] within the bounds
+            glVertexAttribPointer( 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, ( GLvoid * )offsetof( CompactVertex, Position ) );
+            // Vertex Normals, packed formats always have 4 components
+            glVertexAttribPointer( 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, ( GLvoid * )offsetof( CompactVertex, Normal ) );
+            // Vertex Texture Coords
+            glVertexAttribPointer( 2, 2, GL_HALF_FLOAT, GL_FALSE, stride, ( GLvoid * )offsetof( CompactVertex, TexCoords ) );
+        }
+        else
+        {
+            // Vertex Positions
+            glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, stride, ( GLvoid * )0 );
+            // Vertex Normals
+            glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, stride, ( GLvoid * )offsetof( Vertex, Normal ) );
+            // Vertex Texture Coords
+            glVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, stride, ( GLvoid * )offsetof( Vertex, TexCoords ) );
+        }
+
+        GetStateTracker( ).BindVertexArray( 0 );
+    }
+
+    // Copies a mesh's geometry into the next free part of the buffers and returns where it landed
+    Range Append( const Vertex *vertices, GLuint vertexCount, const GLuint *indices, GLuint indexCount )
+    {
+        Range range;
+        range.baseVertex = ( GLint )this->vertexCount;
+        range.firstIndex = this->indexCount;
+        range.indexCount = indexCount;
+
+        if( this->vertexCount + vertexCount > this->vertexCapacity || this->indexCount + indexCount > this->indexCapacity )
+        {
+            cout << "ERROR::GEOMETRY_ARENA:: Out of space, Allocate( ) was given smaller totals" << endl;
+            range.indexCount = 0;
+            return range;
+        }
+        if( GL_UNSIGNED_SHORT == this->indexType && vertexCount > MAX_SHORT_INDEX_VERTICES )
+        {
+            cout << "ERROR::GEOMETRY_ARENA:: A mesh of " << vertexCount << " vertices does not fit 16 bit indices" << endl;
+            range.indexCount = 0;
+            return range;
+        }
+
+        if( vertexCount > 0 )
+        {
+            GLsizei stride = GetVertexSize( this->format );
+            const GLvoid *data = vertices;
+            if( VERTEX_FORMAT_COMPACT == this->format )
+            {
+                this->compressed.resize( vertexCount );
+                for ( GLuint i = 0; i < vertexCount; i++ )
+                {
+                    this->compressed[i] = CompressVertex( vertices[i], this->positionBounds );
+                }
+                data = &this->compressed[0];
+            }
+
+            glBindBuffer( GL_ARRAY_BUFFER, this->VBO );
+            glBufferSubData( GL_ARRAY_BUFFER, this->vertexCount * stride, vertexCount * stride, data );
+            glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        }
+        this->uploadIndices( indices, indexCount );
+
+        this->vertexCount += vertexCount;
+
+        return range;
+    }
+
+    // Appends another index list for the vertices of an appended range (e.g. a coarser level of detail of the same
+    // mesh) and returns it as a range of its own
+    Range AppendIndices( const Range &vertexRange, const GLuint *indices, GLuint indexCount )
+    {
+        Range range;
+        range.baseVertex = vertexRange.baseVertex;
+        range.firstIndex = this->indexCount;
+        range.indexCount = indexCount;
+
+        if( this->indexCount + indexCount > this->indexCapacity )
+        {
+            cout << "ERROR::GEOMETRY_ARENA:: Out of space, Allocate( ) was given smaller totals" << endl;
+            range.indexCount = 0;
+            return range;
+        }
+        this->uploadIndices( indices, indexCount );
+
+        return range;
+    }
+
+    void Bind( ) const
+    {
+        if( GetStateTracker( ).BindVertexArray( this->VAO ) )
+        {
+            GetDrawStats( ).vaoBinds++;
+        }
+    }
+
+    void Unbind( ) const
+    {
+        GetStateTracker( ).BindVertexArray( 0 );
+    }
+
+    GLuint GetVertexArray( ) const
+    {
+        return this->VAO;
+    }
+
+    // Sets the shader's positionOffset and positionScale uniforms, which turn the stored positions back into model
+    // space (offset 0 and scale 1 for float vertices). Programs keep uniform values, so call it whenever the arena
+    // is drawn with a program that last drew another arena.
+    void SetPositionUniforms( const Shader &shader ) const
+    {
+        const PositionUniforms &uniforms = this->getPositionUniforms( shader );
+        shader.setVec3( uniforms.offset, this->positionOffset );
+        shader.setVec3( uniforms.scale, this->positionScale );
+    }
+
+    VertexFormat GetVertexFormat( ) const
+    {
+        return this->format;
+    }
+
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum GetIndexType( ) const
+    {
+        return this->indexType;
+    }
+
+    // Draws one range, the arena must be bound
+    void Draw( const Range &range ) const
+    {
+        glDrawElementsBaseVertex( GL_TRIANGLES, range.indexCount, this->indexType, ( GLvoid * )( ( size_t )range.firstIndex * GetIndexSize( this->indexType ) ), range.baseVertex );
+        GetDrawStats( ).drawCalls++;
+    }
+
+    // GL objects owned by the arena (VAO, vertex and index buffer)
+    GLuint GetObjectCount( ) const
+    {
+        return ( 0 != this->VAO ) ? 3 : 0;
+    }
+
+    // Bytes of buffer storage allocated for vertices and indices
+    GLsizeiptr GetMemoryUsage( ) const
+    {
+        return this->GetVertexBytes( ) + this->GetIndexBytes( );
+    }
+
+    GLsizeiptr GetVertexBytes( ) const
+    {
+        return ( GLsizeiptr )this->vertexCapacity * GetVertexSize( this->format );
+    }
+
+    GLsizeiptr GetIndexBytes( ) const
+    {
+        return ( GLsizeiptr )this->indexCapacity * GetIndexSize( this->indexType );
+    }
+
+private:
+    GLuint VAO, VBO, EBO;
+    GLuint vertexCapacity, indexCapacity;
+    GLuint vertexCount, indexCount;
+    VertexFormat format;
+    GLenum indexType;
+    AABB positionBounds;
+    glm::vec3 positionOffset, positionScale;
+    vector<CompactVertex> compressed;       // Scratch of Append( ) for compact vertices
+    vector<GLushort> shortIndices;          // and for 16 bit indices
+
+    // Position decode uniforms of one program
+    struct PositionUniforms
+    {
+        GLuint program;
+        UniformHandle offset;
+        UniformHandle scale;
+    };
+    mutable vector<PositionUniforms> positionUniforms;  // One per shader the arena was drawn with
+
+    GeometryArena( const GeometryArena & );
+    GeometryArena &operator=( const GeometryArena & );
+
+    void release( )
+    {
+        if( 0 != this->VAO )
+        {
+            glDeleteVertexArrays( 1, &this->VAO );
+            glDeleteBuffers( 1, &this->VBO );
+            glDeleteBuffers( 1, &this->EBO );
+            this->VAO = this->VBO = this->EBO = 0;
+        }
+        vector<CompactVertex>( ).swap( this->compressed );
+        vector<GLushort>( ).swap( this->shortIndices );
+    }
+
+    // Copies indices to the end of the index buffer, narrowing them to 16 bit if that's the arena's type
+    void uploadIndices( const GLuint *indices, GLuint indexCount )
+    {
+        if( 0 == indexCount )
+        {
+            return;
+        }
+
+        GLsizei indexSize = GetIndexSize( this->indexType );
+        const GLvoid *data = indices;
+        if( GL_UNSIGNED_SHORT == this->indexType )
+        {
+            this->shortIndices.resize( indexCount );
+            for ( GLuint i = 0; i < indexCount; i++ )
+            {
+                this->shortIndices[i] = ( GLushort )indices[i];
+            }
+            data = &this->shortIndices[0];
+        }
+
+        // The element buffer binding is VAO state, so upload through the copy target instead
+        glBindBuffer( GL_COPY_WRITE_BUFFER, this->EBO );
+        glBufferSubData( GL_COPY_WRITE_BUFFER, this->indexCount * indexSize, indexCount * indexSize, data );
+        glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+        this->indexCount += indexCount;
+    }
+
+    const PositionUniforms &getPositionUniforms( const Shader &shader ) const
+    {
+        for ( GLuint i = 0; i < this->positionUniforms.size( ); i++ )
+        {
+            if( this->positionUniforms[i].program == shader.ID )
+            {
+                return this->positionUniforms[i];
+            }
+        }
+
+        PositionUniforms uniforms;
+        uniforms.program = shader.ID;
+        uniforms.offset = shader.GetUniform( "positionOffset" );
+        uniforms.scale = shader.GetUniform( "positionScale" );
+        this->positionUniforms.push_back( uniforms );
+        return this->positionUniforms.back( );
+    }
+};
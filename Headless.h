@@ -0,0 +1,385 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+// Fixed time step of a headless run, every frame advances the clock by exactly this much
+#define HEADLESS_FRAME_TIME ( 1.0 / 60.0 )
+
+// CPU timings of whole frames and of named stages inside them.
+// Frame times are taken from BeginFrame( ) to EndFrame( ); end a frame after a glFinish (or swap) so the GPU work
+// of the frame is included.
+class FrameProfiler
+{
+public:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    /*  Functions   */
+    FrameProfiler( ) : currentStage( -1 )
+    {
+    }
+
+    void BeginFrame( )
+    {
+        this->frameStart = Clock::now( );
+        for ( size_t i = 0; i < this->stages.size( ); i++ )
+        {
+            this->stages[i].current = 0.0;
+        }
+    }
+
+    void EndFrame( )
+    {
+        this->EndStage( );
+        this->frameTimes.push_back( elapsedMs( this->frameStart ) );
+        for ( size_t i = 0; i < this->stages.size( ); i++ )
+        {
+            this->stages[i].samples.push_back( this->stages[i].current );
+        }
+    }
+
+    // Starts timing a stage of the current frame, closing the previous one. A stage can be entered several times
+    // per frame, its times add up.
+    void BeginStage( const string &name )
+    {
+        this->EndStage( );
+
+        this->currentStage = ( int )this->findStage( name );
+        this->stageStart = Clock::now( );
+    }
+
+    // Adds a time measured some other way (a GPU timer query) to a stage of the current frame. The stage being timed
+    // keeps running.
+    void AddStageTime( const string &name, double milliseconds )
+    {
+        this->stages[this->findStage( name )].current += milliseconds;
+    }
+
+    void EndStage( )
+    {
+        if( this->currentStage >= 0 )
+        {
+            this->stages[this->currentStage].current += elapsedMs( this->stageStart );
+            this->currentStage = -1;
+        }
+    }
+
+    size_t GetFrameCount( ) const
+    {
+        return this->frameTimes.size( );
+    }
+
+    // {"frames": N, "frameTimeMs": {...}, "stagesMs": {"name": {...}, ...}}, times in milliseconds
+    void WriteJson( ostream &out, const string &scene ) const
+    {
+        out << "{" << endl;
+        out << "  \"scene\": \"" << scene << "\"," << endl;
+        out << "  \"frames\": " << this->frameTimes.size( ) << "," << endl;
+        out << "  \"frameTimeMs\": ";
+        writeSummary( out, this->frameTimes );
+        out << "," << endl << "  \"stagesMs\": {";
+        for ( size_t i = 0; i < this->stages.size( ); i++ )
+        {
+            out << ( i > 0 ? "," : "" ) << endl << "    \"" << this->stages[i].name << "\": ";
+            writeSummary( out, this->stages[i].samples );
+        }
+        out << endl << "  }" << endl << "}" << endl;
+    }
+
+private:
+    struct Stage
+    {
+        string name;
+        double current;
+        vector<double> samples;
+    };
+
+    vector<double> frameTimes;
+    vector<Stage> stages;
+    int currentStage;
+    Clock::time_point frameStart;
+    Clock::time_point stageStart;
+
+    // Index of the stage called name, added if it's new
+    size_t findStage( const string &name )
+    {
+        size_t index = 0;
+        while ( index < this->stages.size( ) && this->stages[index].name != name )
+        {
+            index++;
+        }
+        if( index == this->stages.size( ) )
+        {
+            Stage stage;
+            stage.name = name;
+            stage.current = 0.0;
+            stage.samples.assign( this->frameTimes.size( ), 0.0 ); // Frames before the stage first appeared
+            this->stages.push_back( stage );
+        }
+        return index;
+    }
+
+    static double elapsedMs( const Clock::time_point &start )
+    {
+        return std::chrono::duration<double, std::milli>( Clock::now( ) - start ).count( );
+    }
+
+    // Nearest rank percentile of sorted values
+    static double percentile( const vector<double> &sorted, double p )
+    {
+        size_t rank = ( size_t )std::ceil( p / 100.0 * sorted.size( ) );
+        return sorted[std::min( std::max( rank, ( size_t )1 ), sorted.size( ) ) - 1];
+    }
+
+    static void writeSummary( ostream &out, vector<double> values )
+    {
+        if( values.empty( ) )
+        {
+            out << "{}";
+            return;
+        }
+
+        std::sort( values.begin( ), values.end( ) );
+        double sum = 0.0;
+        for ( size_t i = 0; i < values.size( ); i++ )
+        {
+            sum += values[i];
+        }
+
+        out << "{\"min\": " << values.front( ) << ", \"mean\": " << sum / values.size( )
+            << ", \"p95\": " << percentile( values, 95.0 ) << ", \"p99\": " << percentile( values, 99.0 )
+            << ", \"max\": " << values.back( ) << "}";
+    }
+};
+
+// Scripted camera for reproducible runs: orbits a target at a fixed radius and height
+class CameraPath
+{
+public:
+    CameraPath( glm::vec3 target = glm::vec3( 0.0f ), GLfloat radius = 3.0f, GLfloat height = 0.0f, GLfloat secondsPerTurn = 10.0f )
+        : target( target ), radius( radius ), height( height ), secondsPerTurn( secondsPerTurn )
+    {
+    }
+
+    glm::vec3 GetPosition( GLfloat time ) const
+    {
+        GLfloat angle = time / this->secondsPerTurn * 2.0f * 3.14159265f;
+        return this->target + glm::vec3( std::sin( angle ) * this->radius, this->height, std::cos( angle ) * this->radius );
+    }
+
+    glm::mat4 GetViewMatrix( GLfloat time ) const
+    {
+        return glm::lookAt( this->GetPosition( time ), this->target, glm::vec3( 0.0f, 1.0f, 0.0f ) );
+    }
+
+private:
+    glm::vec3 target;
+    GLfloat radius;
+    GLfloat height;
+    GLfloat secondsPerTurn;
+};
+
+// Lets a demo run as a benchmark: "--headless N [--json file]" on the command line renders N frames into an
+// offscreen framebuffer with an invisible window, a fixed time step and a scripted camera, then writes the frame
+// and stage timings as JSON (to stdout without --json). Without the flag the demo runs interactively as before.
+// On a Linux box without a display GLFW's null platform with an OSMesa context is used when available (GLFW 3.4);
+// LIBGL_ALWAYS_SOFTWARE=1 forces Mesa's software rasterizer anywhere.
+//
+// Usage in a demo:
+//   Headless headless( argc, argv );      // before glfwInit( )
+//   glfwInit( ); ...window hints...; headless.ConfigureWindow( );
+//   ...create the window, init GLEW...; headless.Begin( width, height );
+//   while ( headless.NextFrame( window ) ) { ...; headless.EndFrame( window ); }
+//   headless.Finish( "scene name" );              // before glfwTerminate( )
+class Headless
+{
+public:
+    /*  Functions   */
+    Headless( int argc, char **argv ) : enabled( false ), frames( 0 ), frame( 0 ), useNullPlatform( false ), FBO( 0 ), colorBuffer( 0 ), depthBuffer( 0 )
+    {
+        for ( int i = 1; i < argc; i++ )
+        {
+            if( 0 == strcmp( argv[i], "--headless" ) && i + 1 < argc )
+            {
+                this->enabled = true;
+                this->frames = std::max( 1, atoi( argv[++i] ) );
+            }
+            else if( 0 == strcmp( argv[i], "--json" ) && i + 1 < argc )
+            {
+                this->jsonPath = argv[++i];
+            }
+        }
+
+#if defined( GLFW_PLATFORM_NULL ) && defined( GLFW_OSMESA_CONTEXT_API ) && !defined( _WIN32 ) && !defined( __APPLE__ )
+        if( this->enabled && NULL == getenv( "DISPLAY" ) && NULL == getenv( "WAYLAND_DISPLAY" ) )
+        {
+            this->useNullPlatform = true;
+            glfwInitHint( GLFW_PLATFORM, GLFW_PLATFORM_NULL );
+        }
+#endif
+    }
+
+    bool IsEnabled( ) const
+    {
+        return this->enabled;
+    }
+
+    // Call after the demo's own window hints
+    void ConfigureWindow( )
+    {
+        if( !this->enabled )
+        {
+            return;
+        }
+
+        glfwWindowHint( GLFW_VISIBLE, GL_FALSE );
+#if defined( GLFW_OSMESA_CONTEXT_API )
+        if( this->useNullPlatform )
+        {
+            glfwWindowHint( GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API );
+        }
+#endif
+    }
+
+    // Creates and binds the offscreen framebuffer the frames are rendered to. Call once GLEW is initialized.
+    bool Begin( GLint width, GLint height )
+    {
+        if( !this->enabled )
+        {
+            return true;
+        }
+
+        glGenFramebuffers( 1, &this->FBO );
+        glGenRenderbuffers( 1, &this->colorBuffer );
+        glGenRenderbuffers( 1, &this->depthBuffer );
+
+        glBindRenderbuffer( GL_RENDERBUFFER, this->colorBuffer );
+        glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, width, height );
+        glBindRenderbuffer( GL_RENDERBUFFER, this->depthBuffer );
+        glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height );
+        glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+        glBindFramebuffer( GL_FRAMEBUFFER, this->FBO );
+        glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->colorBuffer );
+        glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthBuffer );
+
+        if( GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus( GL_FRAMEBUFFER ) )
+        {
+            cout << "ERROR::HEADLESS:: Offscreen framebuffer is not complete" << endl;
+            return false;
+        }
+
+        glViewport( 0, 0, width, height );
+        glfwSwapInterval( 0 );
+
+        return true;
+    }
+
+    // Starts the next frame, false once the run is over (window closed, or N frames rendered when headless).
+    // In headless mode the GLFW clock is set to the frame's scripted time, so glfwGetTime( ) driven animation
+    // and delta times are the same on every run.
+    bool NextFrame( GLFWwindow *window )
+    {
+        if( this->enabled )
+        {
+            if( this->frame >= this->frames )
+            {
+                return false;
+            }
+            glfwSetTime( this->frame * HEADLESS_FRAME_TIME );
+        }
+        else if( glfwWindowShouldClose( window ) )
+        {
+            return false;
+        }
+
+        this->profiler.BeginFrame( );
+        return true;
+    }
+
+    // Presents the frame: a swap when interactive, a glFinish when headless so the GPU time is part of the frame
+    void EndFrame( GLFWwindow *window )
+    {
+        this->profiler.BeginStage( "present" );
+        if( this->enabled )
+        {
+            glFinish( );
+        }
+        else
+        {
+            glfwSwapBuffers( window );
+        }
+        this->profiler.EndFrame( );
+        this->frame++;
+    }
+
+    // Writes the JSON report of a headless run and releases the offscreen framebuffer. Call before glfwTerminate( ).
+    void Finish( const string &scene )
+    {
+        if( !this->enabled )
+        {
+            return;
+        }
+
+        if( 0 != this->FBO )
+        {
+            glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+            glDeleteFramebuffers( 1, &this->FBO );
+            glDeleteRenderbuffers( 1, &this->colorBuffer );
+            glDeleteRenderbuffers( 1, &this->depthBuffer );
+            this->FBO = 0;
+        }
+
+        if( this->jsonPath.empty( ) )
+        {
+            this->profiler.WriteJson( cout, scene );
+            return;
+        }
+
+        ofstream file( this->jsonPath.c_str( ) );
+        if( !file )
+        {
+            cout << "ERROR::HEADLESS:: Could not write " << this->jsonPath << endl;
+            return;
+        }
+        this->profiler.WriteJson( file, scene );
+    }
+
+    FrameProfiler &GetProfiler( )
+    {
+        return this->profiler;
+    }
+
+    // Scripted time of the current frame
+    GLfloat GetTime( ) const
+    {
+        return ( GLfloat )( this->frame * HEADLESS_FRAME_TIME );
+    }
+
+private:
+    bool enabled;
+    int frames;
+    int frame;
+    bool useNullPlatform;
+    string jsonPath;
+    GLuint FBO, colorBuffer, depthBuffer;
+    FrameProfiler profiler;
+
+    Headless( const Headless & );
+    Headless &operator=( const Headless & );
+};
@@ -1,104 +1,4 @@
-#ifndef SHADER_H
-#define SHADER_H
+#pragma once
 
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-
-#include <GL/glew.h>
-
-class Shader
-{
-public:
-    GLuint ID;
-    // Constructor generates the shader on the fly
-    Shader( const GLchar *vertexPath, const GLchar *fragmentPath )
-    {
-        // 1. Retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensures ifstream objects can throw exceptions:
-        vShaderFile.exceptions ( std::ifstream::badbit );
-        fShaderFile.exceptions ( std::ifstream::badbit );
-        try
-        {
-            // Open files
-            vShaderFile.open( vertexPath );
-            fShaderFile.open( fragmentPath );
-            std::stringstream vShaderStream, fShaderStream;
-            // Read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf( );
-            fShaderStream << fShaderFile.rdbuf( );
-            // close file handlers
-            vShaderFile.close( );
-            fShaderFile.close( );
-            // Convert stream into string
-            vertexCode = vShaderStream.str( );
-            fragmentCode = fShaderStream.str( );
-        }
-        catch ( std::ifstream::failure e )
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-        }
-        const GLchar *vShaderCode = vertexCode.c_str( );
-        const GLchar *fShaderCode = fragmentCode.c_str( );
-        // 2. Compile shaders
-        GLuint vertex, fragment;
-        GLint success;
-        GLchar infoLog[512];
-        // Vertex Shader
-        vertex = glCreateShader( GL_VERTEX_SHADER );
-        glShaderSource( vertex, 1, &vShaderCode, NULL );
-        glCompileShader( vertex );
-        // Print compile errors if any
-        glGetShaderiv( vertex, GL_COMPILE_STATUS, &success );
-        if ( !success )
-        {
-            glGetShaderInfoLog( vertex, 512, NULL, infoLog );
-            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-        }
-        // Fragment Shader
-        fragment = glCreateShader( GL_FRAGMENT_SHADER );
-        glShaderSource( fragment, 1, &fShaderCode, NULL );
-        glCompileShader( fragment );
-        // Print compile errors if any
-        glGetShaderiv( fragment, GL_COMPILE_STATUS, &success );
-        if ( !success )
-        {
-            glGetShaderInfoLog( fragment, 512, NULL, infoLog );
-            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-        }
-        // Shader Program
-        this->ID = glCreateProgram( );
-        glAttachShader( this->ID, vertex );
-        glAttachShader( this->ID, fragment );
-        glLinkProgram( this->ID );
-        // Print linking errors if any
-        glGetProgramiv( this->ID, GL_LINK_STATUS, &success );
-        if (!success)
-        {
-            glGetProgramInfoLog( this->ID, 512, NULL, infoLog );
-            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        }
-        // Delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader( vertex );
-        glDeleteShader( fragment );
-        
-	}
-    // Uses the current shader
-    void use( )
-    {
-        glUseProgram( this->ID );
-    }
-	// ------------------------------------------------------------------------
-	void setMat4(const std::string &name, const glm::mat4 &mat) const
-	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-	}
-
-};
-
-#endif
\ No newline at end of file
+// Every project shares the same Shader class (uniform table, program binary cache)
+#include "../Shader.h"
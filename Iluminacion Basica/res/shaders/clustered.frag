@@ -0,0 +1,69 @@
+#version 330 core
+
+// Must match ClusteredLights.h
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+
+out vec4 color;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 ObjectColor;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+// Set by LightClusters::Bind
+uniform samplerBuffer clusterLights;	// Two texels per light: position and radius, color
+uniform usamplerBuffer clusterGrid;		// Offset and count of each cluster's light indices
+uniform usamplerBuffer clusterIndices;
+uniform vec2 clusterTileScale;			// Fragment coordinates to tiles
+uniform vec2 clusterDepthParams;		// slice = log(depth) * x + y
+
+void main()
+{
+	vec3 norm = normalize(Normal);
+	vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
+
+	//Cluster of the fragment
+	float depth = -(view * vec4(FragPos, 1.0f)).z;
+	ivec3 cell = ivec3(ivec2(gl_FragCoord.xy * clusterTileScale), int(log(depth) * clusterDepthParams.x + clusterDepthParams.y));
+	cell = clamp(cell, ivec3(0), ivec3(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1, CLUSTER_GRID_Z - 1));
+	uvec2 cluster = texelFetch(clusterGrid, cell.x + CLUSTER_GRID_X * (cell.y + CLUSTER_GRID_Y * cell.z)).xy;
+
+	// ambient
+	vec3 result = vec3(0.05f);
+
+	for (uint i = 0u; i < cluster.y; i++)
+	{
+		int light = int(texelFetch(clusterIndices, int(cluster.x + i)).r);
+		vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+		vec3 lightRGB = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+		vec3 toLight = positionRadius.xyz - FragPos;
+		float distance = length(toLight);
+		//Smooth falloff that reaches zero at the radius
+		float falloff = clamp(1.0f - distance * distance / (positionRadius.w * positionRadius.w), 0.0f, 1.0f);
+		falloff *= falloff;
+
+		//diffuse
+		vec3 lightDir = toLight / max(distance, 0.0001f);
+		float diff = max(dot(norm, lightDir), 0.0);
+
+		//specular
+		vec3 reflectDir = reflect(-lightDir, norm);
+		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+
+		result += (diff + 0.5f * spec) * falloff * lightRGB;
+	}
+
+	color = vec4(result * ObjectColor, 1.0f);
+};
@@ -0,0 +1,37 @@
+#version 330 core
+
+//Geometry pass of the "--deferred" path (DeferredRenderer.h), drawn with lighting.vs. Writes the surface instead of
+//lighting it, the outputs follow GBufferTarget
+
+layout (location = 0) out vec4 gPosition;	// xyz world position
+layout (location = 1) out vec4 gNormal;		// xyz world normal, w 1 marks the pixel as drawn
+layout (location = 2) out vec4 gAlbedo;
+layout (location = 3) out vec4 gSpecular;	// Unused, lighting.frag has no specular color
+layout (location = 4) out vec4 lighting;	// Light accumulation, deferredLighting.frag adds to the ambient term
+
+in vec3 FragPos;
+in vec3 Normal;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+uniform vec3 objectColor;
+
+void main()
+{
+	// ambient, as in lighting.frag
+	float ambientStrength = 0.1f;
+
+	gPosition = vec4(FragPos, 1.0f);
+	gNormal = vec4(normalize(Normal), 1.0f);
+	gAlbedo = vec4(objectColor, 1.0f);
+	gSpecular = vec4(0.0f);
+	lighting = vec4(ambientStrength * lightColor.rgb * objectColor, 1.0f);
+};
\ No newline at end of file
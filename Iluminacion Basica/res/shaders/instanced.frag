@@ -0,0 +1,44 @@
+#version 330 core
+
+out vec4 color;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 ObjectColor;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+void main()
+{
+	vec3 viewPos = cameraPosition.xyz;
+	vec3 lightRGB = lightColor.rgb;
+
+	// ambient
+	float ambientStrength = 0.1f;
+	vec3 ambient = ambientStrength * lightRGB;
+
+	//diffuse
+	vec3 norm = normalize(Normal);
+	//w is 0 for a directional light, whose xyz is the direction toward it
+	vec3 lightDir = normalize(lightPosition.xyz - FragPos * lightPosition.w);
+	float diff = max(dot(norm, lightDir), 0.0);
+	vec3 diffuse = diff * lightRGB;
+
+	//specular
+	float specularStrength = 5.0f;
+	vec3 viewDir = normalize(viewPos - FragPos);
+	vec3 reflectDir = reflect(-lightDir, norm);
+	float spec = pow(max(dot(viewDir, reflectDir),0.0),32);
+	vec3 specular = specularStrength * spec * lightRGB;
+
+	vec3 result = (ambient + diffuse + specular) * ObjectColor;
+	color = vec4(result, 1.0f); 
+};
\ No newline at end of file
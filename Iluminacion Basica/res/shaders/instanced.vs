@@ -0,0 +1,29 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 4) in mat4 instanceModel;
+layout (location = 8) in vec4 instanceColor;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec3 ObjectColor;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+void main()
+{
+	gl_Position = viewProjection * instanceModel * vec4(position, 1.0f);
+	FragPos = vec3(instanceModel * vec4(position, 1.0f));
+	// Instances are only rotated, translated and uniformly scaled, so the model matrix transforms normals too
+	Normal = mat3(instanceModel) * normal;
+	ObjectColor = instanceColor.rgb;
+};
\ No newline at end of file
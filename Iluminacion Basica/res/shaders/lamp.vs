@@ -3,10 +3,18 @@
 layout (location = 0) in vec3 position;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {
-	gl_Position = projection * view * model*  vec4(position, 1.0f);
+	gl_Position = viewProjection * model * vec4(position, 1.0f);
 };
\ No newline at end of file
@@ -1,34 +1,135 @@
 #version 330 core
 
+//Must match SHADOW_MAX_CASCADES in ShadowCascades.h
+#define MAX_CASCADES 4
+//Must match ClusteredLights.h
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+
 out vec4 color;
 
 in vec3 FragPos;
 in vec3 Normal;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
 uniform vec3 objectColor;
-uniform vec3 lightColor;
+
+//Cascaded shadow map of the light, set by CascadedShadowMap::Bind. Without it cascadeCount is 0 and nothing is shadowed
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[MAX_CASCADES];
+uniform vec4 cascadeSplits;
+uniform vec4 cascadeTexelSizes;
+uniform int cascadeCount;
+uniform int shadowFilterRadius;
+
+//Point lights binned by LightClusters::Bind, only the ones of the fragment's cluster are walked
+uniform samplerBuffer clusterLights;	// Two texels per light: position and radius, color
+uniform usamplerBuffer clusterGrid;		// Offset and count of each cluster's light indices
+uniform usamplerBuffer clusterIndices;
+uniform vec2 clusterTileScale;			// Fragment coordinates to tiles
+uniform vec2 clusterDepthParams;		// slice = log(depth) * x + y
+uniform int lightCount;					// 0 without clusters, the buffers aren't read then
+
+//Fraction of the light reaching the fragment, 0 in full shadow. Past the last cascade everything is lit
+float ShadowFactor(vec3 position, vec3 normal)
+{
+	float depth = -(view * vec4(position, 1.0f)).z;
+	int cascade = 0;
+	while (cascade < cascadeCount && depth > cascadeSplits[cascade])
+	{
+		cascade++;
+	}
+	if (cascade >= cascadeCount)
+	{
+		return 1.0f;
+	}
+
+	//Looking the map up a bit off the surface keeps it from shadowing itself
+	vec4 coord = shadowMatrices[cascade] * vec4(position + normal * cascadeTexelSizes[cascade] * 1.5f, 1.0f);
+	float reference = min(coord.z, 1.0f);
+	vec2 texel = 1.0f / vec2(textureSize(shadowMap, 0).xy);
+
+	float lit = 0.0f;
+	for (int y = -shadowFilterRadius; y <= shadowFilterRadius; y++)
+	{
+		for (int x = -shadowFilterRadius; x <= shadowFilterRadius; x++)
+		{
+			lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, cascade, reference));
+		}
+	}
+	float taps = float(2 * shadowFilterRadius + 1);
+	return lit / (taps * taps);
+}
+
+//Diffuse and specular of the point lights reaching the fragment
+vec3 PointLights(vec3 position, vec3 normal, vec3 viewDir)
+{
+	if (0 == lightCount)
+	{
+		return vec3(0.0f);
+	}
+
+	float depth = -(view * vec4(position, 1.0f)).z;
+	ivec3 cell = ivec3(ivec2(gl_FragCoord.xy * clusterTileScale), int(log(depth) * clusterDepthParams.x + clusterDepthParams.y));
+	cell = clamp(cell, ivec3(0), ivec3(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1, CLUSTER_GRID_Z - 1));
+	uvec2 cluster = texelFetch(clusterGrid, cell.x + CLUSTER_GRID_X * (cell.y + CLUSTER_GRID_Y * cell.z)).xy;
+
+	vec3 result = vec3(0.0f);
+	for (uint i = 0u; i < cluster.y; i++)
+	{
+		int light = int(texelFetch(clusterIndices, int(cluster.x + i)).r);
+		vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+		vec3 lightRGB = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+		vec3 toLight = positionRadius.xyz - position;
+		float distance = length(toLight);
+		//Smooth falloff that reaches zero at the radius
+		float falloff = clamp(1.0f - distance * distance / (positionRadius.w * positionRadius.w), 0.0f, 1.0f);
+		falloff *= falloff;
+
+		vec3 lightDir = toLight / max(distance, 0.0001f);
+		float diff = max(dot(normal, lightDir), 0.0);
+		float spec = pow(max(dot(viewDir, reflect(-lightDir, normal)), 0.0), 32);
+
+		result += (diff + 0.5f * spec) * falloff * lightRGB;
+	}
+	return result;
+}
 
 void main()
 {
+	vec3 viewPos = cameraPosition.xyz;
+	vec3 lightRGB = lightColor.rgb;
+
 	// ambient
 	float ambientStrength = 0.1f;
-	vec3 ambient = ambientStrength * lightColor;
+	vec3 ambient = ambientStrength * lightRGB;
 
 	//diffuse
 	vec3 norm = normalize(Normal);
-	vec3 lightDir = normalize(lightPos - FragPos);
+	//w is 0 for a directional light, whose xyz is the direction toward it
+	vec3 lightDir = normalize(lightPosition.xyz - FragPos * lightPosition.w);
 	float diff = max(dot(norm, lightDir), 0.0);
-	vec3 diffuse = diff * lightColor;
+	vec3 diffuse = diff * lightRGB;
 
 	//specular
 	float specularStrength = 5.0f;
 	vec3 viewDir = normalize(viewPos - FragPos);
 	vec3 reflectDir = reflect(-lightDir, norm);
 	float spec = pow(max(dot(viewDir, reflectDir),0.0),32);
-	vec3 specular = specularStrength * spec * lightColor;
+	vec3 specular = specularStrength * spec * lightRGB;
 
-	vec3 result = (ambient + diffuse + specular) * objectColor;
+	float shadow = ShadowFactor(FragPos, norm);
+	vec3 result = (ambient + shadow * (diffuse + specular) + PointLights(FragPos, norm, viewDir)) * objectColor;
 	color = vec4(result, 1.0f); 
 };
\ No newline at end of file
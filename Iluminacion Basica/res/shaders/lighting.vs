@@ -7,12 +7,22 @@ out vec3 Normal;
 out vec3 FragPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+//Transforms normals, computed once per object on the CPU
+uniform mat3 normalMatrix;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {
-	gl_Position = projection * view * model*  vec4(position, 1.0f);
+	gl_Position = viewProjection * model * vec4(position, 1.0f);
 	FragPos  = vec3(model * vec4(position, 1.0f));
-	Normal = mat3(transpose(inverse(model))) * normal;
+	Normal = normalMatrix * normal;
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#version 330 core
+
+// Same lighting as clustered.frag, but every fragment walks every light. Only there to compare against.
+
+out vec4 color;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 ObjectColor;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+// Set by LightClusters::Bind, only the lights are read
+uniform samplerBuffer clusterLights;	// Two texels per light: position and radius, color
+uniform int lightCount;
+
+void main()
+{
+	vec3 norm = normalize(Normal);
+	vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
+
+	// ambient
+	vec3 result = vec3(0.05f);
+
+	for (int light = 0; light < lightCount; light++)
+	{
+		vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+		vec3 lightRGB = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+		vec3 toLight = positionRadius.xyz - FragPos;
+		float distance = length(toLight);
+		//Smooth falloff that reaches zero at the radius
+		float falloff = clamp(1.0f - distance * distance / (positionRadius.w * positionRadius.w), 0.0f, 1.0f);
+		falloff *= falloff;
+
+		//diffuse
+		vec3 lightDir = toLight / max(distance, 0.0001f);
+		float diff = max(dot(norm, lightDir), 0.0);
+
+		//specular
+		vec3 reflectDir = reflect(-lightDir, norm);
+		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+
+		result += (diff + 0.5f * spec) * falloff * lightRGB;
+	}
+
+	color = vec4(result * ObjectColor, 1.0f);
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "StateTracker.h"
+
+// Attribute locations used by the per instance data. A mat4 takes four consecutive locations (one per column).
+//
+// layout (location = 4) in mat4 instanceModel;
+// layout (location = 8) in vec4 instanceColor;
+#define INSTANCE_MODEL_LOCATION 4
+#define INSTANCE_COLOR_LOCATION 8
+
+// Per instance transforms (and optionally colors) for one VAO, drawn with a single instanced draw call.
+// The VAO keeps its per vertex attributes; the instance attributes are added to it with a divisor of 1.
+// Update( ) streams a new set of instances every time it is called (the buffer is orphaned first so the driver never
+// waits for the previous frame to finish reading it). Without colors every instance gets instanceColor = (1, 1, 1, 1).
+class InstanceBuffer
+{
+public:
+    /*  Functions   */
+    InstanceBuffer( GLuint VAO ) : VAO( VAO ), instanceCount( 0 ), capacity( 0 ), hasColors( false )
+    {
+        glGenBuffers( 1, &this->modelVBO );
+        glGenBuffers( 1, &this->colorVBO );
+
+        GetStateTracker( ).BindVertexArray( this->VAO );
+
+        glBindBuffer( GL_ARRAY_BUFFER, this->modelVBO );
+        for ( GLuint i = 0; i < 4; i++ )
+        {
+            glEnableVertexAttribArray( INSTANCE_MODEL_LOCATION + i );
+            glVertexAttribPointer( INSTANCE_MODEL_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof( glm::mat4 ), ( GLvoid * )( i * sizeof( glm::vec4 ) ) );
+            glVertexAttribDivisor( INSTANCE_MODEL_LOCATION + i, 1 );
+        }
+
+        // Enabled only while the instances carry colors
+        glBindBuffer( GL_ARRAY_BUFFER, this->colorVBO );
+        glVertexAttribPointer( INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof( glm::vec4 ), ( GLvoid * )0 );
+        glVertexAttribDivisor( INSTANCE_COLOR_LOCATION, 1 );
+
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        GetStateTracker( ).BindVertexArray( 0 );
+    }
+
+    ~InstanceBuffer( )
+    {
+        glDeleteBuffers( 1, &this->modelVBO );
+        glDeleteBuffers( 1, &this->colorVBO );
+    }
+
+    // Replaces the instances with count transforms (and colors, if given)
+    void Update( const glm::mat4 *transforms, GLsizei count, const glm::vec4 *colors = NULL )
+    {
+        this->instanceCount = count;
+
+        // Grow in powers of two so a slowly growing scene doesn't reallocate every frame
+        GLsizei size = ( this->capacity > 0 ) ? this->capacity : 1;
+        while ( size < count )
+        {
+            size *= 2;
+        }
+        this->capacity = size;
+
+        glBindBuffer( GL_ARRAY_BUFFER, this->modelVBO );
+        glBufferData( GL_ARRAY_BUFFER, this->capacity * sizeof( glm::mat4 ), NULL, GL_STREAM_DRAW );
+        glBufferSubData( GL_ARRAY_BUFFER, 0, count * sizeof( glm::mat4 ), transforms );
+
+        if( NULL != colors )
+        {
+            glBindBuffer( GL_ARRAY_BUFFER, this->colorVBO );
+            glBufferData( GL_ARRAY_BUFFER, this->capacity * sizeof( glm::vec4 ), NULL, GL_STREAM_DRAW );
+            glBufferSubData( GL_ARRAY_BUFFER, 0, count * sizeof( glm::vec4 ), colors );
+        }
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+        if( this->hasColors != ( NULL != colors ) )
+        {
+            this->hasColors = ( NULL != colors );
+
+            GetStateTracker( ).BindVertexArray( this->VAO );
+            if( this->hasColors )
+            {
+                glEnableVertexAttribArray( INSTANCE_COLOR_LOCATION );
+            }
+            else
+            {
+                glDisableVertexAttribArray( INSTANCE_COLOR_LOCATION );
+            }
+            GetStateTracker( ).BindVertexArray( 0 );
+        }
+    }
+
+    void Update( const std::vector<glm::mat4> &transforms )
+    {
+        this->Update( transforms.empty( ) ? NULL : &transforms[0], ( GLsizei )transforms.size( ) );
+    }
+
+    void Update( const std::vector<glm::mat4> &transforms, const std::vector<glm::vec4> &colors )
+    {
+        this->Update( transforms.empty( ) ? NULL : &transforms[0], ( GLsizei )transforms.size( ), colors.empty( ) ? NULL : &colors[0] );
+    }
+
+    // Draws every instance of a non indexed mesh (e.g. the 36 vertex cube)
+    void DrawArrays( GLenum mode, GLint first, GLsizei vertexCount )
+    {
+        if( 0 == this->instanceCount )
+        {
+            return;
+        }
+
+        this->bind( );
+        glDrawArraysInstanced( mode, first, vertexCount, this->instanceCount );
+        GetStateTracker( ).BindVertexArray( 0 );
+    }
+
+    // Draws every instance of an indexed mesh, indices is the offset into the VAO's element buffer
+    void DrawElements( GLenum mode, GLsizei indexCount, GLenum type, const GLvoid *indices = 0 )
+    {
+        if( 0 == this->instanceCount )
+        {
+            return;
+        }
+
+        this->bind( );
+        glDrawElementsInstanced( mode, indexCount, type, indices, this->instanceCount );
+        GetStateTracker( ).BindVertexArray( 0 );
+    }
+
+    GLsizei GetInstanceCount( ) const
+    {
+        return this->instanceCount;
+    }
+
+private:
+    /*  Render data  */
+    GLuint VAO;
+    GLuint modelVBO, colorVBO;
+    GLsizei instanceCount;
+    GLsizei capacity;
+    bool hasColors;
+
+    InstanceBuffer( const InstanceBuffer & );
+    InstanceBuffer &operator=( const InstanceBuffer & );
+
+    void bind( )
+    {
+        GetStateTracker( ).BindVertexArray( this->VAO );
+
+        // A disabled attribute array reads the current generic value, which is context state, so set it per draw
+        if( !this->hasColors )
+        {
+            glVertexAttrib4f( INSTANCE_COLOR_LOCATION, 1.0f, 1.0f, 1.0f, 1.0f );
+        }
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Most levels of detail of a mesh, the full one included
+#define LOD_MAX_LEVELS 5
+// Meshes with fewer triangles keep only their full detail
+#define LOD_MIN_TRIANGLES 64
+// A level has to drop at least this fraction of the previous level's triangles to be kept
+#define LOD_MIN_REDUCTION 0.2f
+
+// Triangles submitted through Model::Submit( ), and how many full detail would have been. Reset them at the start
+// of a frame to get per frame numbers.
+struct LodStats
+{
+    GLuint trianglesSubmitted;
+    GLuint trianglesFullDetail;
+    GLuint levelChanges;
+};
+
+inline LodStats &GetLodStats( )
+{
+    static LodStats stats = { 0, 0, 0 };
+    return stats;
+}
+
+// How levels are picked for one view: a mesh is drawn with the coarsest level whose simplification error, projected
+// to the screen at the mesh's distance, stays under maxPixelError pixels. To stop meshes near a switch distance from
+// popping back and forth, a coarser level is only taken once its error is hysteresis (a fraction) below the limit.
+struct LodView
+{
+    glm::vec3 cameraPosition;
+    GLfloat pixelsPerUnit;      // Pixels a world unit at distance 1 covers on screen
+    GLfloat maxPixelError;
+    GLfloat hysteresis;
+
+    LodView( const glm::vec3 &cameraPosition, const glm::mat4 &projection, GLfloat viewportHeight, GLfloat maxPixelError = 1.0f, GLfloat hysteresis = 0.25f )
+        : cameraPosition( cameraPosition ), pixelsPerUnit( projection[1][1] * viewportHeight * 0.5f ), maxPixelError( maxPixelError ), hysteresis( hysteresis )
+    {
+    }
+
+    // Level to draw, out of count levels with growing errors (errors[0] is the full detail's 0), given the one drawn
+    // last frame and the pixels a unit of error covers at the mesh's distance
+    GLuint Select( const GLfloat *errors, GLuint count, GLuint current, GLfloat pixelsPerError ) const
+    {
+        GLuint level = std::min( current, count - 1 );
+
+        while ( level + 1 < count && errors[level + 1] * pixelsPerError <= this->maxPixelError * ( 1.0f - this->hysteresis ) )
+        {
+            level++;
+        }
+        while ( level > 0 && errors[level] * pixelsPerError > this->maxPixelError )
+        {
+            level--;
+        }
+
+        return level;
+    }
+};
+
+// Level each mesh of one model instance was drawn with, kept from frame to frame for the hysteresis. Give every
+// instance of a model its own.
+struct LodState
+{
+    vector<GLubyte> levels;
+};
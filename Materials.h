@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Uniform buffer binding point of the "Materials" block
+#define MATERIALS_BINDING 1
+// Size of the materials array in the shaders, 256 entries take 12 KB of the 16 KB every GL 3.3 UBO may hold
+#define MAX_MATERIALS 256
+
+// Lighting values of a material as Assimp gives them
+struct Material
+{
+    glm::vec3 Diffuse;
+    glm::vec3 Specular;
+    glm::vec3 Ambient;
+    GLfloat Shininess;
+};
+
+// One entry of the "Materials" block, std140 layout
+struct MaterialData
+{
+    glm::vec4 diffuse;
+    glm::vec4 ambient;
+    glm::vec4 specular;     // w holds the shininess
+};
+
+// Every material of every loaded model, without duplicates, in one uniform buffer.
+// Meshes keep the index of their material and the shaders read materials[materialIndex], so switching material is
+// a single integer uniform and drawing many meshes of the same material needs nothing at all.
+class MaterialLibrary
+{
+public:
+    static MaterialLibrary &Instance( )
+    {
+        static MaterialLibrary library;
+        return library;
+    }
+
+    // Returns the index of an equal material, adding it when there is none yet
+    GLuint Add( const Material &material )
+    {
+        MaterialData data;
+        data.diffuse = glm::vec4( material.Diffuse, 1.0f );
+        data.ambient = glm::vec4( material.Ambient, 1.0f );
+        data.specular = glm::vec4( material.Specular, material.Shininess );
+
+        for ( GLuint i = 0; i < this->data.size( ); i++ )
+        {
+            if( 0 == memcmp( &this->data[i], &data, sizeof( MaterialData ) ) )
+            {
+                return i;
+            }
+        }
+
+        if( this->data.size( ) >= MAX_MATERIALS )
+        {
+            cout << "ERROR::MATERIAL_LIBRARY:: More than " << MAX_MATERIALS << " materials, using material 0" << endl;
+            return 0;
+        }
+
+        this->materials.push_back( material );
+        this->data.push_back( data );
+        this->dirty = true;
+
+        return ( GLuint )this->data.size( ) - 1;
+    }
+
+    const Material &Get( GLuint index ) const
+    {
+        return this->materials[index];
+    }
+
+    GLuint GetCount( ) const
+    {
+        return ( GLuint )this->data.size( );
+    }
+
+    // Sends the materials added since the last call to the uniform buffer. Needs the GL context, models call it once
+    // they are loaded.
+    void Upload( )
+    {
+        if( !this->dirty )
+        {
+            return;
+        }
+
+        if( 0 == this->UBO )
+        {
+            glGenBuffers( 1, &this->UBO );
+            glBindBuffer( GL_UNIFORM_BUFFER, this->UBO );
+            glBufferData( GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof( MaterialData ), NULL, GL_STATIC_DRAW );
+            glBindBufferBase( GL_UNIFORM_BUFFER, MATERIALS_BINDING, this->UBO );
+        }
+
+        glBindBuffer( GL_UNIFORM_BUFFER, this->UBO );
+        glBufferSubData( GL_UNIFORM_BUFFER, 0, this->data.size( ) * sizeof( MaterialData ), &this->data[0] );
+        glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+
+        this->dirty = false;
+    }
+
+private:
+    vector<Material> materials;
+    vector<MaterialData> data;
+    GLuint UBO;
+    bool dirty;
+
+    MaterialLibrary( ) : UBO( 0 ), dirty( false )
+    {
+    }
+
+    MaterialLibrary( const MaterialLibrary & );
+    MaterialLibrary &operator=( const MaterialLibrary & );
+};
@@ -5,11 +5,15 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <utility>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Frustum.h"
+#include "StateTracker.h"
+
 using namespace std;
 
 struct Vertex
@@ -22,10 +26,38 @@ struct Vertex
     glm::vec2 TexCoords;
 };
 
+// What a texture is used for, it picks the sampler uniforms (texture_diffuseN, texture_specularN) it is bound to
+enum TextureType
+{
+    TEXTURE_DIFFUSE = 0,
+    TEXTURE_SPECULAR,
+    TEXTURE_TYPE_COUNT
+};
+
+// Sampler uniform prefix of a texture type, also the name the mesh cache stores
+inline const char *GetTextureTypeName( TextureType type )
+{
+    static const char *names[TEXTURE_TYPE_COUNT] = { "texture_diffuse", "texture_specular" };
+    return names[type];
+}
+
+inline TextureType GetTextureTypeFromName( const string &name )
+{
+    for ( int i = 0; i < TEXTURE_TYPE_COUNT; i++ )
+    {
+        if( name == GetTextureTypeName( ( TextureType )i ) )
+        {
+            return ( TextureType )i;
+        }
+    }
+    
+    return TEXTURE_DIFFUSE;
+}
+
 struct Texture
 {
     GLuint id;
-    string type;
+    TextureType type;
     aiString path;
 };
 
@@ -36,102 +68,130 @@ public:
     vector<Vertex> vertices;
     vector<GLuint> indices;
     vector<Texture> textures;
+    GLuint materialIndex;   // Entry of the MaterialLibrary
     
     /*  Functions  */
-    // Constructor
+    // Constructor. The arrays are moved into the mesh, pass them with std::move( ) to avoid any copy.
     Mesh( vector<Vertex> vertices, vector<GLuint> indices, vector<Texture> textures )
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
-        
-        // Now that we have all the required data, set the vertex buffers and its attribute pointers.
-        this->setupMesh( );
+        this->vertices = std::move( vertices );
+        this->indices = std::move( indices );
+        this->textures = std::move( textures );
+        this->materialIndex = 0;
+        this->vertexCount = ( GLuint )this->vertices.size( );
+        this->indexCount = ( GLuint )this->indices.size( );
+        ComputeBounds( this->vertices.empty( ) ? NULL : &this->vertices[0], ( GLuint )this->vertices.size( ), this->bounds, this->boundingSphere );
+    }
+    
+    // Constructor for geometry owned by someone else (e.g. a memory mapped mesh cache).
+    // Only the counts and bounds are kept, the owner uploads the ranges itself.
+    Mesh( const Vertex *vertices, GLuint vertexCount, const GLuint *indices, GLuint indexCount, vector<Texture> textures )
+    {
+        this->textures = std::move( textures );
+        this->materialIndex = 0;
+        this->vertexCount = vertexCount;
+        this->indexCount = indexCount;
+        ComputeBounds( vertices, vertexCount, this->bounds, this->boundingSphere );
     }
     
-    // Render the mesh
-    void Draw( Shader shader )
+    // Binds the mesh's textures and selects its material for its draw. The geometry itself lives in the owning Model's
+    // GeometryArena, which issues the draw call.
+    // The uniforms are looked up the first time the mesh is drawn with a shader, after that nothing is allocated.
+    void BindTextures( Shader &shader ) const
     {
-        // Bind appropriate textures
-        GLuint diffuseNr = 1;
-        GLuint specularNr = 1;
+        const SamplerTable &table = this->getSamplerTable( shader );
         
         for( GLuint i = 0; i < this->textures.size( ); i++ )
         {
-            glActiveTexture( GL_TEXTURE0 + i ); // Active proper texture unit before binding
-            // Retrieve texture number (the N in diffuse_textureN)
-            stringstream ss;
-            string number;
-            string name = this->textures[i].type;
-            
-            if( name == "texture_diffuse" )
-            {
-                ss << diffuseNr++; // Transfer GLuint to stream
-            }
-            else if( name == "texture_specular" )
-            {
-                ss << specularNr++; // Transfer GLuint to stream
-            }
-            
-            number = ss.str( );
-            // Now set the sampler to the correct texture unit
-            glUniform1i( glGetUniformLocation( shader.ID, ( name + number ).c_str( ) ), i );
-            // And finally bind the texture
-            glBindTexture( GL_TEXTURE_2D, this->textures[i].id );
+            // Texture i always goes to unit i
+            shader.setSampler( table.samplers[i], i );
+            // A unit already holding the texture is left alone
+            GetStateTracker( ).BindTexture( i, this->textures[i].id );
         }
         
-        // Also set each mesh's shininess property to a default value (if you want you could extend this to another mesh property and possibly change this value)
-        glUniform1f( glGetUniformLocation( shader.ID, "material.shininess" ), 16.0f );
-        
-        // Draw mesh
-        glBindVertexArray( this->VAO );
-        glDrawElements( GL_TRIANGLES, this->indices.size( ), GL_UNSIGNED_INT, 0 );
-        glBindVertexArray( 0 );
-        
-        // Always good practice to set everything back to defaults once configured.
+        // The material values themselves are in the MaterialLibrary's uniform buffer
+        shader.setInt( table.materialIndex, this->materialIndex );
+    }
+    
+    void UnbindTextures( ) const
+    {
+        // Only needed before code that doesn't go through the StateTracker, the tracked binds overwrite each other
         for ( GLuint i = 0; i < this->textures.size( ); i++ )
         {
-            glActiveTexture( GL_TEXTURE0 + i );
-            glBindTexture( GL_TEXTURE_2D, 0 );
+            GetStateTracker( ).BindTexture( i, 0 );
         }
     }
     
+    // Frees the CPU copy of the geometry once it lives on the GPU. Counts and bounds stay valid.
+    void ReleaseCpuData( )
+    {
+        vector<Vertex>( ).swap( this->vertices );
+        vector<GLuint>( ).swap( this->indices );
+    }
+    
+    GLuint GetVertexCount( ) const
+    {
+        return this->vertexCount;
+    }
+    
+    GLuint GetIndexCount( ) const
+    {
+        return this->indexCount;
+    }
+    
+    // Bounds of the vertices in the mesh's local space
+    const AABB &GetBounds( ) const
+    {
+        return this->bounds;
+    }
+    
+    const BoundingSphere &GetBoundingSphere( ) const
+    {
+        return this->boundingSphere;
+    }
+    
 private:
     /*  Render data  */
-    GLuint VAO, VBO, EBO;
+    GLuint vertexCount;
+    GLuint indexCount;
+    AABB bounds;
+    BoundingSphere boundingSphere;
     
-    /*  Functions    */
-    // Initializes all the buffer objects/arrays
-    void setupMesh( )
+    // Uniforms of the mesh's textures and material in one program
+    struct SamplerTable
     {
-        // Create buffers/arrays
-        glGenVertexArrays( 1, &this->VAO );
-        glGenBuffers( 1, &this->VBO );
-        glGenBuffers( 1, &this->EBO );
-        
-        glBindVertexArray( this->VAO );
-        // Load data into vertex buffers
-        glBindBuffer( GL_ARRAY_BUFFER, this->VBO );
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData( GL_ARRAY_BUFFER, this->vertices.size( ) * sizeof( Vertex ), &this->vertices[0], GL_STATIC_DRAW );
+        GLuint program;
+        vector<UniformHandle> samplers;    // texture_diffuseN / texture_specularN of each texture, in texture order
+        UniformHandle materialIndex;
+    };
+    mutable vector<SamplerTable> samplerTables;     // One per shader the mesh was drawn with, usually just one
+    
+    const SamplerTable &getSamplerTable( const Shader &shader ) const
+    {
+        for ( GLuint i = 0; i < this->samplerTables.size( ); i++ )
+        {
+            if( this->samplerTables[i].program == shader.ID )
+            {
+                return this->samplerTables[i];
+            }
+        }
         
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, this->EBO );
-        glBufferData( GL_ELEMENT_ARRAY_BUFFER, this->indices.size( ) * sizeof( GLuint ), &this->indices[0], GL_STATIC_DRAW );
+        SamplerTable table;
+        table.program = shader.ID;
         
-        // Set the vertex attribute pointers
-        // Vertex Positions
-        glEnableVertexAttribArray( 0 );
-        glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof( Vertex ), ( GLvoid * )0 );
-        // Vertex Normals
-        glEnableVertexAttribArray( 1 );
-        glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( Vertex ), ( GLvoid * )offsetof( Vertex, Normal ) );
-        // Vertex Texture Coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( Vertex ), ( GLvoid * )offsetof( Vertex, TexCoords ) );
+        // The N in texture_diffuseN counts the textures of each type from 1
+        GLuint numbers[TEXTURE_TYPE_COUNT] = { 0 };
+        for ( GLuint i = 0; i < this->textures.size( ); i++ )
+        {
+            TextureType type = this->textures[i].type;
+            stringstream name;
+            name << GetTextureTypeName( type ) << ++numbers[type];
+            table.samplers.push_back( shader.GetUniform( name.str( ) ) );
+        }
+        table.materialIndex = shader.GetUniform( "materialIndex" );
         
-        glBindVertexArray( 0 );
+        this->samplerTables.push_back( table );
+        return this->samplerTables.back( );
     }
 };
 
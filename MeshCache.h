@@ -0,0 +1,486 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <GL/glew.h>
+
+#include "Mesh.h"
+#include "Materials.h"
+
+using namespace std;
+
+// Binary mesh cache written next to a model file ( "<model>.meshcache" ) after the first Assimp import.
+// Layout of the file:
+//   MeshCacheHeader
+//   Vertex   [vertexCount]   all meshes, back to back (16 byte aligned)
+//   GLuint   [indexCount]    all meshes, back to back (16 byte aligned)
+//   MeshCacheRecord  [meshCount]
+//   MeshCacheTexture [textureCount]
+//   char     [stringBytes]   texture types and paths referenced by MeshCacheTexture
+// Material values are stored in each record, the MaterialLibrary indices only mean something while the program runs.
+// Bump MESH_CACHE_VERSION whenever the layout, the Vertex struct or the import flags change.
+const uint32_t MESH_CACHE_MAGIC = 0x4843534D; // "MSCH"
+const uint32_t MESH_CACHE_VERSION = 3;
+
+// Bits of MeshCacheHeader::importFlags, a cache is only used by a load asking for the same ones
+const uint32_t MESH_CACHE_OPTIMIZED = 1;   // Meshes went through the MeshOptimizer
+const uint32_t MESH_CACHE_SPLIT = 2;       // Meshes too large for 16 bit indices were split
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexSize;
+    uint32_t meshCount;
+    uint64_t sourceHash;    // FNV-1a of the source model file
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t meshOffset;
+    uint64_t textureOffset;
+    uint64_t stringOffset;
+    uint32_t textureCount;
+    uint32_t stringBytes;
+    uint32_t importFlags;
+};
+
+struct MeshCacheRecord
+{
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstTexture;
+    uint32_t textureCount;
+    float diffuse[3];
+    float ambient[3];
+    float specular[3];
+    float shininess;
+};
+
+struct MeshCacheTexture
+{
+    uint32_t typeOffset;
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    MappedFile( ) : data( NULL ), size( 0 )
+    {
+#ifdef _WIN32
+        this->file = INVALID_HANDLE_VALUE;
+        this->mapping = NULL;
+#else
+        this->fd = -1;
+#endif
+    }
+
+    ~MappedFile( )
+    {
+        this->Close( );
+    }
+
+    bool Open( const string &path )
+    {
+        this->Close( );
+#ifdef _WIN32
+        this->file = CreateFileA( path.c_str( ), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        if ( INVALID_HANDLE_VALUE == this->file )
+        {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if ( !GetFileSizeEx( this->file, &fileSize ) || 0 == fileSize.QuadPart )
+        {
+            this->Close( );
+            return false;
+        }
+        this->mapping = CreateFileMappingA( this->file, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( NULL == this->mapping )
+        {
+            this->Close( );
+            return false;
+        }
+        this->data = ( const unsigned char * )MapViewOfFile( this->mapping, FILE_MAP_READ, 0, 0, 0 );
+        this->size = ( size_t )fileSize.QuadPart;
+#else
+        this->fd = open( path.c_str( ), O_RDONLY );
+        if ( -1 == this->fd )
+        {
+            return false;
+        }
+        struct stat st;
+        if ( 0 != fstat( this->fd, &st ) || 0 == st.st_size )
+        {
+            this->Close( );
+            return false;
+        }
+        void *ptr = mmap( NULL, ( size_t )st.st_size, PROT_READ, MAP_PRIVATE, this->fd, 0 );
+        this->data = ( MAP_FAILED == ptr ) ? NULL : ( const unsigned char * )ptr;
+        this->size = ( size_t )st.st_size;
+#endif
+        if ( NULL == this->data )
+        {
+            this->Close( );
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close( )
+    {
+#ifdef _WIN32
+        if ( NULL != this->data )
+        {
+            UnmapViewOfFile( this->data );
+        }
+        if ( NULL != this->mapping )
+        {
+            CloseHandle( this->mapping );
+        }
+        if ( INVALID_HANDLE_VALUE != this->file )
+        {
+            CloseHandle( this->file );
+        }
+        this->file = INVALID_HANDLE_VALUE;
+        this->mapping = NULL;
+#else
+        if ( NULL != this->data )
+        {
+            munmap( ( void * )this->data, this->size );
+        }
+        if ( -1 != this->fd )
+        {
+            close( this->fd );
+        }
+        this->fd = -1;
+#endif
+        this->data = NULL;
+        this->size = 0;
+    }
+
+    const unsigned char *GetData( ) const
+    {
+        return this->data;
+    }
+
+    size_t GetSize( ) const
+    {
+        return this->size;
+    }
+
+private:
+    MappedFile( const MappedFile & );
+    MappedFile &operator=( const MappedFile & );
+
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+};
+
+class MeshCache
+{
+public:
+    MeshCache( ) : header( NULL )
+    {
+    }
+
+    // Hashes the whole content of a file (64 bit FNV-1a). Returns false if the file can't be read.
+    static bool HashFile( const string &path, uint64_t &hash )
+    {
+        hash = 14695981039346656037ULL;
+
+        ifstream file( path.c_str( ), ios::binary );
+        if ( !file )
+        {
+            return false;
+        }
+
+        char buffer[64 * 1024];
+        while ( file )
+        {
+            file.read( buffer, sizeof( buffer ) );
+            streamsize count = file.gcount( );
+            for ( streamsize i = 0; i < count; i++ )
+            {
+                hash ^= ( unsigned char )buffer[i];
+                hash *= 1099511628211ULL;
+            }
+        }
+
+        return true;
+    }
+
+    // Serializes the CPU side data of the given meshes. The file is written to a temporary name first so a
+    // crash half way never leaves a truncated cache behind.
+    static bool Write( const string &cachePath, uint64_t sourceHash, const vector<Mesh> &meshes, uint32_t importFlags = 0 )
+    {
+        MeshCacheHeader header;
+        memset( &header, 0, sizeof( header ) );
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        header.vertexSize = sizeof( Vertex );
+        header.meshCount = ( uint32_t )meshes.size( );
+        header.sourceHash = sourceHash;
+        header.importFlags = importFlags;
+
+        vector<MeshCacheRecord> records( meshes.size( ) );
+        vector<MeshCacheTexture> textures;
+        string strings;
+
+        for ( GLuint i = 0; i < meshes.size( ); i++ )
+        {
+            const Mesh &mesh = meshes[i];
+            MeshCacheRecord &record = records[i];
+            record.firstVertex = ( uint32_t )header.vertexCount;
+            record.vertexCount = ( uint32_t )mesh.vertices.size( );
+            record.firstIndex = ( uint32_t )header.indexCount;
+            record.indexCount = ( uint32_t )mesh.indices.size( );
+            record.firstTexture = ( uint32_t )textures.size( );
+            record.textureCount = ( uint32_t )mesh.textures.size( );
+
+            const Material &material = MaterialLibrary::Instance( ).Get( mesh.materialIndex );
+            for ( int c = 0; c < 3; c++ )
+            {
+                record.diffuse[c] = material.Diffuse[c];
+                record.ambient[c] = material.Ambient[c];
+                record.specular[c] = material.Specular[c];
+            }
+            record.shininess = material.Shininess;
+
+            header.vertexCount += record.vertexCount;
+            header.indexCount += record.indexCount;
+
+            for ( GLuint j = 0; j < mesh.textures.size( ); j++ )
+            {
+                MeshCacheTexture texture;
+                texture.typeOffset = ( uint32_t )strings.size( );
+                const char *typeName = GetTextureTypeName( mesh.textures[j].type );
+                texture.typeLength = ( uint32_t )strlen( typeName );
+                strings += typeName;
+                texture.pathOffset = ( uint32_t )strings.size( );
+                texture.pathLength = ( uint32_t )mesh.textures[j].path.length;
+                strings.append( mesh.textures[j].path.C_Str( ), mesh.textures[j].path.length );
+                textures.push_back( texture );
+            }
+        }
+
+        header.textureCount = ( uint32_t )textures.size( );
+        header.stringBytes = ( uint32_t )strings.size( );
+        header.vertexOffset = Align( sizeof( header ) );
+        header.indexOffset = Align( header.vertexOffset + header.vertexCount * sizeof( Vertex ) );
+        header.meshOffset = Align( header.indexOffset + header.indexCount * sizeof( GLuint ) );
+        header.textureOffset = header.meshOffset + records.size( ) * sizeof( MeshCacheRecord );
+        header.stringOffset = header.textureOffset + textures.size( ) * sizeof( MeshCacheTexture );
+
+        string tempPath = cachePath + ".tmp";
+        ofstream file( tempPath.c_str( ), ios::binary | ios::trunc );
+        if ( !file )
+        {
+            return false;
+        }
+
+        file.write( ( const char * )&header, sizeof( header ) );
+        Pad( file, header.vertexOffset );
+        for ( GLuint i = 0; i < meshes.size( ); i++ )
+        {
+            if ( !meshes[i].vertices.empty( ) )
+            {
+                file.write( ( const char * )&meshes[i].vertices[0], meshes[i].vertices.size( ) * sizeof( Vertex ) );
+            }
+        }
+        Pad( file, header.indexOffset );
+        for ( GLuint i = 0; i < meshes.size( ); i++ )
+        {
+            if ( !meshes[i].indices.empty( ) )
+            {
+                file.write( ( const char * )&meshes[i].indices[0], meshes[i].indices.size( ) * sizeof( GLuint ) );
+            }
+        }
+        Pad( file, header.meshOffset );
+        if ( !records.empty( ) )
+        {
+            file.write( ( const char * )&records[0], records.size( ) * sizeof( MeshCacheRecord ) );
+        }
+        if ( !textures.empty( ) )
+        {
+            file.write( ( const char * )&textures[0], textures.size( ) * sizeof( MeshCacheTexture ) );
+        }
+        file.write( strings.data( ), strings.size( ) );
+
+        bool written = file.good( );
+        file.close( );
+
+        if ( !written )
+        {
+            remove( tempPath.c_str( ) );
+            return false;
+        }
+
+        remove( cachePath.c_str( ) );
+        return 0 == rename( tempPath.c_str( ), cachePath.c_str( ) );
+    }
+
+    // Maps a cache file and validates it against the hash of the current source model and the load's import flags.
+    // Returns false (and leaves the cache closed) if the file is missing, stale or malformed.
+    bool Open( const string &cachePath, uint64_t sourceHash, uint32_t importFlags = 0 )
+    {
+        this->header = NULL;
+
+        if ( !this->file.Open( cachePath ) )
+        {
+            return false;
+        }
+
+        size_t size = this->file.GetSize( );
+        const MeshCacheHeader *h = ( const MeshCacheHeader * )this->file.GetData( );
+
+        if ( size < sizeof( MeshCacheHeader )
+            || MESH_CACHE_MAGIC != h->magic
+            || MESH_CACHE_VERSION != h->version
+            || sizeof( Vertex ) != h->vertexSize
+            || sourceHash != h->sourceHash
+            || importFlags != h->importFlags
+            || h->vertexOffset + h->vertexCount * sizeof( Vertex ) > size
+            || h->indexOffset + h->indexCount * sizeof( GLuint ) > size
+            || h->meshOffset + ( uint64_t )h->meshCount * sizeof( MeshCacheRecord ) > size
+            || h->textureOffset + ( uint64_t )h->textureCount * sizeof( MeshCacheTexture ) > size
+            || h->stringOffset + h->stringBytes > size )
+        {
+            this->file.Close( );
+            return false;
+        }
+
+        // Make sure every record points inside the blobs so a corrupt file can't make us read out of bounds
+        const MeshCacheRecord *records = ( const MeshCacheRecord * )( this->file.GetData( ) + h->meshOffset );
+        for ( GLuint i = 0; i < h->meshCount; i++ )
+        {
+            if ( ( uint64_t )records[i].firstVertex + records[i].vertexCount > h->vertexCount
+                || ( uint64_t )records[i].firstIndex + records[i].indexCount > h->indexCount
+                || ( uint64_t )records[i].firstTexture + records[i].textureCount > h->textureCount )
+            {
+                this->file.Close( );
+                return false;
+            }
+        }
+
+        const MeshCacheTexture *textures = ( const MeshCacheTexture * )( this->file.GetData( ) + h->textureOffset );
+        for ( GLuint i = 0; i < h->textureCount; i++ )
+        {
+            if ( ( uint64_t )textures[i].typeOffset + textures[i].typeLength > h->stringBytes
+                || ( uint64_t )textures[i].pathOffset + textures[i].pathLength > h->stringBytes )
+            {
+                this->file.Close( );
+                return false;
+            }
+        }
+
+        this->header = h;
+
+        return true;
+    }
+
+    GLuint GetMeshCount( ) const
+    {
+        return this->header->meshCount;
+    }
+
+    const MeshCacheRecord &GetMesh( GLuint i ) const
+    {
+        return ( ( const MeshCacheRecord * )( this->file.GetData( ) + this->header->meshOffset ) )[i];
+    }
+
+    // Pointers straight into the mapping, valid as long as this MeshCache is alive
+    const Vertex *GetVertices( const MeshCacheRecord &record ) const
+    {
+        return ( ( const Vertex * )( this->file.GetData( ) + this->header->vertexOffset ) ) + record.firstVertex;
+    }
+
+    const GLuint *GetIndices( const MeshCacheRecord &record ) const
+    {
+        return ( ( const GLuint * )( this->file.GetData( ) + this->header->indexOffset ) ) + record.firstIndex;
+    }
+
+    static Material GetMaterial( const MeshCacheRecord &record )
+    {
+        Material material;
+        material.Diffuse = glm::vec3( record.diffuse[0], record.diffuse[1], record.diffuse[2] );
+        material.Ambient = glm::vec3( record.ambient[0], record.ambient[1], record.ambient[2] );
+        material.Specular = glm::vec3( record.specular[0], record.specular[1], record.specular[2] );
+        material.Shininess = record.shininess;
+
+        return material;
+    }
+
+    TextureType GetTextureType( GLuint i ) const
+    {
+        const MeshCacheTexture &texture = this->getTexture( i );
+        return GetTextureTypeFromName( string( this->getStrings( ) + texture.typeOffset, texture.typeLength ) );
+    }
+
+    string GetTexturePath( GLuint i ) const
+    {
+        const MeshCacheTexture &texture = this->getTexture( i );
+        return string( this->getStrings( ) + texture.pathOffset, texture.pathLength );
+    }
+
+private:
+    MappedFile file;
+    const MeshCacheHeader *header;
+
+    const MeshCacheTexture &getTexture( GLuint i ) const
+    {
+        return ( ( const MeshCacheTexture * )( this->file.GetData( ) + this->header->textureOffset ) )[i];
+    }
+
+    const char *getStrings( ) const
+    {
+        return ( const char * )( this->file.GetData( ) + this->header->stringOffset );
+    }
+
+    static uint64_t Align( uint64_t offset )
+    {
+        return ( offset + 15 ) & ~( uint64_t )15;
+    }
+
+    static void Pad( ofstream &file, uint64_t offset )
+    {
+        while ( ( uint64_t )file.tellp( ) < offset )
+        {
+            file.put( 0 );
+        }
+    }
+};
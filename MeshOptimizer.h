@@ -0,0 +1,373 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+using namespace std;
+
+// Post transform cache size the ACMR/ATVR figures are measured with, a typical FIFO of older and current GPUs
+#define MESH_OPTIMIZER_FIFO_SIZE 16
+// LRU cache size the vertex cache ordering models (Forsyth's recommended value)
+#define MESH_OPTIMIZER_LRU_SIZE 32
+
+// Vertex shader invocations per triangle (ACMR, 0.5 is ideal for big regular meshes, 3 is the worst) and per
+// vertex (ATVR, 1 is ideal), both against a FIFO cache of MESH_OPTIMIZER_FIFO_SIZE entries
+struct VertexCacheStats
+{
+    GLfloat acmr;
+    GLfloat atvr;
+};
+
+// Index and vertex order optimizations for triangle lists, applied to imported meshes before upload:
+//   OptimizeVertexCache( )   Forsyth's "Linear-speed vertex cache optimisation", reorders the triangles so their
+//                            vertices are still in the post transform cache when they are used again
+//   OptimizeOverdraw( )      keeps the cache friendly runs of triangles but orders them outside in, so the parts that
+//                            usually hide others are drawn first (Sander, Nehab & Barczak's "Tipsify" clusters)
+//   OptimizeVertexFetch( )   stores the vertices in the order the indices first use them, for linear fetches
+class MeshOptimizer
+{
+public:
+    // The three passes, in order
+    static void Optimize( vector<Vertex> &vertices, vector<GLuint> &indices )
+    {
+        OptimizeVertexCache( indices, vertices.size( ) );
+        OptimizeOverdraw( indices, vertices );
+        OptimizeVertexFetch( vertices, indices );
+    }
+
+    static VertexCacheStats AnalyzeVertexCache( const vector<GLuint> &indices, size_t vertexCount )
+    {
+        VertexCacheStats stats = { 0.0f, 0.0f };
+        if( indices.size( ) < 3 )
+        {
+            return stats;
+        }
+
+        vector<GLuint> fifo( MESH_OPTIMIZER_FIFO_SIZE, ( GLuint )-1 );
+        vector<unsigned char> used( vertexCount, 0 );
+        size_t head = 0, misses = 0, usedCount = 0;
+
+        for ( size_t i = 0; i < indices.size( ); i++ )
+        {
+            GLuint index = indices[i];
+            if( fifo.end( ) == std::find( fifo.begin( ), fifo.end( ), index ) )
+            {
+                fifo[head] = index;
+                head = ( head + 1 ) % MESH_OPTIMIZER_FIFO_SIZE;
+                misses++;
+            }
+            if( !used[index] )
+            {
+                used[index] = 1;
+                usedCount++;
+            }
+        }
+
+        stats.acmr = ( GLfloat )misses / ( indices.size( ) / 3 );
+        stats.atvr = ( GLfloat )misses / usedCount;
+
+        return stats;
+    }
+
+    static void OptimizeVertexCache( vector<GLuint> &indices, size_t vertexCount )
+    {
+        size_t triangleCount = indices.size( ) / 3;
+        if( 0 == triangleCount )
+        {
+            return;
+        }
+
+        // Triangles of each vertex, as one list indexed by offsets
+        vector<GLuint> offsets( vertexCount + 1, 0 );
+        for ( size_t i = 0; i < triangleCount * 3; i++ )
+        {
+            offsets[indices[i] + 1]++;
+        }
+        for ( size_t v = 0; v < vertexCount; v++ )
+        {
+            offsets[v + 1] += offsets[v];
+        }
+        vector<GLuint> adjacency( triangleCount * 3 );
+        vector<GLuint> fill( offsets.begin( ), offsets.end( ) - 1 );
+        for ( size_t i = 0; i < triangleCount * 3; i++ )
+        {
+            adjacency[fill[indices[i]]++] = ( GLuint )( i / 3 );
+        }
+
+        // Triangles not emitted yet per vertex, they are the first remaining[v] entries of the vertex's list
+        vector<GLuint> remaining( vertexCount );
+        vector<GLfloat> vertexScore( vertexCount );
+        for ( size_t v = 0; v < vertexCount; v++ )
+        {
+            remaining[v] = offsets[v + 1] - offsets[v];
+            vertexScore[v] = scoreVertex( -1, remaining[v] );
+        }
+
+        vector<GLfloat> triangleScore( triangleCount );
+        vector<unsigned char> emitted( triangleCount, 0 );
+        for ( size_t t = 0; t < triangleCount; t++ )
+        {
+            triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        }
+
+        vector<GLuint> result;
+        result.reserve( triangleCount * 3 );
+        vector<GLuint> cache, nextCache;
+        cache.reserve( MESH_OPTIMIZER_LRU_SIZE + 3 );
+        nextCache.reserve( MESH_OPTIMIZER_LRU_SIZE + 3 );
+
+        size_t cursor = 0;      // Every triangle before it was emitted, to restart from when the cache leads nowhere
+        int best = nextTriangle( emitted, cursor );
+
+        while ( best >= 0 )
+        {
+            const GLuint *triangle = &indices[best * 3];
+            result.insert( result.end( ), triangle, triangle + 3 );
+            emitted[best] = 1;
+
+            // The triangle's vertices move to the front of the cache, everything else shifts back
+            nextCache.clear( );
+            for ( int k = 0; k < 3; k++ )
+            {
+                if( nextCache.end( ) == std::find( nextCache.begin( ), nextCache.end( ), triangle[k] ) )
+                {
+                    nextCache.push_back( triangle[k] );
+                }
+            }
+            for ( size_t i = 0; i < cache.size( ); i++ )
+            {
+                if( cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2] )
+                {
+                    nextCache.push_back( cache[i] );
+                }
+            }
+            for ( int k = 0; k < 3; k++ )
+            {
+                removeTriangle( triangle[k], ( GLuint )best, offsets, adjacency, remaining );
+            }
+
+            // Rescore the vertices that were or are in the cache and the triangles around them, then pick the best
+            // of those triangles
+            for ( size_t i = 0; i < nextCache.size( ); i++ )
+            {
+                GLuint v = nextCache[i];
+                GLfloat score = scoreVertex( ( i < MESH_OPTIMIZER_LRU_SIZE ) ? ( int )i : -1, remaining[v] );
+                GLfloat delta = score - vertexScore[v];
+                vertexScore[v] = score;
+
+                for ( GLuint a = offsets[v]; a < offsets[v] + remaining[v]; a++ )
+                {
+                    triangleScore[adjacency[a]] += delta;
+                }
+            }
+
+            GLfloat bestScore = -1.0f;
+            best = -1;
+            for ( size_t i = 0; i < nextCache.size( ) && i < MESH_OPTIMIZER_LRU_SIZE; i++ )
+            {
+                GLuint v = nextCache[i];
+                for ( GLuint a = offsets[v]; a < offsets[v] + remaining[v]; a++ )
+                {
+                    if( triangleScore[adjacency[a]] > bestScore )
+                    {
+                        bestScore = triangleScore[adjacency[a]];
+                        best = ( int )adjacency[a];
+                    }
+                }
+            }
+
+            if( nextCache.size( ) > MESH_OPTIMIZER_LRU_SIZE )
+            {
+                nextCache.resize( MESH_OPTIMIZER_LRU_SIZE );
+            }
+            cache.swap( nextCache );
+
+            if( best < 0 )
+            {
+                best = nextTriangle( emitted, cursor );
+            }
+        }
+
+        indices.swap( result );
+    }
+
+    // threshold is how much worse (as a factor of ACMR) the cache efficiency may get in exchange for less overdraw
+    static void OptimizeOverdraw( vector<GLuint> &indices, const vector<Vertex> &vertices, GLfloat threshold = 1.05f )
+    {
+        size_t triangleCount = indices.size( ) / 3;
+        if( triangleCount < 2 )
+        {
+            return;
+        }
+
+        // A cluster starts wherever the cache ordering had to start over: a triangle whose three vertices all miss
+        vector<GLuint> clusterStart;
+        vector<GLuint> fifo( MESH_OPTIMIZER_FIFO_SIZE, ( GLuint )-1 );
+        size_t head = 0;
+        for ( size_t t = 0; t < triangleCount; t++ )
+        {
+            int misses = 0;
+            for ( int k = 0; k < 3; k++ )
+            {
+                GLuint index = indices[t * 3 + k];
+                if( fifo.end( ) == std::find( fifo.begin( ), fifo.end( ), index ) )
+                {
+                    fifo[head] = index;
+                    head = ( head + 1 ) % MESH_OPTIMIZER_FIFO_SIZE;
+                    misses++;
+                }
+            }
+            if( 0 == t || 3 == misses )
+            {
+                clusterStart.push_back( ( GLuint )t );
+            }
+        }
+        if( clusterStart.size( ) < 2 )
+        {
+            return;
+        }
+        clusterStart.push_back( ( GLuint )triangleCount );
+
+        // Area weighted centroid and normal of every cluster and of the whole mesh
+        size_t clusterCount = clusterStart.size( ) - 1;
+        vector<glm::vec3> centroids( clusterCount ), normals( clusterCount );
+        glm::vec3 meshCentroid( 0.0f );
+        GLfloat meshArea = 0.0f;
+        for ( size_t c = 0; c < clusterCount; c++ )
+        {
+            glm::vec3 centroid( 0.0f ), normal( 0.0f );
+            GLfloat area = 0.0f;
+            for ( GLuint t = clusterStart[c]; t < clusterStart[c + 1]; t++ )
+            {
+                const glm::vec3 &a = vertices[indices[t * 3]].Position;
+                const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3 &d = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 cross = glm::cross( b - a, d - a );
+                GLfloat triangleArea = glm::length( cross );
+                centroid += ( a + b + d ) * ( triangleArea / 3.0f );
+                normal += cross;
+                area += triangleArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+            centroids[c] = ( area > 0.0f ) ? centroid / area : vertices[indices[clusterStart[c] * 3]].Position;
+            GLfloat length = glm::length( normal );
+            normals[c] = ( length > 0.0f ) ? normal / length : glm::vec3( 0.0f );
+        }
+        if( meshArea > 0.0f )
+        {
+            meshCentroid /= meshArea;
+        }
+
+        // Clusters facing away from the center, the outer shell, first
+        vector<GLfloat> sortKey( clusterCount );
+        vector<GLuint> order( clusterCount );
+        for ( size_t c = 0; c < clusterCount; c++ )
+        {
+            sortKey[c] = glm::dot( centroids[c] - meshCentroid, normals[c] );
+            order[c] = ( GLuint )c;
+        }
+        std::stable_sort( order.begin( ), order.end( ), [&sortKey]( GLuint a, GLuint b )
+        {
+            return sortKey[a] > sortKey[b];
+        } );
+
+        vector<GLuint> result;
+        result.reserve( indices.size( ) );
+        for ( size_t i = 0; i < clusterCount; i++ )
+        {
+            GLuint c = order[i];
+            result.insert( result.end( ), indices.begin( ) + clusterStart[c] * 3, indices.begin( ) + clusterStart[c + 1] * 3 );
+        }
+
+        // Clusters start on a cold cache, so the new order rarely costs anything; keep the old one if it does
+        if( AnalyzeVertexCache( result, vertices.size( ) ).acmr <= AnalyzeVertexCache( indices, vertices.size( ) ).acmr * threshold )
+        {
+            indices.swap( result );
+        }
+    }
+
+    // Reorders the vertices by first use and drops the ones no index refers to
+    static void OptimizeVertexFetch( vector<Vertex> &vertices, vector<GLuint> &indices )
+    {
+        const GLuint UNUSED = ( GLuint )-1;
+        vector<GLuint> remap( vertices.size( ), UNUSED );
+        vector<Vertex> result;
+        result.reserve( vertices.size( ) );
+
+        for ( size_t i = 0; i < indices.size( ); i++ )
+        {
+            GLuint &index = indices[i];
+            if( UNUSED == remap[index] )
+            {
+                remap[index] = ( GLuint )result.size( );
+                result.push_back( vertices[index] );
+            }
+            index = remap[index];
+        }
+
+        vertices.swap( result );
+    }
+
+private:
+    // Forsyth's vertex score: recently used vertices score high (the last triangle's three a bit less, so strips
+    // don't win over fans) and vertices with few triangles left get a boost, so no vertex is left behind alone
+    static GLfloat scoreVertex( int cachePosition, GLuint remainingTriangles )
+    {
+        if( 0 == remainingTriangles )
+        {
+            return -1.0f;
+        }
+
+        GLfloat score = 0.0f;
+        if( cachePosition >= 0 )
+        {
+            if( cachePosition < 3 )
+            {
+                score = 0.75f;
+            }
+            else
+            {
+                GLfloat scale = 1.0f - ( cachePosition - 3 ) / ( GLfloat )( MESH_OPTIMIZER_LRU_SIZE - 3 );
+                score = std::pow( scale, 1.5f );
+            }
+        }
+
+        return score + 2.0f / std::sqrt( ( GLfloat )remainingTriangles );
+    }
+
+    // Moves triangle to the end of vertex's list, out of its remaining triangles
+    static void removeTriangle( GLuint vertex, GLuint triangle, const vector<GLuint> &offsets, vector<GLuint> &adjacency, vector<GLuint> &remaining )
+    {
+        GLuint first = offsets[vertex];
+        GLuint last = first + remaining[vertex] - 1;
+        for ( GLuint a = first; a <= last; a++ )
+        {
+            if( adjacency[a] == triangle )
+            {
+                std::swap( adjacency[a], adjacency[last] );
+                remaining[vertex]--;
+                return;
+            }
+        }
+    }
+
+    // First triangle in input order not emitted yet, -1 once all are. Scanning for the best score instead would make
+    // the pass quadratic on meshes that often run out of cached triangles.
+    static int nextTriangle( const vector<unsigned char> &emitted, size_t &cursor )
+    {
+        while ( cursor < emitted.size( ) && emitted[cursor] )
+        {
+            cursor++;
+        }
+
+        return ( cursor == emitted.size( ) ) ? -1 : ( int )cursor;
+    }
+};
@@ -0,0 +1,495 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+using namespace std;
+
+// Vertices at one position whose normals and texture coordinates differ more than this are a seam, which is kept
+#define MESH_SIMPLIFIER_ATTRIBUTE_EPSILON 1e-3f
+// Weight of the planes holding open borders in place, relative to the surface planes
+#define MESH_SIMPLIFIER_BORDER_WEIGHT 10.0f
+
+// Quadric error metric (Garland & Heckbert) simplification by half edge collapses: a vertex is merged into a
+// neighbour, so the simplified index lists only use the original vertices and every level of detail can share the
+// mesh's vertex range. Topology comes from the positions (Assimp imports without joining identical vertices), and
+// the attributes are protected: vertices on normal or texture seams and on non-manifold edges never move, vertices on
+// open borders only slide along them.
+// Usage: build it once per mesh, then call Simplify( ) with smaller and smaller targets; each call carries on from
+// the previous one.
+class MeshSimplifier
+{
+public:
+    /*  Functions   */
+    MeshSimplifier( const Vertex *vertices, GLuint vertexCount, const GLuint *indices, GLuint indexCount )
+        : vertices( vertices ), liveTriangles( 0 ), maxError( 0.0f )
+    {
+        this->weldPositions( vertexCount );
+        this->corners.assign( indices, indices + indexCount - indexCount % 3 );
+        this->removed.assign( this->corners.size( ) / 3, 0 );
+        this->vertexTriangles.resize( vertexCount );
+        this->version.assign( vertexCount, 0 );
+
+        for ( GLuint t = 0; t < this->removed.size( ); t++ )
+        {
+            GLuint a = this->welded( t, 0 ), b = this->welded( t, 1 ), c = this->welded( t, 2 );
+            if( a == b || b == c || a == c )
+            {
+                this->removed[t] = 1;
+                continue;
+            }
+            this->vertexTriangles[a].push_back( t );
+            this->vertexTriangles[b].push_back( t );
+            this->vertexTriangles[c].push_back( t );
+            this->liveTriangles++;
+        }
+
+        this->classifyVertices( );
+        this->computeQuadrics( );
+
+        for ( GLuint t = 0; t < this->removed.size( ); t++ )
+        {
+            for ( GLuint k = 0; !this->removed[t] && k < 3; k++ )
+            {
+                this->pushCollapse( this->welded( t, k ), this->welded( t, ( k + 1 ) % 3 ) );
+                this->pushCollapse( this->welded( t, ( k + 1 ) % 3 ), this->welded( t, k ) );
+            }
+        }
+    }
+
+    // Collapses the cheapest edges until at most targetIndexCount indices are left or no collapse is allowed anymore,
+    // and writes the remaining triangles to result. Returns the error so far, the largest root mean square distance
+    // (in model units) a collapsed vertex had from the surface it replaced.
+    GLfloat Simplify( GLuint targetIndexCount, vector<GLuint> &result )
+    {
+        while ( this->liveTriangles * 3 > targetIndexCount && !this->queue.empty( ) )
+        {
+            Collapse collapse = this->queue.top( );
+            this->queue.pop( );
+
+            if( collapse.fromVersion != this->version[collapse.from] || collapse.toVersion != this->version[collapse.to]
+                || DEAD == this->kinds[collapse.from] || DEAD == this->kinds[collapse.to] || !this->canCollapse( collapse.from, collapse.to ) )
+            {
+                continue;
+            }
+
+            this->collapse( collapse.from, collapse.to );
+            this->maxError = std::max( this->maxError, std::sqrt( std::max( collapse.cost, 0.0f ) ) );
+        }
+
+        result.clear( );
+        result.reserve( this->liveTriangles * 3 );
+        for ( GLuint t = 0; t < this->removed.size( ); t++ )
+        {
+            if( !this->removed[t] )
+            {
+                result.insert( result.end( ), &this->corners[t * 3], &this->corners[t * 3] + 3 );
+            }
+        }
+
+        return this->maxError;
+    }
+
+    GLuint GetIndexCount( ) const
+    {
+        return this->liveTriangles * 3;
+    }
+
+private:
+    enum VertexKind
+    {
+        FREE,       // Moves anywhere
+        BORDER,     // On an open border, moves along it
+        LOCKED,     // Seam or non-manifold, never moves
+        DEAD        // Collapsed into another vertex
+    };
+
+    // Symmetric 4x4 matrix of the plane equations, plus the area they were weighted with
+    struct Quadric
+    {
+        // Doubles, the d terms of models far from their origin cancel out in float
+        double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+        double weight;
+
+        void Add( const Quadric &other )
+        {
+            double *values = &this->a2;
+            const double *others = &other.a2;
+            for ( int i = 0; i < 11; i++ )
+            {
+                values[i] += others[i];
+            }
+        }
+
+        void AddPlane( const glm::vec3 &normal, double d, double weight )
+        {
+            this->a2 += weight * normal.x * normal.x;
+            this->ab += weight * normal.x * normal.y;
+            this->ac += weight * normal.x * normal.z;
+            this->ad += weight * normal.x * d;
+            this->b2 += weight * normal.y * normal.y;
+            this->bc += weight * normal.y * normal.z;
+            this->bd += weight * normal.y * d;
+            this->c2 += weight * normal.z * normal.z;
+            this->cd += weight * normal.z * d;
+            this->d2 += weight * d * d;
+            this->weight += weight;
+        }
+
+        // Mean squared distance of p from the planes
+        GLfloat Evaluate( const glm::vec3 &p ) const
+        {
+            double sum = p.x * ( this->a2 * p.x + 2.0f * ( this->ab * p.y + this->ac * p.z + this->ad ) )
+                + p.y * ( this->b2 * p.y + 2.0f * ( this->bc * p.z + this->bd ) )
+                + p.z * ( this->c2 * p.z + 2.0f * this->cd ) + this->d2;
+            return ( GLfloat )( ( this->weight > 0.0 ) ? sum / this->weight : 0.0 );
+        }
+    };
+
+    // Merge of vertex from into vertex to, queued by cost
+    struct Collapse
+    {
+        GLfloat cost;
+        GLuint from, to;
+        GLuint fromVersion, toVersion;
+
+        bool operator<( const Collapse &other ) const
+        {
+            return this->cost > other.cost;     // Cheapest on top
+        }
+    };
+
+    const Vertex *vertices;
+    vector<GLuint> weld;                        // Vertex -> first vertex at its position, which stands for all of them
+    vector<GLuint> corners;                     // Triangles, as vertices
+    vector<unsigned char> removed;              // Triangles collapsed away
+    vector<vector<GLuint> > vertexTriangles;    // Welded vertex -> triangles using it (removed ones too)
+    vector<unsigned char> kinds;                // VertexKind of each welded vertex
+    vector<Quadric> quadrics;
+    vector<GLuint> version;                     // Bumped when a welded vertex's quadric changes
+    priority_queue<Collapse> queue;
+    GLuint liveTriangles;
+    GLfloat maxError;
+
+    GLuint welded( GLuint triangle, GLuint corner ) const
+    {
+        return this->weld[this->corners[triangle * 3 + corner]];
+    }
+
+    glm::vec3 position( GLuint vertex ) const
+    {
+        return this->vertices[vertex].Position;
+    }
+
+    // Groups vertices with exactly the same position
+    void weldPositions( GLuint vertexCount )
+    {
+        vector<GLuint> order( vertexCount );
+        for ( GLuint i = 0; i < vertexCount; i++ )
+        {
+            order[i] = i;
+        }
+
+        const Vertex *vertices = this->vertices;
+        std::sort( order.begin( ), order.end( ), [vertices]( GLuint a, GLuint b )
+        {
+            const glm::vec3 &p = vertices[a].Position, &q = vertices[b].Position;
+            return ( p.x != q.x ) ? p.x < q.x : ( ( p.y != q.y ) ? p.y < q.y : ( p.z != q.z ? p.z < q.z : a < b ) );
+        } );
+
+        this->weld.resize( vertexCount );
+        for ( GLuint i = 0; i < vertexCount; i++ )
+        {
+            bool same = ( i > 0 ) && 0 == memcmp( &vertices[order[i]].Position, &vertices[order[i - 1]].Position, sizeof( glm::vec3 ) );
+            this->weld[order[i]] = same ? this->weld[order[i - 1]] : order[i];
+        }
+    }
+
+    // Locks seams and non-manifold edges, marks open borders
+    void classifyVertices( )
+    {
+        this->kinds.assign( this->weld.size( ), FREE );
+
+        for ( GLuint i = 0; i < this->weld.size( ); i++ )
+        {
+            const Vertex &vertex = this->vertices[i], &rep = this->vertices[this->weld[i]];
+            if( glm::length( vertex.Normal - rep.Normal ) > MESH_SIMPLIFIER_ATTRIBUTE_EPSILON
+                || glm::length( vertex.TexCoords - rep.TexCoords ) > MESH_SIMPLIFIER_ATTRIBUTE_EPSILON )
+            {
+                this->kinds[this->weld[i]] = LOCKED;
+            }
+        }
+
+        // Every welded edge once per triangle using it, sorted so uses of the same edge are next to each other
+        vector<pair<GLuint, GLuint> > edges;
+        edges.reserve( this->liveTriangles * 3 );
+        for ( GLuint t = 0; t < this->removed.size( ); t++ )
+        {
+            for ( GLuint k = 0; !this->removed[t] && k < 3; k++ )
+            {
+                GLuint a = this->welded( t, k ), b = this->welded( t, ( k + 1 ) % 3 );
+                edges.push_back( make_pair( std::min( a, b ), std::max( a, b ) ) );
+            }
+        }
+        std::sort( edges.begin( ), edges.end( ) );
+
+        for ( size_t i = 0; i < edges.size( ); )
+        {
+            size_t uses = 1;
+            while ( i + uses < edges.size( ) && edges[i + uses] == edges[i] )
+            {
+                uses++;
+            }
+
+            GLuint ends[2] = { edges[i].first, edges[i].second };
+            for ( int k = 0; k < 2; k++ )
+            {
+                if( uses > 2 )
+                {
+                    this->kinds[ends[k]] = LOCKED;
+                }
+                else if( 1 == uses && FREE == this->kinds[ends[k]] )
+                {
+                    this->kinds[ends[k]] = BORDER;
+                }
+            }
+            i += uses;
+        }
+    }
+
+    // Area weighted planes of the triangles around each welded vertex, plus planes along the open borders
+    void computeQuadrics( )
+    {
+        Quadric zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        this->quadrics.assign( this->weld.size( ), zero );
+
+        for ( GLuint t = 0; t < this->removed.size( ); t++ )
+        {
+            if( this->removed[t] )
+            {
+                continue;
+            }
+
+            GLuint v[3] = { this->welded( t, 0 ), this->welded( t, 1 ), this->welded( t, 2 ) };
+            glm::vec3 p[3] = { this->position( v[0] ), this->position( v[1] ), this->position( v[2] ) };
+            glm::vec3 normal = glm::cross( p[1] - p[0], p[2] - p[0] );
+            GLfloat length = glm::length( normal );
+            if( length <= 0.0f )
+            {
+                continue;
+            }
+            normal /= length;
+
+            Quadric plane = zero;
+            plane.AddPlane( normal, -glm::dot( normal, p[0] ), length * 0.5f );
+            for ( int k = 0; k < 3; k++ )
+            {
+                this->quadrics[v[k]].Add( plane );
+            }
+
+            for ( int k = 0; k < 3; k++ )
+            {
+                GLuint a = v[k], b = v[( k + 1 ) % 3];
+                if( 1 != this->countTrianglesWithEdge( a, b ) )
+                {
+                    continue;
+                }
+
+                // Plane through the border edge, perpendicular to the triangle
+                glm::vec3 edge = p[( k + 1 ) % 3] - p[k];
+                glm::vec3 borderNormal = glm::cross( edge, normal );
+                GLfloat borderLength = glm::length( borderNormal );
+                if( borderLength <= 0.0f )
+                {
+                    continue;
+                }
+                borderNormal /= borderLength;
+
+                Quadric border = zero;
+                border.AddPlane( borderNormal, -glm::dot( borderNormal, p[k] ), glm::dot( edge, edge ) * MESH_SIMPLIFIER_BORDER_WEIGHT );
+                this->quadrics[a].Add( border );
+                this->quadrics[b].Add( border );
+            }
+        }
+    }
+
+    GLuint countTrianglesWithEdge( GLuint a, GLuint b ) const
+    {
+        GLuint count = 0;
+        const vector<GLuint> &triangles = this->vertexTriangles[a];
+        for ( size_t i = 0; i < triangles.size( ); i++ )
+        {
+            GLuint t = triangles[i];
+            if( !this->removed[t] && ( b == this->welded( t, 0 ) || b == this->welded( t, 1 ) || b == this->welded( t, 2 ) ) )
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    void pushCollapse( GLuint from, GLuint to )
+    {
+        if( LOCKED == this->kinds[from] )
+        {
+            return;
+        }
+
+        Quadric merged = this->quadrics[from];
+        merged.Add( this->quadrics[to] );
+
+        Collapse collapse;
+        collapse.cost = merged.Evaluate( this->position( to ) );
+        collapse.from = from;
+        collapse.to = to;
+        collapse.fromVersion = this->version[from];
+        collapse.toVersion = this->version[to];
+        this->queue.push( collapse );
+    }
+
+    // Welded vertices sharing a live triangle with vertex
+    void collectNeighbours( GLuint vertex, vector<GLuint> &neighbours ) const
+    {
+        neighbours.clear( );
+        const vector<GLuint> &triangles = this->vertexTriangles[vertex];
+        for ( size_t i = 0; i < triangles.size( ); i++ )
+        {
+            for ( GLuint k = 0; !this->removed[triangles[i]] && k < 3; k++ )
+            {
+                GLuint other = this->welded( triangles[i], k );
+                if( other != vertex && neighbours.end( ) == std::find( neighbours.begin( ), neighbours.end( ), other ) )
+                {
+                    neighbours.push_back( other );
+                }
+            }
+        }
+    }
+
+    bool canCollapse( GLuint from, GLuint to )
+    {
+        GLuint sharedTriangles = this->countTrianglesWithEdge( from, to );
+        if( 0 == sharedTriangles || ( BORDER == this->kinds[from] && 1 != sharedTriangles ) )
+        {
+            return false;
+        }
+
+        // Link condition: the only vertices both ends see are the tips of the triangles on the edge, anything else
+        // would fold the surface onto itself
+        this->collectNeighbours( from, this->fromNeighbours );
+        this->collectNeighbours( to, this->toNeighbours );
+        GLuint common = 0;
+        for ( size_t i = 0; i < this->fromNeighbours.size( ); i++ )
+        {
+            if( this->toNeighbours.end( ) != std::find( this->toNeighbours.begin( ), this->toNeighbours.end( ), this->fromNeighbours[i] ) )
+            {
+                common++;
+            }
+        }
+        if( common != sharedTriangles )
+        {
+            return false;
+        }
+
+        // No remaining triangle may flip or collapse to a line
+        glm::vec3 target = this->position( to );
+        const vector<GLuint> &triangles = this->vertexTriangles[from];
+        for ( size_t i = 0; i < triangles.size( ); i++ )
+        {
+            GLuint t = triangles[i];
+            if( this->removed[t] )
+            {
+                continue;
+            }
+
+            glm::vec3 before[3], after[3];
+            bool hasTo = false;
+            for ( GLuint k = 0; k < 3; k++ )
+            {
+                GLuint v = this->welded( t, k );
+                hasTo = hasTo || ( v == to );
+                before[k] = this->position( v );
+                after[k] = ( v == from ) ? target : before[k];
+            }
+            if( hasTo )
+            {
+                continue;   // Goes away with the collapse
+            }
+
+            glm::vec3 oldNormal = glm::cross( before[1] - before[0], before[2] - before[0] );
+            glm::vec3 newNormal = glm::cross( after[1] - after[0], after[2] - after[0] );
+            if( glm::dot( oldNormal, newNormal ) <= 1e-4f * glm::dot( oldNormal, oldNormal ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void collapse( GLuint from, GLuint to )
+    {
+        // The triangles that move over take the attributes to has on the collapsed edge
+        GLuint target = to;
+        vector<GLuint> &triangles = this->vertexTriangles[from];
+        for ( size_t i = 0; i < triangles.size( ) && target == to; i++ )
+        {
+            for ( GLuint k = 0; !this->removed[triangles[i]] && k < 3; k++ )
+            {
+                if( to == this->welded( triangles[i], k ) )
+                {
+                    target = this->corners[triangles[i] * 3 + k];
+                }
+            }
+        }
+
+        for ( size_t i = 0; i < triangles.size( ); i++ )
+        {
+            GLuint t = triangles[i];
+            if( this->removed[t] )
+            {
+                continue;
+            }
+
+            bool hasTo = ( to == this->welded( t, 0 ) || to == this->welded( t, 1 ) || to == this->welded( t, 2 ) );
+            if( hasTo )
+            {
+                this->removed[t] = 1;
+                this->liveTriangles--;
+                continue;
+            }
+
+            for ( GLuint k = 0; k < 3; k++ )
+            {
+                if( from == this->welded( t, k ) )
+                {
+                    this->corners[t * 3 + k] = target;
+                }
+            }
+            this->vertexTriangles[to].push_back( t );
+        }
+        vector<GLuint>( ).swap( triangles );
+
+        this->quadrics[to].Add( this->quadrics[from] );
+        this->kinds[from] = DEAD;
+        this->version[to]++;
+
+        // Every edge at to now costs something else
+        this->collectNeighbours( to, this->toNeighbours );
+        for ( size_t i = 0; i < this->toNeighbours.size( ); i++ )
+        {
+            this->pushCollapse( this->toNeighbours[i], to );
+            this->pushCollapse( to, this->toNeighbours[i] );
+        }
+    }
+
+    // Scratch of canCollapse( ) and collapse( )
+    vector<GLuint> fromNeighbours, toNeighbours;
+};
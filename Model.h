@@ -16,48 +16,351 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "GeometryArena.h"
+#include "MultiDraw.h"
+#include "RenderQueue.h"
+#include "Materials.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Lod.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+#include "TextureLoader.h"
+#include "TextureCache.h"
 
 using namespace std;
 
-GLint TextureFromFile( const char *path, string directory );
+// Options controlling how a Model is loaded
+struct ModelLoadOptions
+{
+    // Read/write the binary mesh cache next to the model file
+    bool useMeshCache;
+    // Threads used to convert the Assimp meshes: 1 keeps everything on the calling thread, 0 uses one per hardware thread.
+    // GL objects are always created on the calling (context) thread.
+    GLuint loaderThreads;
+    // When set, material textures are decoded and uploaded in the background by this loader and show a
+    // placeholder until they are resident. The caller must keep it alive and call Update( ) every frame.
+    AsyncTextureLoader *textureLoader;
+    // Frees each mesh's CPU copy of its vertices and indices once they are uploaded (and written to the mesh cache).
+    // Meshes loaded from the cache never keep one.
+    bool releaseCpuData;
+    // Runs the MeshOptimizer passes (vertex cache, overdraw and vertex fetch order) on every imported mesh and prints
+    // each mesh's ACMR/ATVR before and after. The mesh cache keeps optimized and plain imports apart.
+    bool optimizeMeshes;
+    // Layout of the vertices on the GPU. VERTEX_FORMAT_COMPACT halves their memory and fetch bandwidth, positions are
+    // then quantized to 1/65535 of the model's bounds. The CPU copy and the mesh cache always keep float vertices.
+    VertexFormat vertexFormat;
+    // Stores the indices as 16 bit when no mesh has more than MAX_SHORT_INDEX_VERTICES vertices, halving their memory
+    // and bandwidth. Off forces 32 bit indices.
+    bool shortIndices;
+    // Splits imported meshes with more than MAX_SHORT_INDEX_VERTICES vertices into parts that fit 16 bit indices.
+    // The mesh cache keeps split and whole imports apart.
+    bool splitLargeMeshes;
+    // Simplifies every mesh into a chain of coarser levels of detail when it is loaded (on loaderThreads threads).
+    // The levels only add indices to the shared index buffer; Submit( ) with a LodView picks them by distance.
+    bool generateLods;
+    
+    ModelLoadOptions( ) : useMeshCache( true ), loaderThreads( 1 ), textureLoader( NULL ), releaseCpuData( false ), optimizeMeshes( false ),
+        vertexFormat( VERTEX_FORMAT_FLOAT ), shortIndices( true ), splitLargeMeshes( false ), generateLods( false )
+    {
+    }
+};
+
+// How Model::Draw hands its meshes to GL
+enum DrawSubmission
+{
+    DRAW_PER_MESH,      // One glDrawElementsBaseVertex per mesh
+    DRAW_MULTI          // One multi-draw per material batch (indirect where supported)
+};
 
 class Model
 {
 public:
     /*  Functions   */
     // Constructor, expects a filepath to a 3D model.
-    Model( const GLchar *path )
+    Model( const GLchar *path, const ModelLoadOptions &options = ModelLoadOptions( ) ) : loadedFromCache( false ), options( options ), submission( DRAW_MULTI )
     {
         this->loadModel( path );
+        this->buildBatches( );
+        MaterialLibrary::Instance( ).Upload( );
+        
+        this->meshBounds.Reserve( this->meshes.size( ) );
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            this->meshBounds.Add( this->meshes[i].GetBounds( ) );
+        }
+        this->cullStats.visible = ( GLuint )this->meshes.size( );
+        this->cullStats.culled = 0;
     }
     
-    // Draws the model, and thus all its meshes
-    void Draw( Shader shader )
+    // Gives the model's texture references back to the shared texture cache
+    ~Model( )
     {
         for ( GLuint i = 0; i < this->meshes.size( ); i++ )
         {
-            this->meshes[i].Draw( shader );
+            for ( GLuint j = 0; j < this->meshes[i].textures.size( ); j++ )
+            {
+                TextureCache::Instance( ).Release( this->meshes[i].textures[j].id );
+            }
+        }
+    }
+    
+    // Draws the model, and thus all its meshes, with a single VAO bind
+    void Draw( Shader &shader )
+    {
+        if( DRAW_MULTI == this->submission )
+        {
+            this->submitBatches( shader, NULL );
+            return;
+        }
+        
+        this->arena.Bind( );
+        this->arena.SetPositionUniforms( shader );
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            this->drawMesh( shader, i );
+        }
+        this->arena.Unbind( );
+    }
+    
+    // Draws only the meshes whose bounds touch the frustum. The frustum must be in the model's local space,
+    // i.e. built from projection * view * model (or Camera::GetFrustum( projection, model )).
+    void Draw( Shader &shader, const Frustum &frustum )
+    {
+        this->visibleMeshes.clear( );
+        this->cullStats = frustum.CullBoxes( this->meshBounds, this->visibleMeshes );
+        
+        if( this->visibleMeshes.empty( ) )
+        {
+            return;
+        }
+        
+        if( DRAW_MULTI == this->submission )
+        {
+            this->submitBatches( shader, &this->visibleMeshes );
+            return;
+        }
+        
+        this->arena.Bind( );
+        this->arena.SetPositionUniforms( shader );
+        for ( GLuint i = 0; i < this->visibleMeshes.size( ); i++ )
+        {
+            this->drawMesh( shader, this->visibleMeshes[i] );
+        }
+        this->arena.Unbind( );
+    }
+    
+    // Queues every mesh for the RenderQueue to sort and draw along with everything else of the frame. kind says
+    // whether model has only rotation, translation and uniform scale, which spares computing its normal matrix.
+    void Submit( RenderQueue &queue, Shader &shader, const glm::mat4 &model, TransformKind kind = TRANSFORM_GENERAL )
+    {
+        GLuint transform = queue.AddTransform( model, kind );
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            this->submitMesh( queue, shader, model, transform, i, this->ranges[i] );
+        }
+    }
+    
+    // Queues only the meshes touching frustum, which must come from projection * view * model
+    void Submit( RenderQueue &queue, Shader &shader, const glm::mat4 &model, const Frustum &frustum, TransformKind kind = TRANSFORM_GENERAL )
+    {
+        this->visibleMeshes.clear( );
+        this->cullStats = frustum.CullBoxes( this->meshBounds, this->visibleMeshes );
+        if( this->visibleMeshes.empty( ) )
+        {
+            return;
+        }
+        
+        GLuint transform = queue.AddTransform( model, kind );
+        for ( GLuint i = 0; i < this->visibleMeshes.size( ); i++ )
+        {
+            this->submitMesh( queue, shader, model, transform, this->visibleMeshes[i], this->ranges[this->visibleMeshes[i]] );
         }
     }
     
+    // Queues the meshes touching frustum at the level of detail view asks for at their distance. state holds the
+    // levels this instance was drawn with, give each instance of the model its own.
+    void Submit( RenderQueue &queue, Shader &shader, const glm::mat4 &model, const Frustum &frustum, const LodView &view, LodState &state, TransformKind kind = TRANSFORM_GENERAL )
+    {
+        this->visibleMeshes.clear( );
+        this->cullStats = frustum.CullBoxes( this->meshBounds, this->visibleMeshes );
+        if( this->visibleMeshes.empty( ) )
+        {
+            return;
+        }
+        
+        if( state.levels.size( ) != this->meshes.size( ) )
+        {
+            state.levels.assign( this->meshes.size( ), 0 );
+        }
+        
+        // Errors are in model units, the largest axis scale turns them into world units
+        GLfloat scale = std::max( glm::length( glm::vec3( model[0] ) ), std::max( glm::length( glm::vec3( model[1] ) ), glm::length( glm::vec3( model[2] ) ) ) );
+        
+        GLuint transform = queue.AddTransform( model, kind );
+        for ( GLuint i = 0; i < this->visibleMeshes.size( ); i++ )
+        {
+            GLuint index = this->visibleMeshes[i];
+            const BoundingSphere &sphere = this->meshes[index].GetBoundingSphere( );
+            glm::vec3 center( model * glm::vec4( sphere.Center, 1.0f ) );
+            // Distance to the nearest point of the mesh, a camera inside it gets full detail
+            GLfloat distance = glm::length( center - view.cameraPosition ) - sphere.Radius * scale;
+            
+            GLuint level = 0;
+            if( distance > 0.0f )
+            {
+                level = view.Select( &this->lodErrors[this->lodFirst[index]], this->lodCount[index], state.levels[index], view.pixelsPerUnit * scale / distance );
+            }
+            if( level != state.levels[index] )
+            {
+                GetLodStats( ).levelChanges++;
+                state.levels[index] = ( GLubyte )level;
+            }
+            
+            this->submitMesh( queue, shader, model, transform, index, this->lodRanges[this->lodFirst[index] + level] );
+        }
+    }
+    
+    // Levels of detail of a mesh, the full one included
+    GLuint GetLodCount( GLuint mesh ) const
+    {
+        return this->lodCount[mesh];
+    }
+    
+    void SetDrawSubmission( DrawSubmission submission )
+    {
+        this->submission = submission;
+    }
+    
+    GLuint GetMeshCount( ) const
+    {
+        return ( GLuint )this->meshes.size( );
+    }
+    
+    // Meshes sharing the same textures, each one is a single multi-draw
+    GLuint GetBatchCount( ) const
+    {
+        return ( GLuint )this->batches.size( );
+    }
+    
+    // Visible and culled mesh counts of the last Draw
+    CullStats GetCullStats( ) const
+    {
+        return this->cullStats;
+    }
+    
+    // GL objects holding the geometry: one VAO, vertex buffer and index buffer for the whole model
+    GLuint GetGLObjectCount( ) const
+    {
+        return this->arena.GetObjectCount( );
+    }
+    
+    // GPU memory of the vertex and index buffers
+    GLsizeiptr GetGeometryBytes( ) const
+    {
+        return this->arena.GetMemoryUsage( );
+    }
+    
+    GLsizeiptr GetIndexBytes( ) const
+    {
+        return this->arena.GetIndexBytes( );
+    }
+    
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum GetIndexType( ) const
+    {
+        return this->arena.GetIndexType( );
+    }
+    
+    // One line on the GPU memory of the geometry, and on what keeps it on 32 bit indices if something does
+    string GetMemoryReport( ) const
+    {
+        GLuint vertexCount = 0, indexCount = 0, largest = 0;
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            vertexCount += this->meshes[i].GetVertexCount( );
+            indexCount += this->meshes[i].GetIndexCount( );
+            largest = std::max( largest, this->meshes[i].GetVertexCount( ) );
+        }
+        
+        bool shortIndices = ( GL_UNSIGNED_SHORT == this->arena.GetIndexType( ) );
+        std::stringstream report;
+        report << this->meshes.size( ) << " meshes, " << vertexCount << " vertices (" << this->arena.GetVertexBytes( ) / 1024 << " KB), "
+            << indexCount << " indices (" << this->arena.GetIndexBytes( ) / 1024 << " KB, " << ( shortIndices ? "16" : "32" ) << " bit";
+        if( shortIndices )
+        {
+            report << ", " << indexCount * ( sizeof( GLuint ) - sizeof( GLushort ) ) / 1024 << " KB saved";
+        }
+        else if( this->options.shortIndices && largest > MAX_SHORT_INDEX_VERTICES )
+        {
+            report << ", a mesh of " << largest << " vertices needs 32 bit, splitLargeMeshes would avoid it";
+        }
+        report << ")";
+        return report.str( );
+    }
+    
+    // True when the meshes came from the binary mesh cache instead of an Assimp import
+    bool IsLoadedFromCache( ) const
+    {
+        return this->loadedFromCache;
+    }
+    
 private:
     /*  Model Data  */
     vector<Mesh> meshes;
+    GeometryArena arena;                    // Geometry of every mesh
+    vector<GeometryArena::Range> ranges;    // Where meshes[i] lives in the arena
+    BoundsArray meshBounds;         // Local space bounds of meshes[i], laid out for batch culling
+    vector<GLuint> visibleMeshes;   // Scratch list of the last culling pass
+    CullStats cullStats;
+    
+    // Meshes grouped by material (same textures and material index), with the span of drawList they took in the last Draw
+    struct MaterialBatch
+    {
+        vector<GLuint> meshes;
+        GLuint firstCommand;
+        GLuint commandCount;
+    };
+    vector<MaterialBatch> batches;
+    vector<GLuint> meshBatch;               // Batch of meshes[i]
+    MultiDrawList drawList;
+    vector<unsigned char> meshVisible;      // Scratch flags for culled multi-draws
 
-	struct Material {
-		glm::vec3 Diffuse;
-		glm::vec3 Specular;
-		glm::vec3 Ambient;
-		float Shininess;
-	};
-	
     string directory;
-    vector<Texture> textures_loaded;	// Stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    bool loadedFromCache;
+    ModelLoadOptions options;
+    DrawSubmission submission;
+    vector<VertexCacheStats> optimizationStats;     // Before and after figures of each optimized mesh, in mesh order
+    
+    // Levels of detail: meshes[i] has lodCount[i] of them from lodFirst[i] on, the first one being ranges[i]
+    vector<GeometryArena::Range> lodRanges;
+    vector<GLfloat> lodErrors;      // Simplification error of each level, in model units
+    vector<GLuint> lodFirst;
+    vector<GLuint> lodCount;
+    
+    // Each mesh holds its own texture references, copying would release them twice
+    Model( const Model & );
+    Model &operator=( const Model & );
     
     /*  Functions   */
     // Loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel( string path )
     {
+        // Retrieve the directory path of the filepath
+        this->directory = path.substr( 0, path.find_last_of( '/' ) );
+        
+        // Try the binary mesh cache first, it is only valid while the source file content doesn't change
+        string cachePath = path + ".meshcache";
+        uint64_t sourceHash = 0;
+        GLboolean hashed = this->options.useMeshCache && MeshCache::HashFile( path, sourceHash );
+        
+        uint32_t importFlags = ( this->options.optimizeMeshes ? MESH_CACHE_OPTIMIZED : 0 ) | ( this->options.splitLargeMeshes ? MESH_CACHE_SPLIT : 0 );
+        
+        if( hashed && this->loadFromCache( cachePath, sourceHash, importFlags ) )
+        {
+            return;
+        }
+        
         // Read file via ASSIMP
         Assimp::Importer importer;
         const aiScene *scene = importer.ReadFile( path, aiProcess_Triangulate | aiProcess_FlipUVs );
@@ -68,11 +371,395 @@ private:
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString( ) << endl;
             return;
         }
-        // Retrieve the directory path of the filepath
-        this->directory = path.substr( 0, path.find_last_of( '/' ) );
+        if( 1 == this->options.loaderThreads )
+        {
+            this->meshes.reserve( scene->mNumMeshes );
+            
+            // Process ASSIMP's root node recursively
+            this->processNode( scene->mRootNode, scene );
+        }
+        else
+        {
+            this->processNodesParallel( scene );
+        }
+        
+        for ( GLuint i = 0; i < this->optimizationStats.size( ); i += 2 )
+        {
+            cout << "MESH_OPTIMIZER:: mesh " << i / 2 << ": ACMR " << this->optimizationStats[i].acmr << " -> " << this->optimizationStats[i + 1].acmr
+                << ", ATVR " << this->optimizationStats[i].atvr << " -> " << this->optimizationStats[i + 1].atvr << endl;
+        }
+        
+        if( this->options.splitLargeMeshes )
+        {
+            this->splitLargeMeshes( );
+        }
+        
+        // Store the imported meshes so the next launch can skip ASSIMP
+        if( hashed && !MeshCache::Write( cachePath, sourceHash, this->meshes, importFlags ) )
+        {
+            cout << "WARNING::MESH_CACHE:: Could not write " << cachePath << endl;
+        }
+        
+        // Pack every mesh into the model's shared buffers
+        vector<const Vertex *> vertices( this->meshes.size( ) );
+        vector<const GLuint *> indices( this->meshes.size( ) );
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            vertices[i] = this->meshes[i].vertices.empty( ) ? NULL : &this->meshes[i].vertices[0];
+            indices[i] = this->meshes[i].indices.empty( ) ? NULL : &this->meshes[i].indices[0];
+        }
+        this->uploadMeshes( vertices, indices );
+        
+        if( this->options.releaseCpuData )
+        {
+            for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+            {
+                this->meshes[i].ReleaseCpuData( );
+            }
+        }
+    }
+    
+    // Creates the meshes from a mapped mesh cache. The vertex and index ranges are uploaded directly from the mapping.
+    bool loadFromCache( const string &cachePath, uint64_t sourceHash, uint32_t importFlags )
+    {
+        MeshCache cache;
+        
+        if( !cache.Open( cachePath, sourceHash, importFlags ) )
+        {
+            return false;
+        }
+        
+        this->meshes.reserve( cache.GetMeshCount( ) );
+        
+        vector<const Vertex *> vertices;
+        vector<const GLuint *> indices;
+        for ( GLuint i = 0; i < cache.GetMeshCount( ); i++ )
+        {
+            const MeshCacheRecord &record = cache.GetMesh( i );
+            vector<Texture> textures;
+            
+            for ( GLuint j = 0; j < record.textureCount; j++ )
+            {
+                aiString path( cache.GetTexturePath( record.firstTexture + j ) );
+                textures.push_back( this->loadTexture( path, cache.GetTextureType( record.firstTexture + j ) ) );
+            }
+            
+            this->meshes.push_back( Mesh( cache.GetVertices( record ), record.vertexCount, cache.GetIndices( record ), record.indexCount, std::move( textures ) ) );
+            this->meshes.back( ).materialIndex = MaterialLibrary::Instance( ).Add( MeshCache::GetMaterial( record ) );
+            vertices.push_back( cache.GetVertices( record ) );
+            indices.push_back( cache.GetIndices( record ) );
+        }
+        
+        this->uploadMeshes( vertices, indices );
+        
+        this->loadedFromCache = true;
+        
+        return true;
+    }
+    
+    // Packs every mesh into the model's shared buffers, followed by its coarser levels of detail when they are
+    // generated. vertices[i] and indices[i] hold the geometry of meshes[i]: its CPU copy or the mapped mesh cache.
+    // The meshes must all exist first, compact vertices need the bounds of every one before the first upload.
+    void uploadMeshes( const vector<const Vertex *> &vertices, const vector<const GLuint *> &indices )
+    {
+        GLuint meshCount = ( GLuint )this->meshes.size( );
+        
+        vector<vector<vector<GLuint> > > levels( meshCount );
+        vector<vector<GLfloat> > errors( meshCount );
+        if( this->options.generateLods )
+        {
+            ThreadPool pool( this->options.loaderThreads );
+            pool.ParallelFor( meshCount, [&]( size_t i )
+            {
+                buildLods( vertices[i], this->meshes[i].GetVertexCount( ), indices[i], this->meshes[i].GetIndexCount( ), levels[i], errors[i] );
+            } );
+        }
+        
+        GLuint totalVertices = 0, totalIndices = 0;
+        for ( GLuint i = 0; i < meshCount; i++ )
+        {
+            totalVertices += this->meshes[i].GetVertexCount( );
+            totalIndices += this->meshes[i].GetIndexCount( );
+            for ( GLuint j = 0; j < levels[i].size( ); j++ )
+            {
+                totalIndices += ( GLuint )levels[i][j].size( );
+            }
+        }
+        
+        this->arena.Allocate( totalVertices, totalIndices, this->options.vertexFormat, this->getBounds( ), this->getIndexType( ) );
+        this->ranges.reserve( meshCount );
+        this->lodFirst.reserve( meshCount );
+        this->lodCount.reserve( meshCount );
+        for ( GLuint i = 0; i < meshCount; i++ )
+        {
+            GeometryArena::Range range = this->arena.Append( vertices[i], this->meshes[i].GetVertexCount( ), indices[i], this->meshes[i].GetIndexCount( ) );
+            this->ranges.push_back( range );
+            
+            this->lodFirst.push_back( ( GLuint )this->lodRanges.size( ) );
+            this->lodCount.push_back( 1 + ( GLuint )levels[i].size( ) );
+            this->lodRanges.push_back( range );
+            this->lodErrors.push_back( 0.0f );
+            for ( GLuint j = 0; j < levels[i].size( ); j++ )
+            {
+                this->lodRanges.push_back( this->arena.AppendIndices( range, &levels[i][j][0], ( GLuint )levels[i][j].size( ) ) );
+                this->lodErrors.push_back( errors[i][j] );
+            }
+        }
+    }
+    
+    // Simplifies a mesh into up to LOD_MAX_LEVELS - 1 coarser index lists, each with about half the triangles of the
+    // one before, and their errors. Stops early when a level wouldn't remove enough. Safe to call from worker threads.
+    static void buildLods( const Vertex *vertices, GLuint vertexCount, const GLuint *indices, GLuint indexCount, vector<vector<GLuint> > &levels, vector<GLfloat> &errors )
+    {
+        if( indexCount / 3 < LOD_MIN_TRIANGLES )
+        {
+            return;
+        }
+        
+        MeshSimplifier simplifier( vertices, vertexCount, indices, indexCount );
+        GLuint previous = indexCount;
+        for ( GLuint level = 1; level < LOD_MAX_LEVELS && previous / 3 >= LOD_MIN_TRIANGLES; level++ )
+        {
+            vector<GLuint> simplified;
+            GLfloat error = simplifier.Simplify( previous / 2, simplified );
+            if( simplified.empty( ) || simplified.size( ) > previous * ( 1.0f - LOD_MIN_REDUCTION ) )
+            {
+                break;
+            }
+            
+            previous = ( GLuint )simplified.size( );
+            levels.push_back( std::move( simplified ) );
+            errors.push_back( error );
+        }
+    }
+    
+    // Local space bounds of all the meshes together
+    AABB getBounds( ) const
+    {
+        AABB bounds;
+        bounds.Min = bounds.Max = glm::vec3( 0.0f );
+        bool first = true;
+        
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            // Empty meshes have a box at the origin that holds nothing
+            if( 0 == this->meshes[i].GetVertexCount( ) )
+            {
+                continue;
+            }
+            
+            const AABB &meshBounds = this->meshes[i].GetBounds( );
+            bounds.Min = first ? meshBounds.Min : glm::min( bounds.Min, meshBounds.Min );
+            bounds.Max = first ? meshBounds.Max : glm::max( bounds.Max, meshBounds.Max );
+            first = false;
+        }
+        
+        return bounds;
+    }
+    
+    // 16 bit indices when allowed and every mesh fits them
+    GLenum getIndexType( ) const
+    {
+        if( !this->options.shortIndices )
+        {
+            return GL_UNSIGNED_INT;
+        }
+        
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            if( this->meshes[i].GetVertexCount( ) > MAX_SHORT_INDEX_VERTICES )
+            {
+                return GL_UNSIGNED_INT;
+            }
+        }
+        
+        return GL_UNSIGNED_SHORT;
+    }
+    
+    // Replaces every mesh with more than MAX_SHORT_INDEX_VERTICES vertices by parts that fit 16 bit indices, keeping
+    // the mesh order. The parts share the mesh's material and textures, each part holding its own texture references.
+    void splitLargeMeshes( )
+    {
+        vector<Mesh> split;
+        split.reserve( this->meshes.size( ) );
+        
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            Mesh &mesh = this->meshes[i];
+            if( mesh.GetVertexCount( ) <= MAX_SHORT_INDEX_VERTICES )
+            {
+                split.push_back( std::move( mesh ) );
+                continue;
+            }
+            
+            vector<vector<Vertex> > partVertices;
+            vector<vector<GLuint> > partIndices;
+            splitMesh( mesh.vertices, mesh.indices, MAX_SHORT_INDEX_VERTICES, partVertices, partIndices );
+            
+            for ( GLuint j = 0; j < partVertices.size( ); j++ )
+            {
+                // The first part takes over the mesh's references
+                for ( GLuint k = 0; j > 0 && k < mesh.textures.size( ); k++ )
+                {
+                    TextureCache::Instance( ).AddReference( mesh.textures[k].id );
+                }
+                split.push_back( Mesh( std::move( partVertices[j] ), std::move( partIndices[j] ), mesh.textures ) );
+                split.back( ).materialIndex = mesh.materialIndex;
+            }
+        }
+        
+        this->meshes.swap( split );
+    }
+    
+    // Cuts a mesh into parts of at most maxVertices vertices, taking its triangles in order (so an optimized vertex
+    // cache order survives) and starting a new part when the next triangle's new vertices don't fit anymore
+    static void splitMesh( const vector<Vertex> &vertices, const vector<GLuint> &indices, GLuint maxVertices,
+                           vector<vector<Vertex> > &partVertices, vector<vector<GLuint> > &partIndices )
+    {
+        const GLuint UNUSED = 0xFFFFFFFF;
+        vector<GLuint> remap( vertices.size( ), UNUSED );   // Vertex -> its index in the current part
+        vector<GLuint> used;                                // Vertices of the current part, to reset remap
         
-        // Process ASSIMP's root node recursively
-        this->processNode( scene->mRootNode, scene );
+        for ( size_t i = 0; i + 2 < indices.size( ); i += 3 )
+        {
+            const GLuint *triangle = &indices[i];
+            GLuint newVertices = 0;
+            for ( GLuint k = 0; k < 3; k++ )
+            {
+                bool repeated = ( k > 0 && triangle[k] == triangle[0] ) || ( k > 1 && triangle[k] == triangle[1] );
+                if( UNUSED == remap[triangle[k]] && !repeated )
+                {
+                    newVertices++;
+                }
+            }
+            
+            if( partVertices.empty( ) || used.size( ) + newVertices > maxVertices )
+            {
+                for ( size_t k = 0; k < used.size( ); k++ )
+                {
+                    remap[used[k]] = UNUSED;
+                }
+                used.clear( );
+                partVertices.push_back( vector<Vertex>( ) );
+                partIndices.push_back( vector<GLuint>( ) );
+            }
+            
+            for ( GLuint k = 0; k < 3; k++ )
+            {
+                if( UNUSED == remap[triangle[k]] )
+                {
+                    remap[triangle[k]] = ( GLuint )used.size( );
+                    used.push_back( triangle[k] );
+                    partVertices.back( ).push_back( vertices[triangle[k]] );
+                }
+                partIndices.back( ).push_back( remap[triangle[k]] );
+            }
+        }
+    }
+    
+    // Groups the meshes by the textures they bind and their material, in order of first appearance
+    void buildBatches( )
+    {
+        map<vector<GLuint>, GLuint> batchOfMaterial;
+        this->meshBatch.resize( this->meshes.size( ) );
+        
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            vector<GLuint> key;
+            for ( GLuint j = 0; j < this->meshes[i].textures.size( ); j++ )
+            {
+                key.push_back( this->meshes[i].textures[j].id );
+            }
+            key.push_back( this->meshes[i].materialIndex );
+            
+            map<vector<GLuint>, GLuint>::iterator it = batchOfMaterial.find( key );
+            if( it == batchOfMaterial.end( ) )
+            {
+                it = batchOfMaterial.insert( make_pair( key, ( GLuint )this->batches.size( ) ) ).first;
+                this->batches.push_back( MaterialBatch( ) );
+            }
+            this->batches[it->second].meshes.push_back( i );
+            this->meshBatch[i] = it->second;
+        }
+        
+        this->meshVisible.assign( this->meshes.size( ), 0 );
+    }
+    
+    // Builds the draw commands of the visible meshes (all of them without a list), batch after batch, and submits
+    // each batch with one multi-draw after binding its textures
+    void submitBatches( Shader &shader, const vector<GLuint> *visible )
+    {
+        if( NULL != visible )
+        {
+            for ( GLuint i = 0; i < visible->size( ); i++ )
+            {
+                this->meshVisible[( *visible )[i]] = 1;
+            }
+        }
+        
+        this->drawList.Clear( this->arena.GetIndexType( ) );
+        for ( GLuint i = 0; i < this->batches.size( ); i++ )
+        {
+            MaterialBatch &batch = this->batches[i];
+            batch.firstCommand = this->drawList.Size( );
+            
+            for ( GLuint j = 0; j < batch.meshes.size( ); j++ )
+            {
+                if( NULL == visible || this->meshVisible[batch.meshes[j]] )
+                {
+                    this->drawList.Add( this->ranges[batch.meshes[j]] );
+                }
+            }
+            
+            batch.commandCount = this->drawList.Size( ) - batch.firstCommand;
+        }
+        this->drawList.Upload( );
+        
+        if( NULL != visible )
+        {
+            for ( GLuint i = 0; i < visible->size( ); i++ )
+            {
+                this->meshVisible[( *visible )[i]] = 0;
+            }
+        }
+        
+        this->arena.Bind( );
+        this->arena.SetPositionUniforms( shader );
+        for ( GLuint i = 0; i < this->batches.size( ); i++ )
+        {
+            const MaterialBatch &batch = this->batches[i];
+            if( 0 == batch.commandCount )
+            {
+                continue;
+            }
+            
+            Mesh &material = this->meshes[batch.meshes[0]];
+            material.BindTextures( shader );
+            this->drawList.Draw( batch.firstCommand, batch.commandCount );
+        }
+        this->arena.Unbind( );
+    }
+    
+    void submitMesh( RenderQueue &queue, Shader &shader, const glm::mat4 &model, GLuint transform, GLuint index, const GeometryArena::Range &range )
+    {
+        const Mesh &mesh = this->meshes[index];
+        glm::vec3 center( model * glm::vec4( mesh.GetBounds( ).GetCenter( ), 1.0f ) );
+        
+        // Every mesh of a batch hands in the batch's first mesh as its material, so the queue binds it once per batch.
+        // The sort id puts the material index below the first texture, only the low bits of each make it into the key.
+        const Mesh &material = this->meshes[this->batches[this->meshBatch[index]].meshes[0]];
+        GLuint materialId = ( ( material.textures.empty( ) ? 0 : material.textures[0].id ) << 8 ) | ( material.materialIndex & 0xFF );
+        
+        queue.Submit( shader, material, materialId, this->arena, range, transform, glm::length( center - queue.GetCameraPosition( ) ) );
+        
+        GetLodStats( ).trianglesSubmitted += range.indexCount / 3;
+        GetLodStats( ).trianglesFullDetail += this->ranges[index].indexCount / 3;
+    }
+    
+    void drawMesh( Shader &shader, GLuint index )
+    {
+        this->meshes[index].BindTextures( shader );
+        this->arena.Draw( this->ranges[index] );
     }
     
     // Processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -86,6 +773,7 @@ private:
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
             
             this->meshes.push_back( this->processMesh( mesh, scene ) );
+            this->meshes.back( ).materialIndex = this->addMaterial( mesh, scene );
         }
         
         // After we've processed all of the meshes (if any) we then recursively process each of the children nodes
@@ -95,59 +783,140 @@ private:
         }
     }
     
+    // Flattens the node tree into a work list (in the same depth first order processNode visits it), converts the
+    // meshes on a thread pool and then creates the GL buffers for each of them, in order, on this thread.
+    void processNodesParallel( const aiScene *scene )
+    {
+        vector<const aiMesh *> work;
+        this->collectMeshes( scene->mRootNode, scene, work );
+        
+        vector<vector<Vertex> > vertices( work.size( ) );
+        vector<vector<GLuint> > indices( work.size( ) );
+        
+        vector<VertexCacheStats> stats( this->options.optimizeMeshes ? work.size( ) * 2 : 0 );
+        
+        ThreadPool pool( this->options.loaderThreads );
+        pool.ParallelFor( work.size( ), [&]( size_t i )
+        {
+            convertMesh( work[i], vertices[i], indices[i] );
+            if( !stats.empty( ) )
+            {
+                optimizeMesh( vertices[i], indices[i], stats[i * 2], stats[i * 2 + 1] );
+            }
+        } );
+        this->optimizationStats.insert( this->optimizationStats.end( ), stats.begin( ), stats.end( ) );
+        
+        this->meshes.reserve( this->meshes.size( ) + work.size( ) );
+        
+        for ( GLuint i = 0; i < work.size( ); i++ )
+        {
+            // Textures need the GL context, so materials are resolved here and not on the workers
+            vector<Texture> textures = this->processMaterial( work[i], scene );
+            this->meshes.push_back( Mesh( std::move( vertices[i] ), std::move( indices[i] ), std::move( textures ) ) );
+            this->meshes.back( ).materialIndex = this->addMaterial( work[i], scene );
+        }
+    }
+    
+    void collectMeshes( const aiNode *node, const aiScene *scene, vector<const aiMesh *> &work )
+    {
+        for ( GLuint i = 0; i < node->mNumMeshes; i++ )
+        {
+            work.push_back( scene->mMeshes[node->mMeshes[i]] );
+        }
+        
+        for ( GLuint i = 0; i < node->mNumChildren; i++ )
+        {
+            this->collectMeshes( node->mChildren[i], scene, work );
+        }
+    }
+    
     Mesh processMesh( aiMesh *mesh, const aiScene *scene )
     {
         // Data to fill
         vector<Vertex> vertices;
         vector<GLuint> indices;
-        vector<Texture> textures;
+        
+        convertMesh( mesh, vertices, indices );
+        
+        if( this->options.optimizeMeshes )
+        {
+            VertexCacheStats before, after;
+            optimizeMesh( vertices, indices, before, after );
+            this->optimizationStats.push_back( before );
+            this->optimizationStats.push_back( after );
+        }
+        
+        vector<Texture> textures = this->processMaterial( mesh, scene );
+        
+        // Return a mesh object created from the extracted mesh data, handing the arrays over instead of copying them
+        return Mesh( std::move( vertices ), std::move( indices ), std::move( textures ) );
+    }
+    
+    // Reorders a converted mesh with the MeshOptimizer, measuring the cache efficiency before and after.
+    // Like convertMesh it is safe to call from worker threads.
+    static void optimizeMesh( vector<Vertex> &vertices, vector<GLuint> &indices, VertexCacheStats &before, VertexCacheStats &after )
+    {
+        before = MeshOptimizer::AnalyzeVertexCache( indices, vertices.size( ) );
+        MeshOptimizer::Optimize( vertices, indices );
+        after = MeshOptimizer::AnalyzeVertexCache( indices, vertices.size( ) );
+    }
+    
+    // Converts the geometry of an ASSIMP mesh into our vertex/index arrays. Touches no GL or Model state,
+    // so it is safe to call from worker threads.
+    static void convertMesh( const aiMesh *mesh, vector<Vertex> &vertices, vector<GLuint> &indices )
+    {
+        vertices.resize( mesh->mNumVertices );
         
         // Walk through each of the mesh's vertices
         for ( GLuint i = 0; i < mesh->mNumVertices; i++ )
         {
-            Vertex vertex;
-            glm::vec3 vector; // We declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
+            Vertex &vertex = vertices[i];
             
             // Positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+            vertex.Position = glm::vec3( mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z );
             
-            // Normals
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
+            // Normals, files without them (e.g. an OBJ with no vn lines) leave mNormals empty
+            vertex.Normal = mesh->mNormals ? glm::vec3( mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z ) : glm::vec3( 0.0f );
             
             // Texture Coordinates
             if( mesh->mTextureCoords[0] ) // Does the mesh contain texture coordinates?
             {
-                glm::vec2 vec;
                 // A vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
                 // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
+                vertex.TexCoords = glm::vec2( mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y );
             }
             else
             {
                 vertex.TexCoords = glm::vec2( 0.0f, 0.0f );
             }
-            
-            vertices.push_back( vertex );
         }
         
         // Now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        GLuint indexCount = 0;
+        
         for ( GLuint i = 0; i < mesh->mNumFaces; i++ )
         {
-            aiFace face = mesh->mFaces[i];
+            indexCount += mesh->mFaces[i].mNumIndices;
+        }
+        
+        indices.resize( indexCount );
+        
+        GLuint *out = indices.empty( ) ? NULL : &indices[0];
+        
+        for ( GLuint i = 0; i < mesh->mNumFaces; i++ )
+        {
+            const aiFace &face = mesh->mFaces[i];
             // Retrieve all indices of the face and store them in the indices vector
             for ( GLuint j = 0; j < face.mNumIndices; j++ )
             {
-                indices.push_back( face.mIndices[j] );
+                *out++ = face.mIndices[j];
             }
         }
+    }
+    
+    vector<Texture> processMaterial( const aiMesh *mesh, const aiScene *scene )
+    {
+        vector<Texture> textures;
         
         // Process materials
         if( mesh->mMaterialIndex >= 0 )
@@ -161,21 +930,20 @@ private:
             // Normal: texture_normalN
             
             // 1. Diffuse maps
-            vector<Texture> diffuseMaps = this->loadMaterialTextures( material, aiTextureType_DIFFUSE, "texture_diffuse" );
+            vector<Texture> diffuseMaps = this->loadMaterialTextures( material, aiTextureType_DIFFUSE, TEXTURE_DIFFUSE );
             textures.insert( textures.end( ), diffuseMaps.begin( ), diffuseMaps.end( ) );
             
             // 2. Specular maps
-            vector<Texture> specularMaps = this->loadMaterialTextures( material, aiTextureType_SPECULAR, "texture_specular" );
+            vector<Texture> specularMaps = this->loadMaterialTextures( material, aiTextureType_SPECULAR, TEXTURE_SPECULAR );
             textures.insert( textures.end( ), specularMaps.begin( ), specularMaps.end( ) );
         }
         
-        // Return a mesh object created from the extracted mesh data
-        return Mesh( vertices, indices, textures );
+        return textures;
     }
     
     // Checks all material textures of a given type and loads the textures if they're not loaded yet.
     // The required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures( aiMaterial *mat, aiTextureType type, string typeName )
+    vector<Texture> loadMaterialTextures( aiMaterial *mat, aiTextureType type, TextureType typeName )
     {
         vector<Texture> textures;
         
@@ -184,80 +952,49 @@ private:
             aiString str;
             mat->GetTexture( type, i, &str );
             
-            // Check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            GLboolean skip = false;
-            
-            for ( GLuint j = 0; j < textures_loaded.size( ); j++ )
-            {
-                if( textures_loaded[j].path == str )
-                {
-                    textures.push_back( textures_loaded[j] );
-                    skip = true; // A texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    
-                    break;
-                }
-            }
-            
-            if( !skip )
-            {   // If texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile( str.C_Str( ), this->directory );
-                texture.type = typeName;
-                texture.path = str;
-                textures.push_back( texture );
-                
-                this->textures_loaded.push_back( texture );  // Store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back( this->loadTexture( str, typeName ) );
         }
         
         return textures;
     }
+    
+    // Returns the texture for the given path. The shared texture cache only loads it the first time it is seen by
+    // any model, every call takes a reference that the destructor gives back.
+    Texture loadTexture( const aiString &str, TextureType typeName )
+    {
+        Texture texture;
+        texture.id = TextureCache::Instance( ).Acquire( this->directory + '/' + str.C_Str( ), SOIL_LOAD_RGB, this->options.textureLoader );
+        texture.type = typeName;
+        texture.path = str;
+        
+        return texture;
+    }
 
-	Material loadMaterial(aiMaterial* mat) {
-		Material material;
-		aiColor3D color(1.0f, 0.f, 0.f);
-		float shininess;
-
-		mat->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-		material.Diffuse = glm::vec3(color.r, color.b, color.g);
-
-		mat->Get(AI_MATKEY_COLOR_AMBIENT, color);
-		material.Ambient = glm::vec3(color.r, color.b, color.g);
-
-		mat->Get(AI_MATKEY_COLOR_SPECULAR, color);
-		material.Specular = glm::vec3(color.r, color.b, color.g);
-
-		mat->Get(AI_MATKEY_SHININESS, shininess);
-		material.Shininess = shininess;
-
-		return material;
+	// Entry of the material library for the mesh's material
+	GLuint addMaterial(const aiMesh *mesh, const aiScene *scene) {
+		return MaterialLibrary::Instance().Add(loadMaterial(scene->mMaterials[mesh->mMaterialIndex]));
 	}
-};
 
-GLint TextureFromFile( const char *path, string directory )
-{
-    //Generate texture ID and load texture data
-    string filename = string( path );
-    filename = directory + '/' + filename;
-    GLuint textureID;
-    glGenTextures( 1, &textureID );
-    
-    int width, height;
-    
-    unsigned char *image = SOIL_load_image( filename.c_str( ), &width, &height, 0, SOIL_LOAD_RGB );
-    
-    // Assign texture to ID
-    glBindTexture( GL_TEXTURE_2D, textureID );
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image );
-    glGenerateMipmap( GL_TEXTURE_2D );
-    
-    // Parameters
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture( GL_TEXTURE_2D, 0 );
-    SOIL_free_image_data( image );
-    
-    return textureID;
-}
+	// Values missing from the file keep a white diffuse, no ambient or specular and the old default shininess
+	Material loadMaterial(aiMaterial* mat) {
+		Material material;
+		aiColor3D color(1.0f, 1.0f, 1.0f);
+		float shininess = 16.0f;
+
+		mat->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+		material.Diffuse = glm::vec3(color.r, color.g, color.b);
+
+		color = aiColor3D(0.0f, 0.0f, 0.0f);
+		mat->Get(AI_MATKEY_COLOR_AMBIENT, color);
+		material.Ambient = glm::vec3(color.r, color.g, color.b);
+
+		color = aiColor3D(0.0f, 0.0f, 0.0f);
+		mat->Get(AI_MATKEY_COLOR_SPECULAR, color);
+		material.Specular = glm::vec3(color.r, color.g, color.b);
+
+		mat->Get(AI_MATKEY_SHININESS, shininess);
+		material.Shininess = shininess;
+
+		return material;
+	}
+};
@@ -0,0 +1,44 @@
+#version 330 core
+
+// The FrameUniforms light applied to the G-buffer, same lighting as modelLoading.frag (the ambient term was written
+// by the geometry pass)
+
+out vec4 color;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gSpecular;
+
+layout ( std140 ) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    vec4 normal = texelFetch( gNormal, pixel, 0 );
+    // Background
+    if( 0.0f == normal.w )
+    {
+        discard;
+    }
+    vec4 position = texelFetch( gPosition, pixel, 0 );
+
+    vec3 norm = normalize( normal.xyz );
+    // w is 0 for a directional light, whose xyz is the direction toward it
+    vec3 lightDir = normalize( lightPosition.xyz - position.xyz * lightPosition.w );
+    vec3 viewDir = normalize( cameraPosition.xyz - position.xyz );
+    vec3 halfway = normalize( lightDir + viewDir );
+
+    vec3 diffuse = max( dot( norm, lightDir ), 0.0f ) * texelFetch( gAlbedo, pixel, 0 ).rgb * lightColor.rgb;
+    vec3 specular = pow( max( dot( norm, halfway ), 0.0f ), position.w ) * texelFetch( gSpecular, pixel, 0 ).rgb * lightColor.rgb;
+
+    color = vec4( diffuse + specular, 0.0f );
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+// One point light applied to the pixels under its volume, with the falloff of clustered.frag and the material
+// lighting of modelLoading.frag
+
+flat in vec4 LightPositionRadius;
+flat in vec3 LightColor;
+
+out vec4 color;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gSpecular;
+
+layout ( std140 ) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    vec4 normal = texelFetch( gNormal, pixel, 0 );
+    vec4 position = texelFetch( gPosition, pixel, 0 );
+
+    vec3 toLight = LightPositionRadius.xyz - position.xyz;
+    float distance = length( toLight );
+    // Smooth falloff that reaches zero at the radius
+    float falloff = clamp( 1.0f - distance * distance / ( LightPositionRadius.w * LightPositionRadius.w ), 0.0f, 1.0f );
+    falloff *= falloff;
+    if( 0.0f == normal.w || 0.0f == falloff )
+    {
+        discard;
+    }
+
+    vec3 norm = normalize( normal.xyz );
+    vec3 lightDir = toLight / max( distance, 0.0001f );
+    vec3 viewDir = normalize( cameraPosition.xyz - position.xyz );
+    vec3 halfway = normalize( lightDir + viewDir );
+
+    vec3 diffuse = max( dot( norm, lightDir ), 0.0f ) * texelFetch( gAlbedo, pixel, 0 ).rgb;
+    vec3 specular = pow( max( dot( norm, halfway ), 0.0f ), position.w ) * texelFetch( gSpecular, pixel, 0 ).rgb;
+
+    color = vec4( ( diffuse + specular ) * LightColor * falloff, 0.0f );
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+// Light volume of the deferred point lights: a unit sphere per instance, scaled to the light's radius
+layout ( location = 0 ) in vec3 position;
+layout ( location = 4 ) in vec4 lightPositionRadius;
+layout ( location = 5 ) in vec4 lightColorIntensity;
+
+flat out vec4 LightPositionRadius;
+flat out vec3 LightColor;
+
+layout ( std140 ) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+void main( )
+{
+    gl_Position = viewProjection * vec4( lightPositionRadius.xyz + position * lightPositionRadius.w, 1.0f );
+    LightPositionRadius = lightPositionRadius;
+    LightColor = lightColorIntensity.rgb * lightColorIntensity.w;
+}
@@ -0,0 +1,53 @@
+#version 330 core
+
+// Geometry pass of the deferred path (DeferredRenderer.h), drawn with modelLoading.vs. Writes the surface instead
+// of lighting it; the outputs follow GBufferTarget.
+
+// Must match MAX_MATERIALS in Materials.h
+#define MAX_MATERIALS 256
+
+struct Material
+{
+    vec4 diffuse;
+    vec4 ambient;
+    vec4 specular;      // w is the shininess
+};
+
+in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
+
+layout ( location = 0 ) out vec4 gPosition;     // xyz world position, w shininess
+layout ( location = 1 ) out vec4 gNormal;       // xyz world normal, w 1 marks the pixel as drawn
+layout ( location = 2 ) out vec4 gAlbedo;
+layout ( location = 3 ) out vec4 gSpecular;
+layout ( location = 4 ) out vec4 lighting;      // Light accumulation, the light passes add to the ambient term
+
+uniform sampler2D texture_diffuse1;
+uniform int materialIndex;
+
+layout ( std140 ) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+layout ( std140 ) uniform Materials
+{
+    Material materials[MAX_MATERIALS];
+};
+
+void main( )
+{
+    Material material = materials[materialIndex];
+
+    gPosition = vec4( FragPos, max( material.specular.w, 1.0f ) );
+    gNormal = vec4( normalize( Normal ), 1.0f );
+    gAlbedo = vec4( material.diffuse.rgb, 1.0f );
+    gSpecular = vec4( material.specular.rgb, 1.0f );
+    lighting = vec4( material.ambient.rgb * lightColor.rgb, 1.0f );
+}
@@ -1,13 +1,94 @@
 #version 330 core
 
+// Must match MAX_MATERIALS in Materials.h
+#define MAX_MATERIALS 256
+// Must match SHADOW_MAX_CASCADES in ShadowCascades.h
+#define MAX_CASCADES 4
+
+struct Material
+{
+    vec4 diffuse;
+    vec4 ambient;
+    vec4 specular;      // w is the shininess
+};
+
 in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
 
 out vec4 color;
 
-uniform sampler2D texture_diffuse;
+uniform sampler2D texture_diffuse1;
+uniform int materialIndex;
+
+// Cascaded shadow map of the light, set by CascadedShadowMap::Bind( ). Without it cascadeCount is 0 and nothing is shadowed
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[MAX_CASCADES];
+uniform vec4 cascadeSplits;
+uniform vec4 cascadeTexelSizes;
+uniform int cascadeCount;
+uniform int shadowFilterRadius;
+
+layout ( std140 ) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
+
+layout ( std140 ) uniform Materials
+{
+    Material materials[MAX_MATERIALS];
+};
+
+// Fraction of the light reaching the fragment, 0 in full shadow. Past the last cascade everything is lit
+float ShadowFactor( vec3 position, vec3 normal )
+{
+    float depth = -( view * vec4( position, 1.0f ) ).z;
+    int cascade = 0;
+    while ( cascade < cascadeCount && depth > cascadeSplits[cascade] )
+    {
+        cascade++;
+    }
+    if ( cascade >= cascadeCount )
+    {
+        return 1.0f;
+    }
+
+    // Looking the map up a bit off the surface keeps it from shadowing itself
+    vec4 coord = shadowMatrices[cascade] * vec4( position + normal * cascadeTexelSizes[cascade] * 1.5f, 1.0f );
+    float reference = min( coord.z, 1.0f );
+    vec2 texel = 1.0f / vec2( textureSize( shadowMap, 0 ).xy );
+
+    float lit = 0.0f;
+    for ( int y = -shadowFilterRadius; y <= shadowFilterRadius; y++ )
+    {
+        for ( int x = -shadowFilterRadius; x <= shadowFilterRadius; x++ )
+        {
+            lit += texture( shadowMap, vec4( coord.xy + vec2( x, y ) * texel, cascade, reference ) );
+        }
+    }
+    float taps = float( 2 * shadowFilterRadius + 1 );
+    return lit / ( taps * taps );
+}
 
 void main( )
 {
-    //color = vec4( texture( texture_diffuse, TexCoords ));
-	color = vec4(0.0f, 0.8f, 0.0f, 1.0f);
+    //color = vec4( texture( texture_diffuse1, TexCoords ));
+    Material material = materials[materialIndex];
+
+    vec3 norm = normalize( Normal );
+    // w is 0 for a directional light, whose xyz is the direction toward it
+    vec3 lightDir = normalize( lightPosition.xyz - FragPos * lightPosition.w );
+    vec3 viewDir = normalize( cameraPosition.xyz - FragPos );
+    vec3 halfway = normalize( lightDir + viewDir );
+
+    vec3 ambient = material.ambient.rgb * lightColor.rgb;
+    vec3 diffuse = max( dot( norm, lightDir ), 0.0f ) * material.diffuse.rgb * lightColor.rgb;
+    vec3 specular = pow( max( dot( norm, halfway ), 0.0f ), max( material.specular.w, 1.0f ) ) * material.specular.rgb * lightColor.rgb;
+
+    color = vec4( ambient + ShadowFactor( FragPos, norm ) * ( diffuse + specular ), 1.0f );
 }
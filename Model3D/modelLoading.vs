@@ -4,13 +4,31 @@ layout ( location = 1 ) in vec3 normal;
 layout ( location = 2 ) in vec2 texCoords;
 
 out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Computed once per object on the CPU (see Transforms.h) instead of inverting model for every vertex
+uniform mat3 normalMatrix;
+// Decode of the stored positions, set by GeometryArena: compact vertices are [0, 1] within the model's bounds
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+layout ( std140 ) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
 
 void main( )
 {
-    gl_Position = projection * view * model * vec4( position, 1.0f );
+    vec4 localPosition = vec4( positionOffset + positionScale * position, 1.0f );
+    gl_Position = viewProjection * model * localPosition;
     TexCoords = texCoords;
+    FragPos = vec3( model * localPosition );
+    Normal = normalMatrix * normal;
 }
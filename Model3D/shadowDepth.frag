@@ -0,0 +1,6 @@
+#version 330 core
+
+// Shadow cascades only keep the depth
+void main( )
+{
+}
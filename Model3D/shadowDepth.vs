@@ -0,0 +1,14 @@
+#version 330 core
+layout ( location = 0 ) in vec3 position;
+
+uniform mat4 model;
+// Light of the cascade being drawn, set by CascadedShadowMap::BeginCascade( )
+uniform mat4 lightViewProjection;
+// Decode of the stored positions, set by GeometryArena: compact vertices are [0, 1] within the model's bounds
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+void main( )
+{
+    gl_Position = lightViewProjection * model * vec4( positionOffset + positionScale * position, 1.0f );
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "GeometryArena.h"
+
+using namespace std;
+
+// Layout glMultiDrawElementsIndirect reads from the GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// A list of arena ranges submitted with one call per span instead of one per range.
+// With GL 4.3 / ARB_multi_draw_indirect the commands go to an indirect buffer and glMultiDrawElementsIndirect reads
+// them on the GPU. Without it the same spans are submitted with glMultiDrawElementsBaseVertex (core since 3.2),
+// which still takes a whole span per call but walks the arrays on the CPU inside the driver.
+class MultiDrawList
+{
+public:
+    static bool IsIndirectSupported( )
+    {
+        return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+    }
+
+    /*  Functions   */
+    MultiDrawList( ) : indirectBuffer( 0 ), capacity( 0 ), indirect( IsIndirectSupported( ) ), indexType( GL_UNSIGNED_INT )
+    {
+        if( this->indirect )
+        {
+            glGenBuffers( 1, &this->indirectBuffer );
+        }
+    }
+
+    ~MultiDrawList( )
+    {
+        if( 0 != this->indirectBuffer )
+        {
+            glDeleteBuffers( 1, &this->indirectBuffer );
+        }
+    }
+
+    // Starts a new list, for ranges of an arena with indexType indices (GeometryArena::GetIndexType( ))
+    void Clear( GLenum indexType = GL_UNSIGNED_INT )
+    {
+        this->indexType = indexType;
+        this->commands.clear( );
+        this->counts.clear( );
+        this->offsets.clear( );
+        this->baseVertices.clear( );
+    }
+
+    void Add( const GeometryArena::Range &range, GLuint baseInstance = 0 )
+    {
+        DrawElementsIndirectCommand command;
+        command.count = range.indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = range.firstIndex;
+        command.baseVertex = range.baseVertex;
+        command.baseInstance = baseInstance;
+        this->commands.push_back( command );
+
+        if( !this->indirect )
+        {
+            this->counts.push_back( ( GLsizei )range.indexCount );
+            this->offsets.push_back( ( const GLvoid * )( ( size_t )range.firstIndex * GetIndexSize( this->indexType ) ) );
+            this->baseVertices.push_back( range.baseVertex );
+        }
+    }
+
+    GLuint Size( ) const
+    {
+        return ( GLuint )this->commands.size( );
+    }
+
+    // Sends the commands to the GPU, call once after the last Add( ) of a frame
+    void Upload( )
+    {
+        if( !this->indirect || this->commands.empty( ) )
+        {
+            return;
+        }
+
+        GLsizeiptr size = this->commands.size( ) * sizeof( DrawElementsIndirectCommand );
+        glBindBuffer( GL_DRAW_INDIRECT_BUFFER, this->indirectBuffer );
+        if( size > this->capacity )
+        {
+            this->capacity = size;
+        }
+        // Orphan, the previous frame's commands may still be in use
+        glBufferData( GL_DRAW_INDIRECT_BUFFER, this->capacity, NULL, GL_STREAM_DRAW );
+        glBufferSubData( GL_DRAW_INDIRECT_BUFFER, 0, size, &this->commands[0] );
+        glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+    }
+
+    // Draws count commands starting at first. The arena the ranges came from must be bound.
+    void Draw( GLuint first, GLuint count ) const
+    {
+        if( 0 == count )
+        {
+            return;
+        }
+
+        if( this->indirect )
+        {
+            glBindBuffer( GL_DRAW_INDIRECT_BUFFER, this->indirectBuffer );
+            glMultiDrawElementsIndirect( GL_TRIANGLES, this->indexType, ( const GLvoid * )( first * sizeof( DrawElementsIndirectCommand ) ), count, 0 );
+            glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+        }
+        else
+        {
+            glMultiDrawElementsBaseVertex( GL_TRIANGLES, &this->counts[first], this->indexType, ( GLvoid * const * )&this->offsets[first], count, ( GLint * )&this->baseVertices[first] );
+        }
+
+        GetDrawStats( ).drawCalls++;
+    }
+
+    bool IsIndirect( ) const
+    {
+        return this->indirect;
+    }
+
+private:
+    GLuint indirectBuffer;
+    GLsizeiptr capacity;
+    bool indirect;
+    GLenum indexType;
+    vector<DrawElementsIndirectCommand> commands;
+    // Same spans as separate arrays for glMultiDrawElementsBaseVertex
+    vector<GLsizei> counts;
+    vector<const GLvoid *> offsets;
+    vector<GLint> baseVertices;
+
+    MultiDrawList( const MultiDrawList & );
+    MultiDrawList &operator=( const MultiDrawList & );
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "GeometryArena.h"
+#include "StateTracker.h"
+#include "Transforms.h"
+
+using namespace std;
+
+// Bits of each field of a sort key, from the most significant: program, material, VAO, depth
+#define RENDER_KEY_PROGRAM_BITS 12
+#define RENDER_KEY_MATERIAL_BITS 16
+#define RENDER_KEY_VAO_BITS 12
+#define RENDER_KEY_DEPTH_BITS 24
+
+typedef unsigned long long RenderKey;
+
+// Collects the draws of a frame and issues them sorted by program, then material (texture set), then VAO, then
+// front to back, so every state change happens as few times as possible and the StateTracker drops the rest.
+// Usage per frame: Begin( camera position ), Submit( ) every draw (Model::Submit( ) does it per mesh), Flush( ).
+class RenderQueue
+{
+public:
+    /*  Functions   */
+    RenderQueue( ) : cameraPosition( 0.0f )
+    {
+    }
+
+    void Begin( const glm::vec3 &cameraPosition )
+    {
+        this->cameraPosition = cameraPosition;
+        this->items.clear( );
+        this->transforms.clear( );
+        this->transformKinds.clear( );
+    }
+
+    const glm::vec3 &GetCameraPosition( ) const
+    {
+        return this->cameraPosition;
+    }
+
+    // Stores a model matrix for the following submits and returns its index. kind tells Flush( ) whether the normal
+    // matrix needs the cofactors or is the matrix itself.
+    GLuint AddTransform( const glm::mat4 &model, TransformKind kind = TRANSFORM_GENERAL )
+    {
+        this->transforms.push_back( model );
+        this->transformKinds.push_back( ( GLubyte )kind );
+        return ( GLuint )this->transforms.size( ) - 1;
+    }
+
+    // Queues one draw of range from arena with material's textures. materialId only orders the draws (items with the
+    // same id are drawn together), it doesn't have to be unique. depth is the distance to the camera.
+    void Submit( Shader &shader, const Mesh &material, GLuint materialId, const GeometryArena &arena, const GeometryArena::Range &range, GLuint transform, GLfloat depth )
+    {
+        Item item;
+        item.key = MakeKey( shader.ID, materialId, arena.GetVertexArray( ), depth );
+        item.shader = &shader;
+        item.material = &material;
+        item.arena = &arena;
+        item.range = range;
+        item.transform = transform;
+        this->items.push_back( item );
+    }
+
+    // Sorts the queued draws and issues them. Uniforms, textures and VAOs are only set when they change.
+    void Flush( )
+    {
+        this->sort( );
+
+        // Every normal matrix of the frame in one batch, instead of an inverse per vertex in the shader
+        this->normalMatrices.resize( this->transforms.size( ) );
+        if( !this->transforms.empty( ) )
+        {
+            ComputeNormalMatrices( &this->transforms[0], &this->transformKinds[0], this->transforms.size( ), &this->normalMatrices[0] );
+        }
+
+        const Shader *shader = NULL;
+        const Mesh *material = NULL;
+        const GeometryArena *arena = NULL;
+        GLuint transform = 0;
+        UniformHandle modelLoc, normalMatrixLoc;
+
+        for ( size_t i = 0; i < this->order.size( ); i++ )
+        {
+            const Item &item = this->items[this->order[i]];
+
+            bool programChanged = ( item.shader != shader );
+            if( programChanged )
+            {
+                shader = item.shader;
+                item.shader->use( );
+                modelLoc = item.shader->GetUniform( "model" );
+                normalMatrixLoc = item.shader->GetUniform( "normalMatrix" );
+            }
+            // Sampler uniforms belong to the program, so a new program rebinds the material too
+            if( programChanged || item.material != material )
+            {
+                material = item.material;
+                item.material->BindTextures( *item.shader );
+            }
+            if( programChanged || item.transform != transform )
+            {
+                transform = item.transform;
+                item.shader->setMat4( modelLoc, this->transforms[item.transform] );
+                item.shader->setMat3( normalMatrixLoc, this->normalMatrices[item.transform] );
+            }
+
+            item.arena->Bind( );
+            // Each arena has its own position decode (compact vertices), also held per program
+            if( programChanged || item.arena != arena )
+            {
+                arena = item.arena;
+                item.arena->SetPositionUniforms( *item.shader );
+            }
+            item.arena->Draw( item.range );
+        }
+
+        GetStateTracker( ).BindVertexArray( 0 );
+    }
+
+    size_t Size( ) const
+    {
+        return this->items.size( );
+    }
+
+    // Keys compare like ( program, material, VAO, depth ) tuples; names wider than their field wrap around, which
+    // only costs some sorting quality
+    static RenderKey MakeKey( GLuint program, GLuint material, GLuint vertexArray, GLfloat depth )
+    {
+        // A non negative float's bits sort like the float, the top ones are enough to order by depth
+        GLuint depthBits = 0;
+        if( depth > 0.0f )
+        {
+            memcpy( &depthBits, &depth, sizeof( depthBits ) );
+        }
+
+        RenderKey key = program & ( ( 1u << RENDER_KEY_PROGRAM_BITS ) - 1 );
+        key = ( key << RENDER_KEY_MATERIAL_BITS ) | ( material & ( ( 1u << RENDER_KEY_MATERIAL_BITS ) - 1 ) );
+        key = ( key << RENDER_KEY_VAO_BITS ) | ( vertexArray & ( ( 1u << RENDER_KEY_VAO_BITS ) - 1 ) );
+        key = ( key << RENDER_KEY_DEPTH_BITS ) | ( depthBits >> ( 32 - RENDER_KEY_DEPTH_BITS ) );
+
+        return key;
+    }
+
+private:
+    struct Item
+    {
+        RenderKey key;
+        Shader *shader;
+        const Mesh *material;
+        const GeometryArena *arena;
+        GeometryArena::Range range;
+        GLuint transform;
+    };
+
+    glm::vec3 cameraPosition;
+    vector<Item> items;
+    vector<glm::mat4> transforms;
+    vector<GLubyte> transformKinds;
+    vector<glm::mat3> normalMatrices;
+    // Sorted order of items, and the radix sort's scratch
+    vector<GLuint> order, scratch;
+
+    // LSD radix sort of the item indices by key, one byte per pass. Passes where every key has the same byte are
+    // skipped, which with few programs and materials is most of the high ones.
+    void sort( )
+    {
+        size_t count = this->items.size( );
+        this->order.resize( count );
+        this->scratch.resize( count );
+        for ( size_t i = 0; i < count; i++ )
+        {
+            this->order[i] = ( GLuint )i;
+        }
+
+        for ( GLuint shift = 0; shift < 64; shift += 8 )
+        {
+            size_t histogram[256] = { 0 };
+            for ( size_t i = 0; i < count; i++ )
+            {
+                histogram[( this->items[i].key >> shift ) & 0xFF]++;
+            }
+            if( 0 == count || count == histogram[( this->items[0].key >> shift ) & 0xFF] )
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for ( GLuint b = 0; b < 256; b++ )
+            {
+                size_t bucket = histogram[b];
+                histogram[b] = offset;
+                offset += bucket;
+            }
+
+            for ( size_t i = 0; i < count; i++ )
+            {
+                GLuint index = this->order[i];
+                this->scratch[histogram[( this->items[index].key >> shift ) & 0xFF]++] = index;
+            }
+            this->order.swap( this->scratch );
+        }
+    }
+};
@@ -5,9 +5,41 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
 
 #include <GL/glew.h>
 
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "ShaderCache.h"
+#include "FrameUniforms.h"
+#include "Materials.h"
+#include "StateTracker.h"
+#include "TextureUnits.h"
+
+// Resolved uniform, obtained once from Shader::GetUniform( ) and then passed to the typed setters.
+// Setting through a handle costs no lookup at all; an invalid handle (unknown or optimized out uniform) is ignored by GL.
+struct UniformHandle
+{
+    GLint location;
+    
+    UniformHandle( ) : location( -1 )
+    {
+    }
+    
+    explicit UniformHandle( GLint location ) : location( location )
+    {
+    }
+    
+    bool IsValid( ) const
+    {
+        return location >= 0;
+    }
+};
+
 class Shader
 {
 public:
@@ -43,9 +75,160 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
-        const GLchar *vShaderCode = vertexCode.c_str( );
-        const GLchar *fShaderCode = fragmentCode.c_str( );
-        // 2. Compile shaders
+        // 2. Link the program, straight from the program binary cache when possible
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now( );
+        bool useCache = ProgramBinaryCache::IsSupported( );
+        std::string cacheKey = useCache ? ProgramBinaryCache::MakeKey( vertexCode, fragmentCode ) : std::string( );
+        this->ID = glCreateProgram( );
+        bool cacheHit = useCache && ProgramBinaryCache::Load( cacheKey, this->ID );
+        
+        if ( !cacheHit )
+        {
+            // Missing, stale or rejected by the driver: compile from source and refresh the cache
+            if ( useCache )
+            {
+                glProgramParameteri( this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+            }
+            if ( this->compileAndLink( vertexCode.c_str( ), fragmentCode.c_str( ) ) && useCache )
+            {
+                ProgramBinaryCache::Store( cacheKey, this->ID );
+            }
+        }
+        
+        double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now( ) - start ).count( );
+        std::cout << "SHADER::" << ( cacheHit ? "CACHE_HIT " : "COMPILED " ) << vertexPath << " + " << fragmentPath << " in " << milliseconds << " ms" << std::endl;
+        
+        // Look every active uniform up once, so the setters never have to ask the driver by string
+        this->introspectUniforms( );
+        // Shared per frame data (camera, light) comes from the frame uniform buffer
+        this->BindUniformBlock( "FrameUniforms", FRAME_UNIFORMS_BINDING );
+        // and materials from the material library
+        this->BindUniformBlock( "Materials", MATERIALS_BINDING );
+        // Samplers of renderer owned textures get their fixed units
+        this->BindSamplerUnit( "shadowMap", SHADOW_MAP_UNIT );
+        this->BindSamplerUnit( "clusterLights", CLUSTER_LIGHTS_UNIT );
+        this->BindSamplerUnit( "clusterGrid", CLUSTER_GRID_UNIT );
+        this->BindSamplerUnit( "clusterIndices", CLUSTER_INDICES_UNIT );
+	}
+    // Uses the current shader
+    void use( )
+    {
+        GetStateTracker( ).UseProgram( this->ID );
+    }
+    // Attaches a uniform block of this program to a buffer binding point. Programs without the block are left alone.
+    void BindUniformBlock( const std::string &blockName, GLuint binding )
+    {
+        GLuint index = glGetUniformBlockIndex( this->ID, blockName.c_str( ) );
+        if ( GL_INVALID_INDEX != index )
+        {
+            glUniformBlockBinding( this->ID, index, binding );
+        }
+    }
+    // Points a sampler of this program at a texture unit for good. Programs without the sampler are left alone.
+    void BindSamplerUnit( const std::string &name, GLint unit )
+    {
+        UniformHandle sampler = this->GetUniform( name );
+        if ( sampler.IsValid( ) )
+        {
+            GetStateTracker( ).UseProgram( this->ID );
+            glUniform1i( sampler.location, unit );
+        }
+    }
+    // Resolves a uniform from the table built after linking. Call it once (outside the render loop) and keep the handle.
+    UniformHandle GetUniform( const std::string &name ) const
+    {
+        std::unordered_map<std::string, GLuint>::const_iterator it = this->uniformIndices.find( name );
+        
+        return ( it == this->uniformIndices.end( ) ) ? UniformHandle( ) : UniformHandle( this->uniformLocations[it->second] );
+    }
+	// ------------------------------------------------------------------------
+	void setBool(UniformHandle uniform, bool value) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform1i(uniform.location, (int)value);
+	}
+	void setInt(UniformHandle uniform, int value) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform1i(uniform.location, value);
+	}
+	// Binds a sampler uniform to a texture unit
+	void setSampler(UniformHandle uniform, GLint unit) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform1i(uniform.location, unit);
+	}
+	void setFloat(UniformHandle uniform, float value) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform1f(uniform.location, value);
+	}
+	void setVec2(UniformHandle uniform, const glm::vec2 &value) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform2fv(uniform.location, 1, glm::value_ptr(value));
+	}
+	void setVec3(UniformHandle uniform, const glm::vec3 &value) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform3fv(uniform.location, 1, glm::value_ptr(value));
+	}
+	void setVec3(UniformHandle uniform, float x, float y, float z) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform3f(uniform.location, x, y, z);
+	}
+	void setVec4(UniformHandle uniform, const glm::vec4 &value) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniform4fv(uniform.location, 1, glm::value_ptr(value));
+	}
+	void setMat3(UniformHandle uniform, const glm::mat3 &mat) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+	}
+	void setMat4(UniformHandle uniform, const glm::mat4 &mat) const
+	{
+		GetUniformUploadStats().uniformCalls++;
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+	}
+	// ------------------------------------------------------------------------
+	// By name convenience setters, they go through the uniform table (a hash lookup) instead of glGetUniformLocation
+	void setBool(const std::string &name, bool value) const
+	{
+		this->setBool(this->GetUniform(name), value);
+	}
+	void setInt(const std::string &name, int value) const
+	{
+		this->setInt(this->GetUniform(name), value);
+	}
+	void setFloat(const std::string &name, float value) const
+	{
+		this->setFloat(this->GetUniform(name), value);
+	}
+	void setVec3(const std::string &name, const glm::vec3 &value) const
+	{
+		this->setVec3(this->GetUniform(name), value);
+	}
+	void setMat3(const std::string &name, const glm::mat3 &mat) const
+	{
+		this->setMat3(this->GetUniform(name), mat);
+	}
+	void setMat4(const std::string &name, const glm::mat4 &mat) const
+	{
+		this->setMat4(this->GetUniform(name), mat);
+	}
+
+private:
+    /*  Uniform table  */
+    std::vector<GLint> uniformLocations;
+    std::unordered_map<std::string, GLuint> uniformIndices;  // Uniform name -> slot in uniformLocations
+    
+    // Compiles both stages from source and links them into ID. Returns false (after printing the log) on failure.
+    bool compileAndLink( const GLchar *vShaderCode, const GLchar *fShaderCode )
+    {
+        // Compile shaders
         GLuint vertex, fragment;
         GLint success;
         GLchar infoLog[512];
@@ -72,7 +255,6 @@ public:
             std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
         }
         // Shader Program
-        this->ID = glCreateProgram( );
         glAttachShader( this->ID, vertex );
         glAttachShader( this->ID, fragment );
         glLinkProgram( this->ID );
@@ -87,18 +269,56 @@ public:
         glDeleteShader( vertex );
         glDeleteShader( fragment );
         
-	}
-    // Uses the current shader
-    void use( )
+        return GL_TRUE == success;
+    }
+    
+    // Fills the uniform table from glGetActiveUniform. Arrays are registered both as "name" and per element "name[i]".
+    void introspectUniforms( )
     {
-        glUseProgram( this->ID );
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv( this->ID, GL_ACTIVE_UNIFORMS, &count );
+        glGetProgramiv( this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength );
+        
+        std::vector<GLchar> buffer( maxLength + 1 );
+        
+        for ( GLint i = 0; i < count; i++ )
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform( this->ID, ( GLuint )i, ( GLsizei )buffer.size( ), &length, &size, &type, &buffer[0] );
+            std::string name( &buffer[0], length );
+            
+            // Members of uniform blocks have no location, they are set through buffers
+            GLint location = glGetUniformLocation( this->ID, name.c_str( ) );
+            if ( location < 0 )
+            {
+                continue;
+            }
+            
+            if ( name.size( ) > 3 && 0 == name.compare( name.size( ) - 3, 3, "[0]" ) )
+            {
+                std::string base = name.substr( 0, name.size( ) - 3 );
+                this->addUniform( base, location );
+                
+                for ( GLint element = 0; element < size; element++ )
+                {
+                    std::string elementName = base + "[" + std::to_string( element ) + "]";
+                    this->addUniform( elementName, glGetUniformLocation( this->ID, elementName.c_str( ) ) );
+                }
+            }
+            else
+            {
+                this->addUniform( name, location );
+            }
+        }
+    }
+    
+    void addUniform( const std::string &name, GLint location )
+    {
+        this->uniformIndices[name] = ( GLuint )this->uniformLocations.size( );
+        this->uniformLocations.push_back( location );
     }
-	// ------------------------------------------------------------------------
-	void setMat4(const std::string &name, const glm::mat4 &mat) const
-	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-	}
-
 };
 
 #endif
\ No newline at end of file
@@ -7,11 +7,19 @@ layout (location = 2) in vec2 texCoord;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(position, 1.0);
+	gl_Position = viewProjection * model * vec4(position, 1.0);
 	TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);
 };
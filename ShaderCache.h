@@ -0,0 +1,144 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include <GL/glew.h>
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries live in SHADER_CACHE_DIRECTORY, one file per program, named after a hash of the vertex and fragment
+// sources plus the GL vendor, renderer and version strings, so editing a shader or updating the driver simply
+// misses. A binary the driver refuses to link is treated as a miss as well.
+#define SHADER_CACHE_DIRECTORY "shadercache"
+
+class ProgramBinaryCache
+{
+public:
+    // The driver needs ARB_get_program_binary (core in 4.1) and at least one binary format
+    static bool IsSupported( )
+    {
+        if ( !GLEW_ARB_get_program_binary && !GLEW_VERSION_4_1 )
+        {
+            return false;
+        }
+
+        GLint formats = 0;
+        glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+
+        return formats > 0;
+    }
+
+    static std::string MakeKey( const std::string &vertexCode, const std::string &fragmentCode )
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        const char *driver[] = {
+            ( const char * )glGetString( GL_VENDOR ),
+            ( const char * )glGetString( GL_RENDERER ),
+            ( const char * )glGetString( GL_VERSION )
+        };
+
+        hashString( hash, vertexCode );
+        hashString( hash, fragmentCode );
+        for ( int i = 0; i < 3; i++ )
+        {
+            hashString( hash, driver[i] ? driver[i] : "" );
+        }
+
+        std::stringstream key;
+        key << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+
+        return key.str( );
+    }
+
+    // Links program from a cached binary. Returns false on a miss or if the driver rejects the binary.
+    static bool Load( const std::string &key, GLuint program )
+    {
+        std::ifstream file( getPath( key ).c_str( ), std::ios::binary );
+        if ( !file )
+        {
+            return false;
+        }
+
+        GLenum format = 0;
+        file.read( ( char * )&format, sizeof( format ) );
+        std::vector<char> binary( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>( ) );
+
+        if ( binary.empty( ) )
+        {
+            return false;
+        }
+
+        glProgramBinary( program, format, &binary[0], ( GLsizei )binary.size( ) );
+
+        GLint success = 0;
+        glGetProgramiv( program, GL_LINK_STATUS, &success );
+
+        return GL_TRUE == success;
+    }
+
+    // Saves the binary of a successfully linked program
+    static void Store( const std::string &key, GLuint program )
+    {
+        GLint length = 0;
+        glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+        if ( length <= 0 )
+        {
+            return;
+        }
+
+        std::vector<char> binary( length );
+        GLenum format = 0;
+        glGetProgramBinary( program, length, NULL, &format, &binary[0] );
+
+#ifdef _WIN32
+        _mkdir( SHADER_CACHE_DIRECTORY );
+#else
+        mkdir( SHADER_CACHE_DIRECTORY, 0755 );
+#endif
+
+        std::string path = getPath( key );
+        std::string tempPath = path + ".tmp";
+        std::ofstream file( tempPath.c_str( ), std::ios::binary | std::ios::trunc );
+        file.write( ( const char * )&format, sizeof( format ) );
+        file.write( &binary[0], binary.size( ) );
+        bool written = file.good( );
+        file.close( );
+
+        std::remove( path.c_str( ) );
+        if ( !written || 0 != std::rename( tempPath.c_str( ), path.c_str( ) ) )
+        {
+            std::remove( tempPath.c_str( ) );
+        }
+    }
+
+private:
+    static std::string getPath( const std::string &key )
+    {
+        return std::string( SHADER_CACHE_DIRECTORY ) + "/" + key + ".bin";
+    }
+
+    // 64 bit FNV-1a, the terminating zero is hashed too so ("ab", "c") and ("a", "bc") differ
+    static void hashString( uint64_t &hash, const std::string &text )
+    {
+        for ( size_t i = 0; i <= text.size( ); i++ )
+        {
+            hash ^= ( unsigned char )text.c_str( )[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Frustum.h"
+#include "Shader.h"
+#include "Camera.h"
+
+using namespace std;
+
+// Split distances travel in one vec4 uniform. Must match MAX_CASCADES in the lighting shaders
+#define SHADOW_MAX_CASCADES 4
+// Depth pass glPolygonOffset, against the acne of surfaces shadowing themselves
+#define SHADOW_SLOPE_BIAS 2.0f
+#define SHADOW_CONSTANT_BIAS 2.0f
+
+// Runtime settings of a CascadedShadowMap
+struct ShadowOptions
+{
+    GLuint cascadeCount;        // At most SHADOW_MAX_CASCADES, 0 turns shadows off and allocates nothing
+    GLuint resolution;          // Texels per side of every cascade
+    GLfloat maxDistance;        // Shadows end this far from the camera, or at its far plane if that is nearer
+    GLfloat splitLambda;        // How the cascades split the distance: 0 evenly, 1 logarithmically
+    GLfloat casterMargin;       // How far toward the light from a cascade's volume casters are still drawn
+    GLint filterRadius;         // PCF over ( 2r + 1 )^2 hardware filtered lookups, 0 is a single 2x2 lookup
+
+    ShadowOptions( ) : cascadeCount( 4 ), resolution( 2048 ), maxDistance( 50.0f ), splitLambda( 0.75f ), casterMargin( 20.0f ), filterRadius( 1 )
+    {
+    }
+
+    // Overrides the settings given on the command line: "--shadow-cascades N", "--shadow-resolution N",
+    // "--shadow-distance D" and "--shadow-filter R"
+    void ParseArguments( int argc, char **argv )
+    {
+        for ( int i = 1; i + 1 < argc; i++ )
+        {
+            if( 0 == strcmp( argv[i], "--shadow-cascades" ) )
+            {
+                this->cascadeCount = ( GLuint )std::min( std::max( atoi( argv[++i] ), 0 ), SHADOW_MAX_CASCADES );
+            }
+            else if( 0 == strcmp( argv[i], "--shadow-resolution" ) )
+            {
+                this->resolution = ( GLuint )std::max( atoi( argv[++i] ), 16 );
+            }
+            else if( 0 == strcmp( argv[i], "--shadow-distance" ) )
+            {
+                this->maxDistance = std::max( ( GLfloat )atof( argv[++i] ), 0.01f );
+            }
+            else if( 0 == strcmp( argv[i], "--shadow-filter" ) )
+            {
+                this->filterRadius = std::max( atoi( argv[++i] ), 0 );
+            }
+        }
+    }
+};
+
+// Per cascade results of a CascadedShadowMap
+struct ShadowStats
+{
+    GLuint cascadeCount;
+    GLfloat splits[SHADOW_MAX_CASCADES];        // Distance from the camera where each cascade ends
+    GLfloat texelSizes[SHADOW_MAX_CASCADES];    // World size of one shadow map texel
+    double gpuMs[SHADOW_MAX_CASCADES];          // GPU time of each depth pass, GL_TIME_ELAPSED from two frames ago
+    double totalGpuMs;
+};
+
+// Cascaded shadow maps for a directional light. The camera's view volume, up to a shadow distance, is split into
+// slices that each get their own depth map, so the shadow texels near the camera are small and the far ones large.
+//
+// Every cascade covers the bounding sphere of its slice with an orthographic projection from the light, the sphere
+// doesn't change as the camera turns, and its center is snapped to whole texels, so shadow edges don't swim while the
+// camera moves. The cascades are layers of one depth texture array, sampled with hardware comparison plus PCF.
+//
+// A frame goes
+//     Update( )                                fit the cascades to the camera
+//     BeginCascade( i ), draw, EndCascade( )   for every cascade: draw the casters culled by GetFrustum( i, model )
+//     End( )                                   back to the framebuffer and viewport of before
+//     Bind( shader )                           then draw the scene with a lighting shader that reads the cascades
+//
+// With 0 cascades nothing is allocated, the passes are skipped and Bind( ) only turns the shadows of the shader off.
+class CascadedShadowMap
+{
+public:
+    /*  Functions   */
+    explicit CascadedShadowMap( const ShadowOptions &options = ShadowOptions( ) ) : options( options ), active( false ), targetFBO( 0 ), frame( 0 )
+    {
+        this->options.cascadeCount = std::min( this->options.cascadeCount, ( GLuint )SHADOW_MAX_CASCADES );
+        memset( &this->stats, 0, sizeof( this->stats ) );
+        this->stats.cascadeCount = this->options.cascadeCount;
+        memset( this->targetViewport, 0, sizeof( this->targetViewport ) );
+        memset( this->pending, 0, sizeof( this->pending ) );
+        memset( this->queries, 0, sizeof( this->queries ) );
+        this->depthArray = this->FBO = 0;
+        if( 0 == this->options.cascadeCount )
+        {
+            return;
+        }
+
+        glGenTextures( 1, &this->depthArray );
+        glBindTexture( GL_TEXTURE_2D_ARRAY, this->depthArray );
+        glTexImage3D( GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, this->options.resolution, this->options.resolution, this->options.cascadeCount, 0,
+                      GL_DEPTH_COMPONENT, GL_FLOAT, NULL );
+        // Linear filtering of a comparison is a free 2x2 PCF
+        glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+        glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+        // Outside the map nothing is in shadow
+        const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER );
+        glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER );
+        glTexParameterfv( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border );
+        glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+
+        GLint previous = 0;
+        glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &previous );
+        glGenFramebuffers( 1, &this->FBO );
+        glBindFramebuffer( GL_FRAMEBUFFER, this->FBO );
+        glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->depthArray, 0, 0 );
+        glDrawBuffer( GL_NONE );
+        glReadBuffer( GL_NONE );
+        if( GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus( GL_FRAMEBUFFER ) )
+        {
+            cout << "ERROR::SHADOW:: Cascade framebuffer is not complete" << endl;
+        }
+        glBindFramebuffer( GL_FRAMEBUFFER, ( GLuint )previous );
+
+        glGenQueries( 2 * SHADOW_MAX_CASCADES, &this->queries[0][0] );
+    }
+
+    ~CascadedShadowMap( )
+    {
+        if( 0 == this->FBO )
+        {
+            return;
+        }
+        glDeleteQueries( 2 * SHADOW_MAX_CASCADES, &this->queries[0][0] );
+        glDeleteFramebuffers( 1, &this->FBO );
+        glDeleteTextures( 1, &this->depthArray );
+    }
+
+    // Fits the cascades to the view volume of view and projection, whose clipping planes are nearPlane and farPlane.
+    // lightDirection is the way the light travels (from the sun toward the scene).
+    void Update( const glm::mat4 &view, const glm::mat4 &projection, GLfloat nearPlane, GLfloat farPlane, const glm::vec3 &lightDirection )
+    {
+        this->fitCascades( glm::inverse( view ), glm::inverse( projection ), nearPlane, farPlane, lightDirection );
+    }
+
+    // Update( ) for a Camera, from the inverse matrices and clipping planes it has cached
+    void Update( Camera &camera, const glm::vec3 &lightDirection )
+    {
+        this->fitCascades( camera.GetInverseViewMatrix( ), camera.GetInverseProjectionMatrix( ), camera.GetNear( ), camera.GetFar( ), lightDirection );
+    }
+
+    // Starts rendering the depth of cascade: binds its layer, clears it and sets the light's lightViewProjection on
+    // depthShader, which is left in use. Draw the casters with it, then call EndCascade( ).
+    void BeginCascade( GLuint cascade, Shader &depthShader )
+    {
+        if( cascade >= this->options.cascadeCount )
+        {
+            return;
+        }
+        if( !this->active )
+        {
+            GLint target = 0;
+            glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &target );
+            this->targetFBO = ( GLuint )target;
+            glGetIntegerv( GL_VIEWPORT, this->targetViewport );
+
+            glBindFramebuffer( GL_FRAMEBUFFER, this->FBO );
+            glViewport( 0, 0, this->options.resolution, this->options.resolution );
+            glEnable( GL_POLYGON_OFFSET_FILL );
+            glPolygonOffset( SHADOW_SLOPE_BIAS, SHADOW_CONSTANT_BIAS );
+            this->active = true;
+        }
+
+        glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->depthArray, 0, cascade );
+        glClear( GL_DEPTH_BUFFER_BIT );
+        glBeginQuery( GL_TIME_ELAPSED, this->queries[this->frame & 1][cascade] );
+
+        depthShader.use( );
+        depthShader.setMat4( this->getUniforms( depthShader ).lightViewProjection, this->viewProjections[cascade] );
+    }
+
+    void EndCascade( )
+    {
+        if( !this->active )
+        {
+            return;
+        }
+        glEndQuery( GL_TIME_ELAPSED );
+        this->pending[this->frame & 1] = true;
+    }
+
+    // Back to the framebuffer and viewport that were current at the first BeginCascade( )
+    void End( )
+    {
+        if( !this->active )
+        {
+            return;
+        }
+        glDisable( GL_POLYGON_OFFSET_FILL );
+        glBindFramebuffer( GL_FRAMEBUFFER, this->targetFBO );
+        glViewport( this->targetViewport[0], this->targetViewport[1], this->targetViewport[2], this->targetViewport[3] );
+        this->active = false;
+    }
+
+    // Light volume of cascade in the local space of model, to cull the casters drawn into it
+    Frustum GetFrustum( GLuint cascade, const glm::mat4 &model = glm::mat4( ) ) const
+    {
+        return Frustum( this->viewProjections[cascade] * model );
+    }
+
+    const glm::mat4 &GetLightViewProjection( GLuint cascade ) const
+    {
+        return this->viewProjections[cascade];
+    }
+
+    // Binds the cascades to SHADOW_MAP_UNIT (where Shader points shadowMap) and sets the shadow uniforms of shader,
+    // which has to be in use
+    void Bind( const Shader &shader ) const
+    {
+        glActiveTexture( GL_TEXTURE0 + SHADOW_MAP_UNIT );
+        glBindTexture( GL_TEXTURE_2D_ARRAY, this->depthArray );
+        glActiveTexture( GL_TEXTURE0 );
+
+        // Light clip space to [0, 1] texture coordinates and depth
+        const glm::mat4 bias = glm::scale( glm::translate( glm::mat4( ), glm::vec3( 0.5f ) ), glm::vec3( 0.5f ) );
+        const ShadowUniforms &uniforms = this->getUniforms( shader );
+        for ( GLuint i = 0; i < this->options.cascadeCount; i++ )
+        {
+            shader.setMat4( uniforms.matrices[i], bias * this->viewProjections[i] );
+        }
+        glm::vec4 splits( 0.0f ), texelSizes( 0.0f );
+        for ( GLuint i = 0; i < this->options.cascadeCount; i++ )
+        {
+            splits[i] = this->stats.splits[i];
+            texelSizes[i] = this->stats.texelSizes[i];
+        }
+        shader.setVec4( uniforms.splits, splits );
+        shader.setVec4( uniforms.texelSizes, texelSizes );
+        shader.setInt( uniforms.cascadeCount, ( int )this->options.cascadeCount );
+        shader.setInt( uniforms.filterRadius, this->options.filterRadius );
+    }
+
+    GLuint GetCascadeCount( ) const
+    {
+        return this->options.cascadeCount;
+    }
+
+    const ShadowOptions &GetOptions( ) const
+    {
+        return this->options;
+    }
+
+    const ShadowStats &GetStats( ) const
+    {
+        return this->stats;
+    }
+
+    // Bytes of the depth array
+    GLsizeiptr GetMemoryUsage( ) const
+    {
+        return ( GLsizeiptr )this->options.resolution * this->options.resolution * 4 * this->options.cascadeCount;
+    }
+
+private:
+    /*  Shadow Data  */
+    ShadowOptions options;
+    GLuint depthArray;
+    GLuint FBO;
+    glm::mat4 viewProjections[SHADOW_MAX_CASCADES];
+    ShadowStats stats;
+
+    // State to restore at End( )
+    bool active;
+    GLuint targetFBO;
+    GLint targetViewport[4];
+
+    // Timer queries of the depth passes, alternating between two frames so reading them never waits on the GPU
+    GLuint queries[2][SHADOW_MAX_CASCADES];
+    bool pending[2];
+    GLuint frame;
+
+    struct ShadowUniforms
+    {
+        GLuint program;
+        UniformHandle lightViewProjection;
+        UniformHandle matrices[SHADOW_MAX_CASCADES];
+        UniformHandle splits;
+        UniformHandle texelSizes;
+        UniformHandle cascadeCount;
+        UniformHandle filterRadius;
+    };
+    mutable vector<ShadowUniforms> uniforms;    // One per shader the cascades were drawn or bound with
+
+    CascadedShadowMap( const CascadedShadowMap & );
+    CascadedShadowMap &operator=( const CascadedShadowMap & );
+
+    /*  Functions   */
+    // Splits the view volume given by its inverse view and projection matrices and fits a light projection to every
+    // slice. lightDirection is the way the light travels.
+    void fitCascades( const glm::mat4 &inverseView, const glm::mat4 &inverseProjection, GLfloat nearPlane, GLfloat farPlane, const glm::vec3 &lightDirection )
+    {
+        GLuint count = this->options.cascadeCount;
+        if( 0 == count )
+        {
+            return;
+        }
+        this->collectTimings( );
+
+        GLfloat farDistance = std::min( farPlane, this->options.maxDistance );
+        nearPlane = std::min( nearPlane, farDistance * 0.5f );
+        // Practical split scheme: a blend of the logarithmic split (same texel to pixel ratio in every cascade) and the
+        // even one (the logarithmic alone spends far too much on the first meters)
+        for ( GLuint i = 0; i < count; i++ )
+        {
+            GLfloat part = ( GLfloat )( i + 1 ) / count;
+            GLfloat logarithmic = nearPlane * std::pow( farDistance / nearPlane, part );
+            GLfloat even = nearPlane + ( farDistance - nearPlane ) * part;
+            this->stats.splits[i] = this->options.splitLambda * logarithmic + ( 1.0f - this->options.splitLambda ) * even;
+        }
+
+        // View space corners of the view volume at the near and far planes, slices lie in between
+        glm::vec3 nearCorners[4], farCorners[4];
+        for ( GLuint i = 0; i < 4; i++ )
+        {
+            GLfloat x = ( i & 1 ) ? 1.0f : -1.0f, y = ( i & 2 ) ? 1.0f : -1.0f;
+            glm::vec4 corner = inverseProjection * glm::vec4( x, y, -1.0f, 1.0f );
+            nearCorners[i] = glm::vec3( corner ) / corner.w;
+            corner = inverseProjection * glm::vec4( x, y, 1.0f, 1.0f );
+            farCorners[i] = glm::vec3( corner ) / corner.w;
+        }
+        GLfloat volumeNear = -nearCorners[0].z, volumeFar = -farCorners[0].z;
+
+        // One light rotation for every cascade and frame, only the translation of the projections moves
+        glm::vec3 direction = glm::normalize( lightDirection );
+        glm::vec3 up = ( std::fabs( direction.y ) > 0.99f ) ? glm::vec3( 0.0f, 0.0f, 1.0f ) : glm::vec3( 0.0f, 1.0f, 0.0f );
+        glm::mat4 lightView = glm::lookAt( glm::vec3( 0.0f ), direction, up );
+
+        for ( GLuint cascade = 0; cascade < count; cascade++ )
+        {
+            GLfloat sliceNear = ( 0 == cascade ) ? nearPlane : this->stats.splits[cascade - 1];
+            GLfloat sliceFar = this->stats.splits[cascade];
+
+            // World space corners of the slice, along the edges of the view volume
+            glm::vec3 corners[8];
+            glm::vec3 center( 0.0f );
+            for ( GLuint i = 0; i < 4; i++ )
+            {
+                GLfloat nearPart = ( sliceNear - volumeNear ) / ( volumeFar - volumeNear );
+                GLfloat farPart = ( sliceFar - volumeNear ) / ( volumeFar - volumeNear );
+                corners[i] = glm::vec3( inverseView * glm::vec4( glm::mix( nearCorners[i], farCorners[i], nearPart ), 1.0f ) );
+                corners[i + 4] = glm::vec3( inverseView * glm::vec4( glm::mix( nearCorners[i], farCorners[i], farPart ), 1.0f ) );
+                center += corners[i] + corners[i + 4];
+            }
+            center /= 8.0f;
+
+            // A sphere keeps the same size whichever way the camera looks; rounding its radius up keeps it from
+            // changing with float noise
+            GLfloat radius = 0.0f;
+            for ( GLuint i = 0; i < 8; i++ )
+            {
+                radius = std::max( radius, glm::length( corners[i] - center ) );
+            }
+            radius = std::ceil( radius * 16.0f ) / 16.0f;
+
+            // Moving the projection by whole texels only keeps every texel over the same piece of the world
+            GLfloat texelSize = 2.0f * radius / this->options.resolution;
+            glm::vec3 lightCenter( lightView * glm::vec4( center, 1.0f ) );
+            lightCenter.x = std::floor( lightCenter.x / texelSize ) * texelSize;
+            lightCenter.y = std::floor( lightCenter.y / texelSize ) * texelSize;
+
+            glm::mat4 lightProjection = glm::ortho( lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius,
+                                                    -lightCenter.z - radius - this->options.casterMargin, -lightCenter.z + radius );
+            this->viewProjections[cascade] = lightProjection * lightView;
+            this->stats.texelSizes[cascade] = texelSize;
+        }
+    }
+
+    // Reads back the depth pass times of the query set this frame reuses, issued two frames ago
+    void collectTimings( )
+    {
+        this->frame++;
+        GLuint set = this->frame & 1;
+        if( !this->pending[set] )
+        {
+            return;
+        }
+
+        this->stats.totalGpuMs = 0.0;
+        for ( GLuint i = 0; i < this->options.cascadeCount; i++ )
+        {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v( this->queries[set][i], GL_QUERY_RESULT, &nanoseconds );
+            this->stats.gpuMs[i] = nanoseconds / 1000000.0;
+            this->stats.totalGpuMs += this->stats.gpuMs[i];
+        }
+        this->pending[set] = false;
+    }
+
+    const ShadowUniforms &getUniforms( const Shader &shader ) const
+    {
+        for ( size_t i = 0; i < this->uniforms.size( ); i++ )
+        {
+            if( this->uniforms[i].program == shader.ID )
+            {
+                return this->uniforms[i];
+            }
+        }
+
+        ShadowUniforms entry;
+        entry.program = shader.ID;
+        entry.lightViewProjection = shader.GetUniform( "lightViewProjection" );
+        for ( GLuint i = 0; i < SHADOW_MAX_CASCADES; i++ )
+        {
+            entry.matrices[i] = shader.GetUniform( "shadowMatrices[" + std::to_string( i ) + "]" );
+        }
+        entry.splits = shader.GetUniform( "cascadeSplits" );
+        entry.texelSizes = shader.GetUniform( "cascadeTexelSizes" );
+        entry.cascadeCount = shader.GetUniform( "cascadeCount" );
+        entry.filterRadius = shader.GetUniform( "shadowFilterRadius" );
+        this->uniforms.push_back( entry );
+        return this->uniforms.back( );
+    }
+};
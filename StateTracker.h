@@ -0,0 +1,107 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Texture units the tracker remembers, binds to higher units always go through
+#define STATE_TRACKER_TEXTURE_UNITS 16
+
+// Issued and skipped (already current) state changes, reset them at the start of a frame to get per frame numbers
+struct StateChangeStats
+{
+    GLuint programChanges, programsElided;
+    GLuint textureChanges, texturesElided;
+    GLuint vaoChanges, vaosElided;
+};
+
+inline StateChangeStats &GetStateChangeStats( )
+{
+    static StateChangeStats stats = { 0, 0, 0, 0, 0, 0 };
+    return stats;
+}
+
+// Shadow copy of the program, 2D texture and VAO bindings, so a bind of what is already bound never reaches GL.
+// It only knows about binds made through it: code calling glUseProgram, glBindTexture or glBindVertexArray directly
+// must call Invalidate( ) afterwards. Binding 0 when done isn't enough, the tracker would still take what it bound
+// last for current and skip the next bind of it.
+class StateTracker
+{
+public:
+    /*  Functions   */
+    StateTracker( )
+    {
+        this->Invalidate( );
+    }
+
+    // Forgets every binding, the next request of each one is issued
+    void Invalidate( )
+    {
+        this->program = UNKNOWN;
+        this->vertexArray = UNKNOWN;
+        for ( GLuint i = 0; i < STATE_TRACKER_TEXTURE_UNITS; i++ )
+        {
+            this->textures[i] = UNKNOWN;
+        }
+    }
+
+    // Each returns true when the call reached GL
+    bool UseProgram( GLuint program )
+    {
+        if( program == this->program )
+        {
+            GetStateChangeStats( ).programsElided++;
+            return false;
+        }
+
+        glUseProgram( program );
+        this->program = program;
+        GetStateChangeStats( ).programChanges++;
+        return true;
+    }
+
+    bool BindTexture( GLuint unit, GLuint texture )
+    {
+        if( unit < STATE_TRACKER_TEXTURE_UNITS && texture == this->textures[unit] )
+        {
+            GetStateChangeStats( ).texturesElided++;
+            return false;
+        }
+
+        // The active unit isn't tracked, code outside the tracker switches it all the time
+        glActiveTexture( GL_TEXTURE0 + unit );
+        glBindTexture( GL_TEXTURE_2D, texture );
+        if( unit < STATE_TRACKER_TEXTURE_UNITS )
+        {
+            this->textures[unit] = texture;
+        }
+        GetStateChangeStats( ).textureChanges++;
+        return true;
+    }
+
+    bool BindVertexArray( GLuint vertexArray )
+    {
+        if( vertexArray == this->vertexArray )
+        {
+            GetStateChangeStats( ).vaosElided++;
+            return false;
+        }
+
+        glBindVertexArray( vertexArray );
+        this->vertexArray = vertexArray;
+        GetStateChangeStats( ).vaoChanges++;
+        return true;
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint textures[STATE_TRACKER_TEXTURE_UNITS];
+};
+
+// Tracker of the current context, the demos only ever have one
+inline StateTracker &GetStateTracker( )
+{
+    static StateTracker tracker;
+    return tracker;
+}
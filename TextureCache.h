@@ -0,0 +1,239 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+
+#include <GL/glew.h>
+#include "SOIL2/SOIL2.h"
+
+#include "TextureLoader.h"
+
+using namespace std;
+
+// Process wide texture cache shared by every Model and the hand written demo loaders.
+// Textures are keyed by canonical path plus SOIL load flags, so "res/./wood.jpg" and "res/wood.jpg" requested as
+// SOIL_LOAD_RGB resolve to the same GL texture while a SOIL_LOAD_RGBA request of the same file is a separate one.
+// Every Acquire( ) must be paired with a Release( ); the texture is deleted when the last reference goes away.
+// Must only be used from the thread that owns the GL context.
+class TextureCache
+{
+public:
+    struct Stats
+    {
+        size_t hits;
+        size_t misses;
+        size_t residentTextures;
+        size_t residentBytes;    // Estimated GPU memory of the live textures, mip chain included
+    };
+
+    /*  Functions   */
+    static TextureCache &Instance( )
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // Returns the texture for path, loading it on a miss. With a loader the miss is decoded and uploaded in the
+    // background (the texture shows a placeholder until then), otherwise it is loaded synchronously. The loader must
+    // outlive the texture, its last Release( ) cancels a load that hasn't finished.
+    GLuint Acquire( const string &path, int soilFlags = SOIL_LOAD_RGB, AsyncTextureLoader *loader = NULL )
+    {
+        string key = CanonicalPath( path );
+        key += '|';
+        key += ( char )( '0' + soilFlags );
+
+        unordered_map<string, Entry>::iterator it = this->entries.find( key );
+
+        if( it != this->entries.end( ) )
+        {
+            this->hits++;
+            it->second.references++;
+            return it->second.textureID;
+        }
+
+        this->misses++;
+
+        Entry entry;
+        entry.textureID = ( NULL != loader ) ? loader->Request( path, soilFlags ) : LoadTextureFile( path, soilFlags );
+        entry.references = 1;
+        entry.soilFlags = soilFlags;
+        entry.loader = loader;
+
+        if( 0 == entry.textureID )
+        {
+            return 0; // Not cached so a later request can retry
+        }
+
+        this->entries[key] = entry;
+        this->keys[entry.textureID] = key;
+
+        return entry.textureID;
+    }
+
+    // Takes one more reference on a texture returned by Acquire( ), e.g. for a copy of a mesh using it
+    void AddReference( GLuint textureID )
+    {
+        unordered_map<GLuint, string>::iterator key = this->keys.find( textureID );
+
+        if( key != this->keys.end( ) )
+        {
+            this->entries[key->second].references++;
+        }
+    }
+
+    // Drops one reference, the GL texture is deleted with the last one
+    void Release( GLuint textureID )
+    {
+        unordered_map<GLuint, string>::iterator key = this->keys.find( textureID );
+
+        if( key == this->keys.end( ) )
+        {
+            return;
+        }
+
+        unordered_map<string, Entry>::iterator it = this->entries.find( key->second );
+
+        if( 0 == --it->second.references )
+        {
+            // A load still in flight would otherwise stream into the deleted name, or a texture that reused it
+            if( NULL != it->second.loader )
+            {
+                it->second.loader->Cancel( textureID );
+            }
+            glDeleteTextures( 1, &textureID );
+            this->entries.erase( it );
+            this->keys.erase( key );
+        }
+    }
+
+    Stats GetStats( ) const
+    {
+        Stats stats;
+        stats.hits = this->hits;
+        stats.misses = this->misses;
+        stats.residentTextures = this->entries.size( );
+        stats.residentBytes = 0;
+
+        // Asks GL for the real size so textures still showing their async placeholder are counted as such
+        for ( unordered_map<string, Entry>::const_iterator it = this->entries.begin( ); it != this->entries.end( ); ++it )
+        {
+            GLint width = 0, height = 0;
+            GetStateTracker( ).BindTexture( 0, it->second.textureID );
+            glGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width );
+            glGetTexLevelParameteriv( GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height );
+
+            size_t channels = ( SOIL_LOAD_AUTO == it->second.soilFlags ) ? 4 : it->second.soilFlags;
+            stats.residentBytes += ( size_t )width * height * channels * 4 / 3;
+        }
+        GetStateTracker( ).BindTexture( 0, 0 );
+
+        return stats;
+    }
+
+    // Normalizes separators and removes "." / ".." segments (case insensitive on Windows)
+    static string CanonicalPath( const string &path )
+    {
+        vector<string> segments;
+        string segment;
+        bool absolute = !path.empty( ) && ( '/' == path[0] || '\\' == path[0] );
+
+        for ( size_t i = 0; i <= path.size( ); i++ )
+        {
+            if( i == path.size( ) || '/' == path[i] || '\\' == path[i] )
+            {
+                if( ".." == segment && !segments.empty( ) && ".." != segments.back( ) )
+                {
+                    segments.pop_back( );
+                }
+                else if( !segment.empty( ) && "." != segment )
+                {
+                    segments.push_back( segment );
+                }
+                segment.clear( );
+            }
+            else
+            {
+                segment += path[i];
+            }
+        }
+
+        string canonical = absolute ? "/" : "";
+        for ( size_t i = 0; i < segments.size( ); i++ )
+        {
+            canonical += ( i > 0 ? "/" : "" ) + segments[i];
+        }
+
+#ifdef _WIN32
+        std::transform( canonical.begin( ), canonical.end( ), canonical.begin( ), ::tolower );
+#endif
+
+        return canonical;
+    }
+
+    // Synchronous load: decode, upload, generate mipmaps. Returns 0 if the image can't be read.
+    static GLuint LoadTextureFile( const string &path, int soilFlags )
+    {
+        int width, height, channels = 0;
+        unsigned char *image = SOIL_load_image( path.c_str( ), &width, &height, &channels, soilFlags );
+
+        if( NULL == image )
+        {
+            cout << "ERROR::TEXTURE_CACHE:: Failed to load " << path << endl;
+            return 0;
+        }
+
+        if( SOIL_LOAD_AUTO != soilFlags )
+        {
+            channels = soilFlags;
+        }
+
+        const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        GLenum format = formats[std::min( std::max( channels, 1 ), 4 )];
+
+        //Generate texture ID and assign the image to it
+        GLuint textureID;
+        glGenTextures( 1, &textureID );
+        GetStateTracker( ).BindTexture( 0, textureID );
+        {
+            ScopedUnpackAlignment alignment;
+            glTexImage2D( GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image );
+        }
+        glGenerateMipmap( GL_TEXTURE_2D );
+
+        // Parameters
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        GetStateTracker( ).BindTexture( 0, 0 );
+        SOIL_free_image_data( image );
+
+        return textureID;
+    }
+
+private:
+    struct Entry
+    {
+        GLuint textureID;
+        GLuint references;
+        int soilFlags;
+        AsyncTextureLoader *loader;     // Loader still streaming the image in, NULL for synchronous loads
+    };
+
+    /*  Cache Data  */
+    unordered_map<string, Entry> entries;  // Canonical path + flags -> texture
+    unordered_map<GLuint, string> keys;    // Texture -> key, for Release( )
+    size_t hits;
+    size_t misses;
+
+    TextureCache( ) : hits( 0 ), misses( 0 )
+    {
+    }
+
+    TextureCache( const TextureCache & );
+    TextureCache &operator=( const TextureCache & );
+};
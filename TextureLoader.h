@@ -0,0 +1,379 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+
+#include <GL/glew.h>
+#include "SOIL2/SOIL2.h"
+
+#include "ThreadPool.h"
+#include "StateTracker.h"
+
+using namespace std;
+
+// Sets GL_UNPACK_ALIGNMENT to 1 for tightly packed pixel rows and puts the previous value back at the end of the scope
+class ScopedUnpackAlignment
+{
+public:
+    ScopedUnpackAlignment( )
+    {
+        glGetIntegerv( GL_UNPACK_ALIGNMENT, &this->previous );
+        glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    }
+
+    ~ScopedUnpackAlignment( )
+    {
+        glPixelStorei( GL_UNPACK_ALIGNMENT, this->previous );
+    }
+
+private:
+    GLint previous;
+
+    ScopedUnpackAlignment( const ScopedUnpackAlignment & );
+    ScopedUnpackAlignment &operator=( const ScopedUnpackAlignment & );
+};
+
+// Loads textures without stalling the render thread:
+//   1. Request( ) creates the texture object right away with a 1x1 placeholder so it can be bound immediately.
+//   2. Worker threads decode the image file (SOIL) in the background.
+//   3. Update( ), called once per frame on the GL thread, allocates the storage of the next decoded image and streams
+//      its rows into it with glTexSubImage2D through a pixel buffer object, in bands of at most bytesPerFrame bytes
+//      per call, so a big texture is spread over several frames and fills in band by band.
+//   4. After the last band the mipmaps are generated.
+class AsyncTextureLoader
+{
+public:
+    /*  Functions   */
+    AsyncTextureLoader( unsigned int decodeThreads = 0, size_t bytesPerFrame = 8 * 1024 * 1024 )
+        : bytesPerFrame( bytesPerFrame ), pbo( 0 ), nextJob( 0 ), queueDepth( 0 ), bytesInFlight( 0 ), cancelled( false ), decoders( decodeThreads )
+    {
+        this->active.pixels = NULL;
+    }
+
+    ~AsyncTextureLoader( )
+    {
+        // Stop the queued decodes and wait for the running ones before tearing anything down
+        this->cancelled = true;
+        this->decoders.Wait( );
+
+        if( NULL != this->active.pixels )
+        {
+            SOIL_free_image_data( this->active.pixels );
+        }
+        if( 0 != this->pbo )
+        {
+            glDeleteBuffers( 1, &this->pbo );
+        }
+
+        for ( size_t i = 0; i < this->decoded.size( ); i++ )
+        {
+            SOIL_free_image_data( this->decoded[i].pixels );
+        }
+    }
+
+    // Returns a texture that shows a placeholder until the image at path is resident.
+    // soilFlags is the channel request passed to SOIL (SOIL_LOAD_RGB, SOIL_LOAD_RGBA, ...).
+    GLuint Request( const string &path, int soilFlags = SOIL_LOAD_RGB )
+    {
+        GLuint textureID;
+        glGenTextures( 1, &textureID );
+
+        const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+        GetStateTracker( ).BindTexture( 0, textureID );
+        {
+            ScopedUnpackAlignment alignment;
+            glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder );
+        }
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        GetStateTracker( ).BindTexture( 0, 0 );
+
+        this->queueDepth++;
+
+        // The job number tells a cancelled request apart from a later one that GL gave the same texture name
+        GLuint job = this->nextJob++;
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            this->jobs[textureID] = job;
+        }
+
+        this->decoders.Enqueue( [this, path, soilFlags, textureID, job]( )
+        {
+            this->decode( path, soilFlags, textureID, job );
+        } );
+
+        return textureID;
+    }
+
+    // Drops the pending load of a texture returned by Request( ), wherever it is (decoding, decoded or being streamed),
+    // so the texture can be deleted. Does nothing once the texture is resident.
+    void Cancel( GLuint textureID )
+    {
+        std::lock_guard<std::mutex> lock( this->mutex );
+        unordered_map<GLuint, GLuint>::iterator it = this->jobs.find( textureID );
+        if( it == this->jobs.end( ) )
+        {
+            return;
+        }
+        GLuint job = it->second;
+        this->jobs.erase( it );
+        this->queueDepth--;
+
+        if( NULL != this->active.pixels && job == this->active.job )
+        {
+            this->releaseImage( this->active );
+            this->active.pixels = NULL;
+            return;
+        }
+
+        for ( std::deque<DecodedImage>::iterator image = this->decoded.begin( ); image != this->decoded.end( ); ++image )
+        {
+            if( job == image->job )
+            {
+                this->releaseImage( *image );
+                this->decoded.erase( image );
+                return;
+            }
+        }
+
+        // Still decoding, the worker drops the image when it's done
+        this->cancelledJobs.insert( job );
+    }
+
+    // Advances the uploads. Must be called on the thread owning the GL context, typically once per frame.
+    void Update( )
+    {
+        size_t budget = this->bytesPerFrame;
+
+        while ( budget > 0 )
+        {
+            if( NULL == this->active.pixels && !this->beginUpload( ) )
+            {
+                break; // Nothing decoded yet
+            }
+
+            // Whole rows only; a frame always moves on by at least one, even when a row is wider than the budget
+            GLint rows = ( GLint )( budget / this->active.rowBytes );
+            if( 0 == rows )
+            {
+                if( budget < this->bytesPerFrame )
+                {
+                    break;
+                }
+                rows = 1;
+            }
+            rows = std::min( rows, this->active.height - this->active.nextRow );
+            this->uploadRows( rows );
+            budget -= std::min( budget, rows * this->active.rowBytes );
+
+            if( this->active.nextRow == this->active.height )
+            {
+                this->finishUpload( );
+            }
+        }
+    }
+
+    // Blocks until every requested texture is resident (loading screens, benchmarks)
+    void Flush( )
+    {
+        while ( this->queueDepth > 0 )
+        {
+            this->Update( );
+            if( NULL == this->active.pixels && this->queueDepth > 0 )
+            {
+                std::this_thread::yield( );
+            }
+        }
+    }
+
+    // Textures requested but not resident yet (decoding, waiting for upload or being streamed)
+    size_t GetQueueDepth( ) const
+    {
+        return this->queueDepth;
+    }
+
+    // Decoded pixel bytes held in memory waiting to reach the GPU
+    size_t GetBytesInFlight( ) const
+    {
+        return this->bytesInFlight;
+    }
+
+private:
+    struct DecodedImage
+    {
+        GLuint textureID;
+        GLuint job;
+        int width, height;
+        GLenum format;
+        unsigned char *pixels;
+        size_t size;
+    };
+
+    struct ActiveUpload : DecodedImage
+    {
+        size_t rowBytes;
+        GLint nextRow;      // First row not uploaded yet
+    };
+
+    /*  Loader Data  */
+    size_t bytesPerFrame;
+    GLuint pbo;                         // Staging buffer of the bands, orphaned for each one
+    GLuint nextJob;
+    std::atomic<size_t> queueDepth;
+    std::atomic<size_t> bytesInFlight;
+    std::atomic<bool> cancelled;
+    std::mutex mutex;
+    std::deque<DecodedImage> decoded;  // Guarded by mutex
+    unordered_map<GLuint, GLuint> jobs;    // Job of every texture not resident yet, guarded by mutex
+    unordered_set<GLuint> cancelledJobs;   // Jobs cancelled while decoding, guarded by mutex
+    ActiveUpload active;               // Only touched on the GL thread
+    ThreadPool decoders;               // Declared last so its workers are joined before the rest is destroyed
+
+    AsyncTextureLoader( const AsyncTextureLoader & );
+    AsyncTextureLoader &operator=( const AsyncTextureLoader & );
+
+    /*  Functions   */
+    // Runs on a worker thread
+    void decode( const string &path, int soilFlags, GLuint textureID, GLuint job )
+    {
+        if( this->cancelled )
+        {
+            return;
+        }
+
+        DecodedImage image;
+        int channels = 0;
+        image.textureID = textureID;
+        image.job = job;
+        image.pixels = SOIL_load_image( path.c_str( ), &image.width, &image.height, &channels, soilFlags );
+
+        if( NULL == image.pixels )
+        {
+            cout << "ERROR::TEXTURE_LOADER:: Failed to decode " << path << endl;
+            std::lock_guard<std::mutex> lock( this->mutex );
+            if( 0 == this->cancelledJobs.erase( job ) )
+            {
+                this->jobs.erase( textureID );
+                this->queueDepth--; // The placeholder stays bound
+            }
+            return;
+        }
+
+        if( SOIL_LOAD_AUTO != soilFlags )
+        {
+            channels = soilFlags;
+        }
+
+        const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        image.format = formats[std::min( std::max( channels, 1 ), 4 )];
+        image.size = ( size_t )image.width * image.height * std::min( std::max( channels, 1 ), 4 );
+
+        std::lock_guard<std::mutex> lock( this->mutex );
+        if( 0 != this->cancelledJobs.erase( job ) )
+        {
+            SOIL_free_image_data( image.pixels );
+            return;
+        }
+        this->bytesInFlight += image.size;
+        this->decoded.push_back( image );
+    }
+
+    // Frees the pixels of an image that won't be uploaded any more
+    void releaseImage( const DecodedImage &image )
+    {
+        SOIL_free_image_data( image.pixels );
+        this->bytesInFlight -= image.size;
+    }
+
+    // Takes the next decoded image and allocates the texture storage its rows are streamed into
+    bool beginUpload( )
+    {
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            if( this->decoded.empty( ) )
+            {
+                return false;
+            }
+            static_cast<DecodedImage &>( this->active ) = this->decoded.front( );
+            this->decoded.pop_front( );
+        }
+
+        this->active.rowBytes = this->active.size / this->active.height;
+        this->active.nextRow = 0;
+
+        // Replaces the placeholder, the image shows up as its bands arrive
+        GetStateTracker( ).BindTexture( 0, this->active.textureID );
+        glTexImage2D( GL_TEXTURE_2D, 0, this->active.format, this->active.width, this->active.height, 0, this->active.format, GL_UNSIGNED_BYTE, NULL );
+        GetStateTracker( ).BindTexture( 0, 0 );
+
+        if( 0 == this->pbo )
+        {
+            glGenBuffers( 1, &this->pbo );
+        }
+
+        return true;
+    }
+
+    // Copies the next rows of the active image into the pixel buffer and from there into the texture
+    void uploadRows( GLint rows )
+    {
+        size_t offset = this->active.nextRow * this->active.rowBytes;
+        size_t bytes = rows * this->active.rowBytes;
+
+        // Orphaning the buffer lets GL keep reading the previous band while this one is written
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, this->pbo );
+        glBufferData( GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW );
+        void *mapped = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+
+        // With a PBO bound the data pointer is an offset into the buffer
+        const GLvoid *source = ( GLvoid * )0;
+        if( NULL != mapped )
+        {
+            memcpy( mapped, this->active.pixels + offset, bytes );
+            glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+        }
+        else
+        {
+            // Couldn't map, upload the band straight from client memory instead
+            glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+            source = this->active.pixels + offset;
+        }
+
+        GetStateTracker( ).BindTexture( 0, this->active.textureID );
+        {
+            ScopedUnpackAlignment alignment;
+            glTexSubImage2D( GL_TEXTURE_2D, 0, 0, this->active.nextRow, this->active.width, rows, this->active.format, GL_UNSIGNED_BYTE, source );
+        }
+        GetStateTracker( ).BindTexture( 0, 0 );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+        this->active.nextRow += rows;
+    }
+
+    // Mipmaps the fully streamed image and lets the next one start
+    void finishUpload( )
+    {
+        GetStateTracker( ).BindTexture( 0, this->active.textureID );
+        glGenerateMipmap( GL_TEXTURE_2D );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+        GetStateTracker( ).BindTexture( 0, 0 );
+
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            this->jobs.erase( this->active.textureID );
+        }
+        this->releaseImage( this->active );
+        this->queueDepth--;
+
+        this->active.pixels = NULL;
+    }
+};
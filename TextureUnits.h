@@ -0,0 +1,12 @@
+#pragma once
+
+// Fixed texture units of the samplers that shaders read from the renderer rather than from a material. Shader points
+// the samplers of these names at their unit once after linking, so they never default to unit 0 next to a material's
+// sampler2D (drawing with two sampler types on one unit fails), whether or not the program ever gets them bound.
+
+// Cascade depth array of CascadedShadowMap, sampler "shadowMap"
+#define SHADOW_MAP_UNIT 12
+// Buffer textures of LightClusters, samplers "clusterLights", "clusterGrid" and "clusterIndices"
+#define CLUSTER_LIGHTS_UNIT 13
+#define CLUSTER_GRID_UNIT 14
+#define CLUSTER_INDICES_UNIT 15
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// Fixed size pool of worker threads consuming a FIFO job queue.
+class ThreadPool
+{
+public:
+    /*  Functions   */
+    // Constructor, 0 threads means one per hardware thread.
+    explicit ThreadPool( unsigned int threadCount = 0 ) : pending( 0 ), stopping( false )
+    {
+        if( 0 == threadCount )
+        {
+            threadCount = std::max( 1u, std::thread::hardware_concurrency( ) );
+        }
+
+        for ( unsigned int i = 0; i < threadCount; i++ )
+        {
+            this->workers.push_back( std::thread( &ThreadPool::workerLoop, this ) );
+        }
+    }
+
+    ~ThreadPool( )
+    {
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            this->stopping = true;
+        }
+        this->jobAvailable.notify_all( );
+
+        for ( size_t i = 0; i < this->workers.size( ); i++ )
+        {
+            this->workers[i].join( );
+        }
+    }
+
+    // Queues a job, it runs on whichever worker picks it first
+    void Enqueue( const std::function<void( )> &job )
+    {
+        {
+            std::lock_guard<std::mutex> lock( this->mutex );
+            this->jobs.push_back( job );
+            this->pending++;
+        }
+        this->jobAvailable.notify_one( );
+    }
+
+    // Blocks until every queued job has finished
+    void Wait( )
+    {
+        std::unique_lock<std::mutex> lock( this->mutex );
+        this->jobsDone.wait( lock, [this]( ) { return 0 == this->pending; } );
+    }
+
+    // Runs func( i ) for every i in [0, count) split in contiguous chunks, and waits for all of them.
+    // Each index is visited exactly once, so writing to slot i of a pre-sized array needs no locking.
+    void ParallelFor( size_t count, const std::function<void( size_t )> &func )
+    {
+        if( 0 == count )
+        {
+            return;
+        }
+
+        size_t chunks = std::min( count, this->workers.size( ) * 4 );
+        size_t chunkSize = ( count + chunks - 1 ) / chunks;
+
+        for ( size_t begin = 0; begin < count; begin += chunkSize )
+        {
+            size_t end = std::min( count, begin + chunkSize );
+            this->Enqueue( [begin, end, &func]( )
+            {
+                for ( size_t i = begin; i < end; i++ )
+                {
+                    func( i );
+                }
+            } );
+        }
+
+        this->Wait( );
+    }
+
+    unsigned int GetThreadCount( ) const
+    {
+        return ( unsigned int )this->workers.size( );
+    }
+
+private:
+    /*  Pool Data  */
+    std::vector<std::thread> workers;
+    std::deque<std::function<void( )> > jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobsDone;
+    size_t pending;  // Queued plus running jobs
+    bool stopping;
+
+    ThreadPool( const ThreadPool & );
+    ThreadPool &operator=( const ThreadPool & );
+
+    /*  Functions   */
+    void workerLoop( )
+    {
+        for ( ;; )
+        {
+            std::function<void( )> job;
+            {
+                std::unique_lock<std::mutex> lock( this->mutex );
+                this->jobAvailable.wait( lock, [this]( ) { return this->stopping || !this->jobs.empty( ); } );
+
+                if( this->jobs.empty( ) )
+                {
+                    return; // Stopping and nothing left to do
+                }
+
+                job = this->jobs.front( );
+                this->jobs.pop_front( );
+            }
+
+            job( );
+
+            {
+                std::lock_guard<std::mutex> lock( this->mutex );
+                this->pending--;
+                if( 0 == this->pending )
+                {
+                    this->jobsDone.notify_all( );
+                }
+            }
+        }
+    }
+};
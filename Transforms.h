@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+using namespace std;
+
+// What a model matrix may contain, so the normal matrix work can be skipped when it isn't needed
+enum TransformKind
+{
+    TRANSFORM_GENERAL = 0,      // Any invertible matrix: non uniform scale, shear, mirroring
+    TRANSFORM_UNIFORM_SCALE     // Rotation, translation and the same scale on every axis
+};
+
+// Matrix that transforms normals like model transforms positions, up to a positive scale (the shaders normalize).
+//
+// The usual transpose( inverse( model ) ) is the cofactor matrix divided by the determinant, and the cofactor matrix
+// of the columns a, b, c is just ( b x c, c x a, a x b ). Keeping only the determinant's sign leaves no inverse and
+// no division. A uniform scale and rotation is its own normal matrix up to scale, so it is only copied.
+inline glm::mat3 NormalMatrix( const glm::mat4 &model, TransformKind kind = TRANSFORM_GENERAL )
+{
+    glm::vec3 a( model[0] ), b( model[1] ), c( model[2] );
+    if( TRANSFORM_UNIFORM_SCALE == kind )
+    {
+        return glm::mat3( a, b, c );
+    }
+
+    glm::mat3 normal( glm::cross( b, c ), glm::cross( c, a ), glm::cross( a, b ) );
+    // A mirroring transform flips the cofactors, flip them back so normals keep pointing out
+    if( glm::dot( a, normal[0] ) < 0.0f )
+    {
+        normal = normal * -1.0f;
+    }
+    return normal;
+}
+
+// NormalMatrix( ) of count transforms, 4 at a time with SSE. kinds may be NULL (every transform general); groups of 4
+// uniform scale transforms are only copied.
+inline void ComputeNormalMatrices( const glm::mat4 *models, const GLubyte *kinds, size_t count, glm::mat3 *normals )
+{
+    size_t i = 0;
+#if FRUSTUM_SIMD_WIDTH > 1
+    const __m128 signMask = _mm_set1_ps( -0.0f );
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        if( NULL != kinds && TRANSFORM_UNIFORM_SCALE == kinds[i] && TRANSFORM_UNIFORM_SCALE == kinds[i + 1] &&
+            TRANSFORM_UNIFORM_SCALE == kinds[i + 2] && TRANSFORM_UNIFORM_SCALE == kinds[i + 3] )
+        {
+            for ( size_t j = i; j < i + 4; j++ )
+            {
+                normals[j] = NormalMatrix( models[j], TRANSFORM_UNIFORM_SCALE );
+            }
+            continue;
+        }
+
+        // Columns of the 4 matrices turned into x, y and z registers, one matrix per lane
+        __m128 column[3][4];
+        for ( GLuint c = 0; c < 3; c++ )
+        {
+            column[c][0] = _mm_loadu_ps( &models[i][c].x );
+            column[c][1] = _mm_loadu_ps( &models[i + 1][c].x );
+            column[c][2] = _mm_loadu_ps( &models[i + 2][c].x );
+            column[c][3] = _mm_loadu_ps( &models[i + 3][c].x );
+            _MM_TRANSPOSE4_PS( column[c][0], column[c][1], column[c][2], column[c][3] );
+        }
+        __m128 ax = column[0][0], ay = column[0][1], az = column[0][2];
+        __m128 bx = column[1][0], by = column[1][1], bz = column[1][2];
+        __m128 cx = column[2][0], cy = column[2][1], cz = column[2][2];
+
+        // b x c, c x a, a x b
+        __m128 n[3][4];
+        n[0][0] = _mm_sub_ps( _mm_mul_ps( by, cz ), _mm_mul_ps( bz, cy ) );
+        n[0][1] = _mm_sub_ps( _mm_mul_ps( bz, cx ), _mm_mul_ps( bx, cz ) );
+        n[0][2] = _mm_sub_ps( _mm_mul_ps( bx, cy ), _mm_mul_ps( by, cx ) );
+        n[1][0] = _mm_sub_ps( _mm_mul_ps( cy, az ), _mm_mul_ps( cz, ay ) );
+        n[1][1] = _mm_sub_ps( _mm_mul_ps( cz, ax ), _mm_mul_ps( cx, az ) );
+        n[1][2] = _mm_sub_ps( _mm_mul_ps( cx, ay ), _mm_mul_ps( cy, ax ) );
+        n[2][0] = _mm_sub_ps( _mm_mul_ps( ay, bz ), _mm_mul_ps( az, by ) );
+        n[2][1] = _mm_sub_ps( _mm_mul_ps( az, bx ), _mm_mul_ps( ax, bz ) );
+        n[2][2] = _mm_sub_ps( _mm_mul_ps( ax, by ), _mm_mul_ps( ay, bx ) );
+
+        // Flip the lanes with a negative determinant by xoring in its sign
+        __m128 determinant = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, n[0][0] ), _mm_mul_ps( ay, n[0][1] ) ), _mm_mul_ps( az, n[0][2] ) );
+        __m128 sign = _mm_and_ps( determinant, signMask );
+        for ( GLuint c = 0; c < 3; c++ )
+        {
+            n[c][0] = _mm_xor_ps( n[c][0], sign );
+            n[c][1] = _mm_xor_ps( n[c][1], sign );
+            n[c][2] = _mm_xor_ps( n[c][2], sign );
+            n[c][3] = _mm_setzero_ps( );
+            _MM_TRANSPOSE4_PS( n[c][0], n[c][1], n[c][2], n[c][3] );
+        }
+
+        // Back to one matrix per lane, 3 floats per column
+        for ( GLuint lane = 0; lane < 4; lane++ )
+        {
+            GLfloat packed[4];
+            for ( GLuint c = 0; c < 3; c++ )
+            {
+                _mm_storeu_ps( packed, n[c][lane] );
+                memcpy( &normals[i + lane][c].x, packed, 3 * sizeof( GLfloat ) );
+            }
+        }
+    }
+#endif
+    for ( ; i < count; i++ )
+    {
+        normals[i] = NormalMatrix( models[i], ( NULL != kinds ) ? ( TransformKind )kinds[i] : TRANSFORM_GENERAL );
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "Frustum.h"
+
+// Layout the vertices of a GeometryArena have on the GPU
+enum VertexFormat
+{
+    VERTEX_FORMAT_FLOAT = 0,    // Vertex as is, 32 bytes
+    VERTEX_FORMAT_COMPACT       // CompactVertex, 16 bytes
+};
+
+// Quantized vertex. Positions are 16 bit normalized within the bounds the arena was allocated with (the vertex shader
+// maps them back with positionOffset + positionScale * position), normals are signed normalized 10_10_10_2 and texture
+// coordinates half floats. All three are decoded by the vertex fetch hardware, GL 3.3 core has every one of them.
+struct CompactVertex
+{
+    GLushort Position[4];   // xyz, w is padding to keep the normal aligned
+    GLuint Normal;          // GL_INT_2_10_10_10_REV
+    GLushort TexCoords[2];  // GL_HALF_FLOAT
+};
+
+inline GLsizei GetVertexSize( VertexFormat format )
+{
+    return ( VERTEX_FORMAT_COMPACT == format ) ? sizeof( CompactVertex ) : sizeof( Vertex );
+}
+
+// Nearest 16 bit normalized value of a [0, 1] float
+inline GLushort PackUnorm16( GLfloat value )
+{
+    return ( GLushort )( std::min( std::max( value, 0.0f ), 1.0f ) * 65535.0f + 0.5f );
+}
+
+// Normal as signed normalized 10_10_10_2, x in the low bits and w left at 0
+inline GLuint PackNormal( const glm::vec3 &normal )
+{
+    GLfloat length = glm::length( normal );
+    glm::vec3 n = ( length > 0.0f ) ? normal / length : normal;
+
+    GLuint packed = 0;
+    for ( int i = 0; i < 3; i++ )
+    {
+        GLint component = ( GLint )std::floor( std::min( std::max( n[i], -1.0f ), 1.0f ) * 511.0f + 0.5f );
+        packed |= ( ( GLuint )component & 0x3FF ) << ( i * 10 );
+    }
+
+    return packed;
+}
+
+// IEEE half float of a float, rounded to nearest. Out of range values clamp to the largest half instead of
+// becoming infinite, NaN stays NaN.
+inline GLushort PackHalf( GLfloat value )
+{
+    GLuint bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+
+    GLuint sign = ( bits >> 16 ) & 0x8000;
+    GLuint mantissa = bits & 0x7FFFFF;
+    GLint exponent = ( GLint )( ( bits >> 23 ) & 0xFF ) - 127 + 15;
+
+    if( 0xFF == ( ( bits >> 23 ) & 0xFF ) )
+    {
+        return ( GLushort )( sign | ( ( 0 != mantissa ) ? 0x7E00 : 0x7BFF ) );
+    }
+    if( exponent <= 0 )
+    {
+        // Denormal half, or zero when even that is too small
+        if( exponent < -10 )
+        {
+            return ( GLushort )sign;
+        }
+        mantissa |= 0x800000;
+        GLuint shift = ( GLuint )( 14 - exponent );
+        GLuint half = ( mantissa >> shift ) + ( ( mantissa >> ( shift - 1 ) ) & 1 );
+        return ( GLushort )( sign | half );
+    }
+
+    // Rounding may carry into the exponent, which is still the right result
+    GLuint half = ( ( GLuint )exponent << 10 ) + ( mantissa >> 13 ) + ( ( mantissa >> 12 ) & 1 );
+    return ( GLushort )( sign | std::min( half, ( GLuint )0x7BFF ) );
+}
+
+// Compresses a vertex whose position lies within bounds
+inline CompactVertex CompressVertex( const Vertex &vertex, const AABB &bounds )
+{
+    CompactVertex compact;
+    glm::vec3 size = bounds.Max - bounds.Min;
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        compact.Position[i] = ( size[i] > 0.0f ) ? PackUnorm16( ( vertex.Position[i] - bounds.Min[i] ) / size[i] ) : 0;
+    }
+    compact.Position[3] = 0;
+    compact.Normal = PackNormal( vertex.Normal );
+    compact.TexCoords[0] = PackHalf( vertex.TexCoords.x );
+    compact.TexCoords[1] = PackHalf( vertex.TexCoords.y );
+
+    return compact;
+}
@@ -24,6 +24,7 @@
 
 //Other includes
 #include "Shader.h"
+#include "TextureCache.h"
 
 //Define window dimension width and height
 const GLint WIDTH = 800, HEIGHT = 600;
@@ -82,129 +83,116 @@ int main()
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	//Build and compile shader program 
-	Shader ourShader("core.vs", "core.frag");
+	//Everything owning GL objects lives in this block, so it is destroyed while the context still exists
+	{
+		//Build and compile shader program 
+		Shader ourShader("core.vs", "core.frag");
 
 
-	//=================================================  TEMPLATE =============================================================
+		//=================================================  TEMPLATE =============================================================
 
-	//Set up vertex data (buffer(s)) and attribute pointer
+		//Set up vertex data (buffer(s)) and attribute pointer
 
-	GLfloat vertices[] =
-	{
-		//Pointers of rectangule
-		// Positions          // Colors           // Texture Coords
-		0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // Top Right
-		0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // Bottom Right
-		-0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // Bottom Left
-		-0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // Top Left
-	};
-
-	GLuint indices[] =
-	{
-		// Note that we start from 0!
-		0, 1, 3, // First Triangle
-		1, 2, 3  // Second Triangle
-	};
-
-	GLuint VBO, VAO, EBO; //Create the (VBO) Vertexs Buffer Object
-						  //Create the (VAO) Vertexs Array Object
-						  //Create the (EBO) Elements Buffer Object
-
-	//Generate vertex array and buffers of the objects
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	//To do Bind of vertex array
-	glBindVertexArray(VAO);
-
-	//Bind buffers
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	//Positions attributes in the vertex data
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-	//Color attributes in the vertex data
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-	//Texture attributes in the vertex data
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	glBindVertexArray(0);
-
-	//Load and create texture
-	GLuint texture;
-
-	int width, height;
-
-	// ===================
-	// Texture
-	// ===================
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	//Set our parameters of texture
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	//Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//Load, create texture and generate mipmap
-	unsigned char *image = SOIL_load_image("wall.jpg", &width, &height, 0, SOIL_LOAD_RGBA);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	//Game Loop
-	while (!glfwWindowShouldClose(window))
-	{
-		// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
-		glfwPollEvents();
+		GLfloat vertices[] =
+		{
+			//Pointers of rectangule
+			// Positions          // Colors           // Texture Coords
+			0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // Top Right
+			0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // Bottom Right
+			-0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // Bottom Left
+			-0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // Top Left
+		};
 
-		//Render
-		//Clear color buffer
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
+		GLuint indices[] =
+		{
+			// Note that we start from 0!
+			0, 1, 3, // First Triangle
+			1, 2, 3  // Second Triangle
+		};
 
-		//Draw the triangle
-		ourShader.use(); // Use the shader 
+		GLuint VBO, VAO, EBO; //Create the (VBO) Vertexs Buffer Object
+							  //Create the (VAO) Vertexs Array Object
+							  //Create the (EBO) Elements Buffer Object
 
-		glm::mat4 transform; //Apply some transformations
-		transform = glm::translate(transform, glm::vec3(0.5f, 0.5f, 0.0f)); // Translation
-		transform = glm::scale(transform, glm::vec3(0.5, 0.5, 0.5)); //Scale
-		transform = glm::rotate(transform, (GLfloat)glfwGetTime() * -5.0f, glm::vec3(0.0f, 0.0f, 1.0f)); //Rotation
+		//Generate vertex array and buffers of the objects
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
 
-		GLint transformLocation = glGetUniformLocation(ourShader.ID, "transform");
-		glUniformMatrix4fv(transformLocation, 1, GL_FALSE, glm::value_ptr(transform));
+		//To do Bind of vertex array
+		glBindVertexArray(VAO);
 
-		//Enable the texture and after apply 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glUniform1i(glGetUniformLocation(ourShader.ID, "ourTexture"), 0);
+		//Bind buffers
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+		//Positions attributes in the vertex data
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		//Color attributes in the vertex data
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(1);
+		//Texture attributes in the vertex data
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(2);
 
-		//Draw container
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		glBindVertexArray(0);
 
-		// render OpenGL here
+		// ===================
+		// Texture
+		// ===================
+		//Load, create texture and generate mipmap through the shared texture cache
+		GLuint texture = TextureCache::Instance().Acquire("wall.jpg", SOIL_LOAD_RGBA);
+
+		//Game Loop
+		while (!glfwWindowShouldClose(window))
+		{
+			// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
+			glfwPollEvents();
+
+			//Render
+			//Clear color buffer
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			//Draw the triangle
+			ourShader.use(); // Use the shader 
+
+			glm::mat4 transform; //Apply some transformations
+			transform = glm::translate(transform, glm::vec3(0.5f, 0.5f, 0.0f)); // Translation
+			transform = glm::scale(transform, glm::vec3(0.5, 0.5, 0.5)); //Scale
+			transform = glm::rotate(transform, (GLfloat)glfwGetTime() * -5.0f, glm::vec3(0.0f, 0.0f, 1.0f)); //Rotation
+
+			GLint transformLocation = glGetUniformLocation(ourShader.ID, "transform");
+			glUniformMatrix4fv(transformLocation, 1, GL_FALSE, glm::value_ptr(transform));
+
+			//Enable the texture and after apply 
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glUniform1i(glGetUniformLocation(ourShader.ID, "ourTexture"), 0);
+
+			//Draw container
+			glBindVertexArray(VAO);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			glBindVertexArray(0);
+
+			// render OpenGL here
 		
 
-		//Swap screen buffers
-		glfwSwapBuffers(window);
+			//Swap screen buffers
+			glfwSwapBuffers(window);
 
-	}
+		}
 
-	// Properly de-allocate all resources once they've outlived their purpose
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+		// Properly de-allocate all resources once they've outlived their purpose
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		TextureCache::Instance().Release(texture);
+	}
 
 	// Terminate GLFW, clearing any resources allocated by GLFW.
 	glfwTerminate();
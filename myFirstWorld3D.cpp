@@ -24,6 +24,8 @@
 
 //Other includes
 #include "Shader.h"
+#include "TextureCache.h"
+#include "Headless.h"
 
 //Define window dimension width and height
 const GLint WIDTH = 800, HEIGHT = 600;
@@ -40,14 +42,17 @@ void configWindow()
 
 
 
-int main()
+int main(int argc, char **argv)
 {
 	//=================================================  TEMPLATE =============================================================
+	//"--headless N" renders N scripted frames offscreen and prints their timings
+	Headless headless(argc, argv);
 
 	//Initialize GLFW
 	glfwInit();
 
 	configWindow();
+	headless.ConfigureWindow();
 
 	//Create a GLFW window that we can use for GLFW's functions
 	GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Transformation", nullptr, nullptr);
@@ -83,262 +88,256 @@ int main()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_DEPTH_TEST);
 
-	//Build and compile shader program 
-	Shader ourShader("core.vs", "core.frag");
-	Shader ourShader2("core.vs", "core.frag");
-	//=================================================  TEMPLATE =============================================================
+	if (!headless.Begin(screenWidth, screenHeight))
+	{
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
 
-	//Set up vertex data (buffer(s)) and attribute pointer
+	//Everything owning GL objects lives in this block, so it is destroyed while the context still exists
+	{
+		//Build and compile shader program 
+		Shader ourShader("core.vs", "core.frag");
+		Shader ourShader2("core.vs", "core.frag");
+		//=================================================  TEMPLATE =============================================================
+
+		//Set up vertex data (buffer(s)) and attribute pointer
 
-	//Plane
+		//Plane
 	
-	GLfloat verticesPlane[] =
-	{
-		//Pointers of rectangule
-		// Positions          // Colors           // Texture Coords
-		0.8f,  0.8f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // Top Right
-		0.8f, -0.8f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // Bottom Right
-		-0.8f, -0.8f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // Bottom Left
-		-0.8f,  0.8f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // Top Left
-	};
+		GLfloat verticesPlane[] =
+		{
+			//Pointers of rectangule
+			// Positions          // Colors           // Texture Coords
+			0.8f,  0.8f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // Top Right
+			0.8f, -0.8f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // Bottom Right
+			-0.8f, -0.8f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // Bottom Left
+			-0.8f,  0.8f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // Top Left
+		};
 	
 
-	//Cube vertices
-	GLfloat vertices[] =
-	{
-		-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-		0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-		0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-		0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-		-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-		0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-		0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-		0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-		-0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-		-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-		-0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-		-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-		0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-		0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-		0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-		0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-		-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-		0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-		0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-		-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-		-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-		0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-		0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-		0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-		-0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-		-0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-	};
-
-	GLuint indices[] =
-	{
-		// Note that we start from 0!
-		0, 1, 3, // First Triangle
-		1, 2, 3  // Second Triangle
-	};
-
-	GLuint VBO[2], VAO[2], EBO; //Create the (VBO) Vertexs Buffer Object
-						  //Create the (VAO) Vertexs Array Object
-						  //Create the (EBO) Elements Buffer Object
-
-						  //Generate vertex array and buffers of the objects
-	glGenVertexArrays(2, VAO);
-	glGenBuffers(2, VBO);
-	glGenBuffers(1, &EBO);
-
-	//To do Bind of vertex array
-	glBindVertexArray(VAO[0]);
-
-	//Bind buffers
-	glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		//Cube vertices
+		GLfloat vertices[] =
+		{
+			-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
+			0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
+			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+			-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
+			-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
+
+			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+			0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+			0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
+			0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
+			-0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
+			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+
+			-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+			-0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+			-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+
+			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+			0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+			0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+			0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+
+			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+			0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
+			0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+			0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+
+			-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
+			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+			-0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
+			-0.5f,  0.5f, -0.5f,  0.0f, 1.0f
+		};
+
+		GLuint indices[] =
+		{
+			// Note that we start from 0!
+			0, 1, 3, // First Triangle
+			1, 2, 3  // Second Triangle
+		};
+
+		GLuint VBO[2], VAO[2], EBO; //Create the (VBO) Vertexs Buffer Object
+							  //Create the (VAO) Vertexs Array Object
+							  //Create the (EBO) Elements Buffer Object
+
+							  //Generate vertex array and buffers of the objects
+		glGenVertexArrays(2, VAO);
+		glGenBuffers(2, VBO);
+		glGenBuffers(1, &EBO);
+
+		//To do Bind of vertex array
+		glBindVertexArray(VAO[0]);
+
+		//Bind buffers
+		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	
 	
 			
-	// position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
-	glEnableVertexAttribArray(0);
-	// texture coord attribute
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
+		// position attribute
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+		glEnableVertexAttribArray(0);
+		// texture coord attribute
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(2);
 	
-	glBindVertexArray(0);
+		glBindVertexArray(0);
 
-	//To do Bind of vertex array
-	glBindVertexArray(VAO[1]);
+		//To do Bind of vertex array
+		glBindVertexArray(VAO[1]);
 
-	//Bind buffers
-	glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verticesPlane), verticesPlane, GL_STATIC_DRAW);
+		//Bind buffers
+		glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(verticesPlane), verticesPlane, GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 	
-	//Positions attributes in the vertex data
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-	//Color attributes in the vertex data
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-	//Texture attributes in the vertex data
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
+		//Positions attributes in the vertex data
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		//Color attributes in the vertex data
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(1);
+		//Texture attributes in the vertex data
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(2);
 	
-	glBindVertexArray(0);
-
-
-	//Load and create texture
-	GLuint texture, texture2;
-
-	int width, height;
-
-	// ===================
-	// Texture
-	// ===================
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	//Set our parameters of texture
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	//Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//Load, create texture and generate mipmap
-	unsigned char *image = SOIL_load_image("wood.jpg", &width, &height, 0, SOIL_LOAD_RGBA);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// ===================
-	// Texture 2
-	// ===================
-	glGenTextures(1, &texture2);
-	glBindTexture(GL_TEXTURE_2D, texture2);
-	//Set our parameters of texture
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	//Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//Load, create texture and generate mipmap
-	unsigned char *image2 = SOIL_load_image("grass.jpg", &width, &height, 0, SOIL_LOAD_RGBA);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image2);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image2);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-
-	//ourShader.use();
-	//ourShader.setInt("texture1", 0);
-	//ourShader.setInt("texture2", 1);
-
-
-	//Game Loop
-	while (!glfwWindowShouldClose(window))
-	{
-		// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
-		glfwPollEvents();
+		glBindVertexArray(0);
+
+
+		// ===================
+		// Textures
+		// ===================
+		//Load, create texture and generate mipmap through the shared texture cache
+		GLuint texture = TextureCache::Instance().Acquire("wood.jpg", SOIL_LOAD_RGBA);
+		GLuint texture2 = TextureCache::Instance().Acquire("grass.jpg", SOIL_LOAD_RGBA);
 
-		//Render
-		//Clear color buffer
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		//glClear(GL_COLOR_BUFFER_BIT);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		//Enable the texture1 and after apply 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glUniform1i(glGetUniformLocation(ourShader.ID, "ourTexture1"), 0);
+		//ourShader.use();
+		//ourShader.setInt("texture1", 0);
+		//ourShader.setInt("texture2", 1);
+
+
+		//View and projection are shared through the frame uniform buffer (Shader3D/core.vs)
+		FrameUniforms frameUniforms;
+
+		//Camera of the headless runs, it starts where the fixed view is
+		CameraPath cameraPath(glm::vec3(0.0f), 3.0f, 0.0f);
+
+		//Game Loop
+		while (headless.NextFrame(window))
+		{
+			headless.GetProfiler().BeginStage("input");
+			// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
+			glfwPollEvents();
+
+			headless.GetProfiler().BeginStage("clear");
+			//Render
+			//Clear color buffer
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			//glClear(GL_COLOR_BUFFER_BIT);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			headless.GetProfiler().BeginStage("update");
+			//Enable the texture1 and after apply 
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glUniform1i(glGetUniformLocation(ourShader.ID, "ourTexture1"), 0);
 
 		
-		//Draw the triangle
-		ourShader.use(); // Use the shader 
-
-		glm::mat4 model; //Apply some transformations
-		model = glm::rotate(model, glm::radians(25.0f), glm::vec3(1.0f, 0.0f, 0.0f)); //Rotation
-		model = glm::rotate(model, (GLfloat)glfwGetTime() * 1.0f, glm::vec3(0.0f, 1.0f, 0.0f)); //Rotation
-		model = glm::scale(model, glm::vec3(0.8f));
-		glm::mat4 view;
-		view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
-
-		glm::mat4 projection;
-		projection = glm::perspective(glm::radians(45.0f), (GLfloat)screenWidth / (GLfloat)screenHeight, 0.1f, 100.0f);
-
-		// Get their uniform location
-		GLint modelLoc = glGetUniformLocation(ourShader.ID, "model");
-		GLint viewLoc = glGetUniformLocation(ourShader.ID, "view");
-		GLint projlLoc = glGetUniformLocation(ourShader.ID, "projection");
-		// Pass them to the shaders
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(projlLoc, 1, GL_FALSE, glm::value_ptr(projection));
+			//Draw the triangle
+			ourShader.use(); // Use the shader 
+
+			glm::mat4 model; //Apply some transformations
+			model = glm::rotate(model, glm::radians(25.0f), glm::vec3(1.0f, 0.0f, 0.0f)); //Rotation
+			model = glm::rotate(model, (GLfloat)glfwGetTime() * 1.0f, glm::vec3(0.0f, 1.0f, 0.0f)); //Rotation
+			model = glm::scale(model, glm::vec3(0.8f));
+			glm::mat4 view;
+			view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
+
+			glm::mat4 projection;
+			projection = glm::perspective(glm::radians(45.0f), (GLfloat)screenWidth / (GLfloat)screenHeight, 0.1f, 100.0f);
+
+			glm::vec3 viewPos(0.0f, 0.0f, 3.0f);
+			if (headless.IsEnabled())
+			{
+				view = cameraPath.GetViewMatrix(headless.GetTime());
+				viewPos = cameraPath.GetPosition(headless.GetTime());
+			}
+
+			frameUniforms.Update(view, projection, viewPos);
+
+			// Get their uniform location
+			GLint modelLoc = glGetUniformLocation(ourShader.ID, "model");
+			// Pass them to the shaders
+			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 
 		
-		//Draw container
-		glBindVertexArray(VAO[0]);
-		//glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+			headless.GetProfiler().BeginStage("draw");
+			//Draw container
+			glBindVertexArray(VAO[0]);
+			//glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
 		
-		// Plane
-		//Enable the texture2 and after apply 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, texture2);
-		glUniform1i(glGetUniformLocation(ourShader.ID, "ourTexture1"), 1);
-
-		/*
-		//Draw the triangle
-		ourShader2.use(); // Use the shader 
-				*/
-		glm::mat4 model2;
-		model2 = glm::rotate(model2, glm::radians(500.0f), glm::vec3(1.0f, 0.0f, 0.0f)); //Rotation
-		model2 = glm::translate(model2, glm::vec3(0.0f, 0.0f, 1.0f));
-		model2 = glm::scale(model2, glm::vec3(2.5f));
+			// Plane
+			//Enable the texture2 and after apply 
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, texture2);
+			glUniform1i(glGetUniformLocation(ourShader.ID, "ourTexture1"), 1);
+
+			/*
+			//Draw the triangle
+			ourShader2.use(); // Use the shader 
+					*/
+			glm::mat4 model2;
+			model2 = glm::rotate(model2, glm::radians(500.0f), glm::vec3(1.0f, 0.0f, 0.0f)); //Rotation
+			model2 = glm::translate(model2, glm::vec3(0.0f, 0.0f, 1.0f));
+			model2 = glm::scale(model2, glm::vec3(2.5f));
 		
-		// Get their uniform location
-		GLint modelLoc2 = glGetUniformLocation(ourShader.ID, "model");
+			// Get their uniform location
+			GLint modelLoc2 = glGetUniformLocation(ourShader.ID, "model");
 		
-		// Pass them to the shaders
-		glUniformMatrix4fv(modelLoc2, 1, GL_FALSE, glm::value_ptr(model2));
+			// Pass them to the shaders
+			glUniformMatrix4fv(modelLoc2, 1, GL_FALSE, glm::value_ptr(model2));
 		
-		//Draw container
-		glBindVertexArray(VAO[1]);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		//glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+			//Draw container
+			glBindVertexArray(VAO[1]);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			//glDrawArrays(GL_TRIANGLES, 0, 36);
+			glBindVertexArray(0);
 		
 
-		// render OpenGL here
+			// render OpenGL here
 
 
-		//Swap screen buffers
-		glfwSwapBuffers(window);
+			//Swap screen buffers
+			headless.EndFrame(window);
 
-	}
+		}
 
-	// Properly de-allocate all resources once they've outlived their purpose
-	glDeleteVertexArrays(2, VAO);
-	glDeleteBuffers(2, VBO);
-	glDeleteBuffers(1, &EBO);
+		headless.Finish("myFirstWorld3D");
+
+		// Properly de-allocate all resources once they've outlived their purpose
+		glDeleteVertexArrays(2, VAO);
+		glDeleteBuffers(2, VBO);
+		glDeleteBuffers(1, &EBO);
+		TextureCache::Instance().Release(texture);
+		TextureCache::Instance().Release(texture2);
+	}
 
 	// Terminate GLFW, clearing any resources allocated by GLFW.
 	glfwTerminate();
@@ -5,6 +5,8 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <memory>
 
 //GLEW
 #include <GL/glew.h>
@@ -25,6 +27,8 @@
 #include "Shader.h"
 #include "Model.h"
 #include "Camera.h"
+#include "Headless.h"
+#include "DeferredRenderer.h"
 
 //Define window dimension width and height
 const GLint WIDTH = 800, HEIGHT = 600;
@@ -57,13 +61,17 @@ void configWindow()
 }
 
 
-int main()
+int main(int argc, char **argv)
 {
 	//=================================================  TEMPLATE =============================================================
+	//"--headless N" renders N scripted frames offscreen and prints their timings
+	Headless headless(argc, argv);
+
 	//Initialize GLFW
 	glfwInit();
 
 	configWindow();
+	headless.ConfigureWindow();
 
 	//Create a GLFW window that we can use for GLFW's functions
 	GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Mundo", nullptr, nullptr);
@@ -104,57 +112,148 @@ int main()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_DEPTH_TEST);
 
-	// Setup and compile our shaders
-	Shader shader("res/shaders/modelLoading.vs", "res/shaders/modelLoading.frag");
+	if (!headless.Begin(SCREEN_WIDTH, SCREEN_HEIGHT))
+	{
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
 
-	// Load models
-	Model Model("res/models/obj_Grass/untitled.obj");
+	//Everything owning GL objects lives in this block, so it is destroyed while the context still exists
+	{
+		// Setup and compile our shaders
+		Shader shader("res/shaders/modelLoading.vs", "res/shaders/modelLoading.frag");
 
-	// Draw in wireframe
-	//glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+		//"--deferred" shades the model through a G-buffer instead of modelLoading.frag, to compare the cost of both paths
+		bool deferred = false;
+		for (int i = 1; i < argc; i++)
+		{
+			deferred = deferred || (0 == strcmp(argv[i], "--deferred"));
+		}
+		std::unique_ptr<Shader> gBufferShader, frameLightShader;
+		std::unique_ptr<DeferredRenderer> deferredRenderer;
+		if (deferred)
+		{
+			gBufferShader.reset(new Shader("res/shaders/modelLoading.vs", "res/shaders/gbuffer.frag"));
+			frameLightShader.reset(new Shader("res/shaders/deferred.vs", "res/shaders/deferredFrameLight.frag"));
+			deferredRenderer.reset(new DeferredRenderer(SCREEN_WIDTH, SCREEN_HEIGHT));
+		}
 
+		// Load models, their textures are decoded and uploaded in the background
+		AsyncTextureLoader textureLoader;
+		ModelLoadOptions loadOptions;
+		loadOptions.textureLoader = &textureLoader;
+		Model Model("res/models/obj_Grass/untitled.obj", loadOptions);
+		std::cout << "Model: " << Model.GetMemoryReport() << std::endl;
 
-	//Create a projection matrix 
-	//glm::mat4 projection = glm::perspective(camera.GetZoom(), (GLfloat)SCREEN_WIDTH / (GLfloat)SCREEN_HEIGHT, 0.1f, 1000.0f);
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)SCREEN_WIDTH / (GLfloat)SCREEN_HEIGHT, 0.1f, 1000.0f);
+		//Benchmark runs start with every texture resident so all of them render the same frames
+		if (headless.IsEnabled())
+		{
+			textureLoader.Flush();
+		}
 
-	//Game Loop
-	while (!glfwWindowShouldClose(window))
-	{
-		//lightPos.x -= 0.005f;
-		//lightPos.z -= 0.005f;
+		TextureCache::Stats textureStats = TextureCache::Instance().GetStats();
+		std::cout << "Texture cache: " << textureStats.hits << " hits, " << textureStats.misses << " misses, "
+			<< textureStats.residentTextures << " textures (" << textureStats.residentBytes / 1024 << " KB)" << std::endl;
 
-		GLfloat currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		// Draw in wireframe
+		//glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
 
-		// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
-		glfwPollEvents();
-		DoMovement();
 
-		//Render
-		//Clear color buffer
-		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		//Create a projection matrix 
+		//glm::mat4 projection = glm::perspective(camera.GetZoom(), (GLfloat)SCREEN_WIDTH / (GLfloat)SCREEN_HEIGHT, 0.1f, 1000.0f);
+		camera.SetProjection((GLfloat)SCREEN_WIDTH / (GLfloat)SCREEN_HEIGHT);
+		glm::mat4 projection = camera.GetProjectionMatrix();
 
-		shader.use();
+		// View and projection reach the shader through the frame uniform buffer
+		FrameUniforms frameUniforms;
 
-		//glm::mat4 view = camera.GetviewMatrix();
-		glm::mat4 view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
-		
-		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+		// Draws are queued every frame and issued sorted by shader, textures and VAO
+		RenderQueue renderQueue;
+
+		//Camera of the headless runs, it starts where the fixed view is
+		CameraPath cameraPath(glm::vec3(0.0f), 3.0f, 0.0f);
 
-		// Draw the loaded model
-		glm::mat4 model;
-		model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // Translate it down a bit so it's at the center of the scene
-		model = glm::scale(model, glm::vec3(0.008f, 0.008f, 0.008f));	// It's a bit too big for our scene, so scale it down
-		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
-		Model.Draw(shader);
+		//Game Loop
+		while (headless.NextFrame(window))
+		{
+			headless.GetProfiler().BeginStage("input");
+
+			//lightPos.x -= 0.005f;
+			//lightPos.z -= 0.005f;
+
+			GLfloat currentFrame = glfwGetTime();
+			deltaTime = currentFrame - lastFrame;
+			lastFrame = currentFrame;
+
+			// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
+			glfwPollEvents();
+			DoMovement();
+
+			// Move the pending textures a bit closer to the GPU
+			headless.GetProfiler().BeginStage("textures");
+			textureLoader.Update();
+
+			headless.GetProfiler().BeginStage("clear");
+			//Render
+			//Clear color buffer
+			glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			headless.GetProfiler().BeginStage("update");
+			//glm::mat4 view = camera.GetviewMatrix();
+			glm::mat4 view = glm::translate(glm::mat4(), glm::vec3(0.0f, 0.0f, -3.0f));
+			glm::vec3 viewPos(0.0f, 0.0f, 3.0f);
+			if (headless.IsEnabled())
+			{
+				view = cameraPath.GetViewMatrix(headless.GetTime());
+				viewPos = cameraPath.GetPosition(headless.GetTime());
+			}
+			//The model is lit by a light at the camera
+			frameUniforms.Update(view, projection, viewPos, viewPos);
+
+			headless.GetProfiler().BeginStage("draw");
+			GetDrawStats() = DrawStats();
+			GetStateChangeStats() = StateChangeStats();
+			renderQueue.Begin(viewPos);
+
+			// Draw the loaded model
+			glm::mat4 model;
+			model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // Translate it down a bit so it's at the center of the scene
+			model = glm::scale(model, glm::vec3(0.008f, 0.008f, 0.008f));	// It's a bit too big for our scene, so scale it down
+
+			// Only the meshes inside the view volume are submitted
+			Frustum frustum(projection * view * model);
+			if (deferred)
+			{
+				deferredRenderer->BeginGeometryPass(glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+			}
+			Model.Submit(renderQueue, deferred ? *gBufferShader : shader, model, frustum, TRANSFORM_UNIFORM_SCALE);
+			renderQueue.Flush();
+			if (deferred)
+			{
+				deferredRenderer->ApplyFrameLight(*frameLightShader);
+				deferredRenderer->Resolve();
+			}
+
+			//Report the culling result about once a second
+			if (!headless.IsEnabled() && (GLint)currentFrame != (GLint)(currentFrame - deltaTime))
+			{
+				CullStats cullStats = Model.GetCullStats();
+				std::cout << "Meshes: " << cullStats.visible << " visible, " << cullStats.culled << " culled, "
+					<< GetDrawStats().vaoBinds << " VAO binds, " << GetDrawStats().drawCalls << " draws, "
+					<< Model.GetGLObjectCount() << " geometry GL objects (" << 3 * (cullStats.visible + cullStats.culled) << " with per-mesh buffers)" << std::endl;
+				StateChangeStats stateStats = GetStateChangeStats();
+				std::cout << "State changes (issued/elided): programs " << stateStats.programChanges << "/" << stateStats.programsElided
+					<< ", textures " << stateStats.textureChanges << "/" << stateStats.texturesElided
+					<< ", VAOs " << stateStats.vaoChanges << "/" << stateStats.vaosElided << std::endl;
+			}
+
+			//Swap screen buffers
+			headless.EndFrame(window);
 
-		//Swap screen buffers
-		glfwSwapBuffers(window);
+		}
 
+		headless.Finish(deferred ? "world3DPlus deferred" : "world3DPlus");
 	}
 
 	// Terminate GLFW, clearing any resources allocated by GLFW.